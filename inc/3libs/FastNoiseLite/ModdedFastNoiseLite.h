@@ -56,6 +56,16 @@
 typedef float FNLfloat;
 //typedef double FNLfloat;
 
+// Vector units of the batched Perlin noise, the PS2 toolchain has none and
+// evaluates the batches one point at a time
+#if defined(FNL_IMPL) && defined(__SSE2__)
+#include <emmintrin.h>
+#define FNL_SIMD_SSE2
+#elif defined(FNL_IMPL) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FNL_SIMD_NEON
+#endif
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -237,6 +247,21 @@ float fnlGetNoise2D(fnl_state *state, FNLfloat x, FNLfloat y);
  */
 float fnlGetNoise3D(fnl_state *state, FNLfloat x, FNLfloat y, FNLfloat z);
 
+/**
+ * 2D noise at count positions, out[i] is the noise at (x[i], y[i]).
+ * @note Perlin noise without fractal is evaluated 4 points at a time with
+ * SSE2 or NEON, matching fnlGetNoise2D within float rounding. Other settings
+ * and targets without them call fnlGetNoise2D per point.
+ */
+void fnlGetNoise2DRow(fnl_state *state, const FNLfloat *x, const FNLfloat *y, int count, float *out);
+
+/**
+ * 3D noise at count positions, out[i] is the noise at (x[i], y[i], z[i]).
+ * @note Batched like fnlGetNoise2DRow, Perlin noise without fractal or 3D
+ * rotation is vectorized.
+ */
+void fnlGetNoise3DRow(fnl_state *state, const FNLfloat *x, const FNLfloat *y, const FNLfloat *z, int count, float *out);
+
 /**
  * 2D warps the input position using current domain warp settings.
  * 
@@ -2392,6 +2417,255 @@ float fnlGetNoise3D(fnl_state *state, FNLfloat x, FNLfloat y, FNLfloat z)
     }
 }
 
+// Batched Perlin Noise
+
+// Can the state noise be batched straight into the Perlin kernel
+static inline bool _fnlIsSinglePerlin(fnl_state *state)
+{
+    return state->noise_type == FNL_NOISE_PERLIN &&
+           state->fractal_type != FNL_FRACTAL_FBM &&
+           state->fractal_type != FNL_FRACTAL_RIDGED &&
+           state->fractal_type != FNL_FRACTAL_PINGPONG;
+}
+
+#if defined(FNL_SIMD_SSE2) || defined(FNL_SIMD_NEON)
+#define FNL_SIMD
+
+// 4 lane vectors, every operation matches the scalar one of the kernels
+
+#if defined(FNL_SIMD_SSE2)
+typedef __m128 _fnlV4f;
+typedef __m128i _fnlV4i;
+
+static inline _fnlV4f _fnlV4Load(const float *p) { return _mm_loadu_ps(p); }
+static inline void _fnlV4Store(float *p, _fnlV4f a) { _mm_storeu_ps(p, a); }
+static inline _fnlV4f _fnlV4Set(float f) { return _mm_set1_ps(f); }
+static inline _fnlV4f _fnlV4Add(_fnlV4f a, _fnlV4f b) { return _mm_add_ps(a, b); }
+static inline _fnlV4f _fnlV4Sub(_fnlV4f a, _fnlV4f b) { return _mm_sub_ps(a, b); }
+static inline _fnlV4f _fnlV4Mul(_fnlV4f a, _fnlV4f b) { return _mm_mul_ps(a, b); }
+static inline _fnlV4f _fnlV4ToFloat(_fnlV4i a) { return _mm_cvtepi32_ps(a); }
+
+static inline _fnlV4i _fnlV4SetI(int i) { return _mm_set1_epi32(i); }
+static inline void _fnlV4StoreI(int *p, _fnlV4i a) { _mm_storeu_si128((__m128i *)p, a); }
+static inline _fnlV4i _fnlV4AddI(_fnlV4i a, _fnlV4i b) { return _mm_add_epi32(a, b); }
+static inline _fnlV4i _fnlV4XorI(_fnlV4i a, _fnlV4i b) { return _mm_xor_si128(a, b); }
+static inline _fnlV4i _fnlV4AndI(_fnlV4i a, _fnlV4i b) { return _mm_and_si128(a, b); }
+static inline _fnlV4i _fnlV4ShiftRight15I(_fnlV4i a) { return _mm_srai_epi32(a, 15); }
+
+// SSE2 only multiplies even lanes to 64 bits, keep the low halves
+static inline _fnlV4i _fnlV4MulI(_fnlV4i a, _fnlV4i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// _fnlFastFloor, truncated minus one below zero
+static inline _fnlV4i _fnlV4FastFloor(_fnlV4f f)
+{
+    __m128i negative = _mm_castps_si128(_mm_cmplt_ps(f, _mm_setzero_ps()));
+    return _mm_add_epi32(_mm_cvttps_epi32(f), negative);
+}
+#else
+typedef float32x4_t _fnlV4f;
+typedef int32x4_t _fnlV4i;
+
+static inline _fnlV4f _fnlV4Load(const float *p) { return vld1q_f32(p); }
+static inline void _fnlV4Store(float *p, _fnlV4f a) { vst1q_f32(p, a); }
+static inline _fnlV4f _fnlV4Set(float f) { return vdupq_n_f32(f); }
+static inline _fnlV4f _fnlV4Add(_fnlV4f a, _fnlV4f b) { return vaddq_f32(a, b); }
+static inline _fnlV4f _fnlV4Sub(_fnlV4f a, _fnlV4f b) { return vsubq_f32(a, b); }
+static inline _fnlV4f _fnlV4Mul(_fnlV4f a, _fnlV4f b) { return vmulq_f32(a, b); }
+static inline _fnlV4f _fnlV4ToFloat(_fnlV4i a) { return vcvtq_f32_s32(a); }
+
+static inline _fnlV4i _fnlV4SetI(int i) { return vdupq_n_s32(i); }
+static inline void _fnlV4StoreI(int *p, _fnlV4i a) { vst1q_s32(p, a); }
+static inline _fnlV4i _fnlV4AddI(_fnlV4i a, _fnlV4i b) { return vaddq_s32(a, b); }
+static inline _fnlV4i _fnlV4XorI(_fnlV4i a, _fnlV4i b) { return veorq_s32(a, b); }
+static inline _fnlV4i _fnlV4AndI(_fnlV4i a, _fnlV4i b) { return vandq_s32(a, b); }
+static inline _fnlV4i _fnlV4ShiftRight15I(_fnlV4i a) { return vshrq_n_s32(a, 15); }
+static inline _fnlV4i _fnlV4MulI(_fnlV4i a, _fnlV4i b) { return vmulq_s32(a, b); }
+
+// _fnlFastFloor, truncated minus one below zero
+static inline _fnlV4i _fnlV4FastFloor(_fnlV4f f)
+{
+    int32x4_t negative = vreinterpretq_s32_u32(vcltq_f32(f, vdupq_n_f32(0)));
+    return vaddq_s32(vcvtq_s32_f32(f), negative);
+}
+#endif
+
+static inline _fnlV4f _fnlV4Lerp(_fnlV4f a, _fnlV4f b, _fnlV4f t) { return _fnlV4Add(a, _fnlV4Mul(t, _fnlV4Sub(b, a))); }
+
+static inline _fnlV4f _fnlV4InterpQuintic(_fnlV4f t)
+{
+    _fnlV4f t3 = _fnlV4Mul(_fnlV4Mul(t, t), t);
+    _fnlV4f inner = _fnlV4Sub(_fnlV4Mul(t, _fnlV4Set(6)), _fnlV4Set(15));
+    return _fnlV4Mul(t3, _fnlV4Add(_fnlV4Mul(t, inner), _fnlV4Set(10)));
+}
+
+// Hash of the gradient index, the vector part of _fnlGradCoord2D/3D
+static inline _fnlV4i _fnlV4GradHash(_fnlV4i seed, _fnlV4i hash, int mask)
+{
+    hash = _fnlV4MulI(_fnlV4XorI(seed, hash), _fnlV4SetI(0x27d4eb2d));
+    hash = _fnlV4XorI(hash, _fnlV4ShiftRight15I(hash));
+    return _fnlV4AndI(hash, _fnlV4SetI(mask));
+}
+
+// The gradients are looked up one lane at a time, SSE2 and NEON cannot gather
+static inline _fnlV4f _fnlV4GradCoord2D(_fnlV4i seed, _fnlV4i xPrimed, _fnlV4i yPrimed, _fnlV4f xd, _fnlV4f yd)
+{
+    int hash[4];
+    float xg[4], yg[4];
+    _fnlV4StoreI(hash, _fnlV4GradHash(seed, _fnlV4XorI(xPrimed, yPrimed), 127 << 1));
+    for (int i = 0; i < 4; i++)
+    {
+        xg[i] = GRADIENTS_2D[hash[i]];
+        yg[i] = GRADIENTS_2D[hash[i] | 1];
+    }
+    return _fnlV4Add(_fnlV4Mul(xd, _fnlV4Load(xg)), _fnlV4Mul(yd, _fnlV4Load(yg)));
+}
+
+static inline _fnlV4f _fnlV4GradCoord3D(_fnlV4i seed, _fnlV4i xPrimed, _fnlV4i yPrimed, _fnlV4i zPrimed, _fnlV4f xd, _fnlV4f yd, _fnlV4f zd)
+{
+    int hash[4];
+    float xg[4], yg[4], zg[4];
+    _fnlV4StoreI(hash, _fnlV4GradHash(seed, _fnlV4XorI(_fnlV4XorI(xPrimed, yPrimed), zPrimed), 63 << 2));
+    for (int i = 0; i < 4; i++)
+    {
+        xg[i] = GRADIENTS_3D[hash[i]];
+        yg[i] = GRADIENTS_3D[hash[i] | 1];
+        zg[i] = GRADIENTS_3D[hash[i] | 2];
+    }
+    return _fnlV4Add(_fnlV4Add(_fnlV4Mul(xd, _fnlV4Load(xg)), _fnlV4Mul(yd, _fnlV4Load(yg))), _fnlV4Mul(zd, _fnlV4Load(zg)));
+}
+#endif
+
+// _fnlSinglePerlin2D at count positions scaled by frequency
+static void _fnlSinglePerlin2DRow(int seed, float frequency, const FNLfloat *x, const FNLfloat *y, int count, float *out)
+{
+    int i = 0;
+
+#if defined(FNL_SIMD)
+    const _fnlV4f frequencyV = _fnlV4Set(frequency);
+    const _fnlV4f one = _fnlV4Set(1);
+    const _fnlV4i seedV = _fnlV4SetI(seed);
+    const _fnlV4i primeX = _fnlV4SetI(PRIME_X);
+    const _fnlV4i primeY = _fnlV4SetI(PRIME_Y);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        _fnlV4f xf = _fnlV4Mul(_fnlV4Load(x + i), frequencyV);
+        _fnlV4f yf = _fnlV4Mul(_fnlV4Load(y + i), frequencyV);
+
+        _fnlV4i x0 = _fnlV4FastFloor(xf);
+        _fnlV4i y0 = _fnlV4FastFloor(yf);
+
+        _fnlV4f xd0 = _fnlV4Sub(xf, _fnlV4ToFloat(x0));
+        _fnlV4f yd0 = _fnlV4Sub(yf, _fnlV4ToFloat(y0));
+        _fnlV4f xd1 = _fnlV4Sub(xd0, one);
+        _fnlV4f yd1 = _fnlV4Sub(yd0, one);
+
+        _fnlV4f xs = _fnlV4InterpQuintic(xd0);
+        _fnlV4f ys = _fnlV4InterpQuintic(yd0);
+
+        x0 = _fnlV4MulI(x0, primeX);
+        y0 = _fnlV4MulI(y0, primeY);
+        _fnlV4i x1 = _fnlV4AddI(x0, primeX);
+        _fnlV4i y1 = _fnlV4AddI(y0, primeY);
+
+        _fnlV4f xf0 = _fnlV4Lerp(_fnlV4GradCoord2D(seedV, x0, y0, xd0, yd0), _fnlV4GradCoord2D(seedV, x1, y0, xd1, yd0), xs);
+        _fnlV4f xf1 = _fnlV4Lerp(_fnlV4GradCoord2D(seedV, x0, y1, xd0, yd1), _fnlV4GradCoord2D(seedV, x1, y1, xd1, yd1), xs);
+
+        _fnlV4Store(out + i, _fnlV4Mul(_fnlV4Lerp(xf0, xf1, ys), _fnlV4Set(1.4247691104677813f)));
+    }
+#endif
+
+    for (; i < count; i++)
+        out[i] = _fnlSinglePerlin2D(seed, x[i] * frequency, y[i] * frequency);
+}
+
+// _fnlSinglePerlin3D at count positions scaled by frequency
+static void _fnlSinglePerlin3DRow(int seed, float frequency, const FNLfloat *x, const FNLfloat *y, const FNLfloat *z, int count, float *out)
+{
+    int i = 0;
+
+#if defined(FNL_SIMD)
+    const _fnlV4f frequencyV = _fnlV4Set(frequency);
+    const _fnlV4f one = _fnlV4Set(1);
+    const _fnlV4i seedV = _fnlV4SetI(seed);
+    const _fnlV4i primeX = _fnlV4SetI(PRIME_X);
+    const _fnlV4i primeY = _fnlV4SetI(PRIME_Y);
+    const _fnlV4i primeZ = _fnlV4SetI(PRIME_Z);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        _fnlV4f xf = _fnlV4Mul(_fnlV4Load(x + i), frequencyV);
+        _fnlV4f yf = _fnlV4Mul(_fnlV4Load(y + i), frequencyV);
+        _fnlV4f zf = _fnlV4Mul(_fnlV4Load(z + i), frequencyV);
+
+        _fnlV4i x0 = _fnlV4FastFloor(xf);
+        _fnlV4i y0 = _fnlV4FastFloor(yf);
+        _fnlV4i z0 = _fnlV4FastFloor(zf);
+
+        _fnlV4f xd0 = _fnlV4Sub(xf, _fnlV4ToFloat(x0));
+        _fnlV4f yd0 = _fnlV4Sub(yf, _fnlV4ToFloat(y0));
+        _fnlV4f zd0 = _fnlV4Sub(zf, _fnlV4ToFloat(z0));
+        _fnlV4f xd1 = _fnlV4Sub(xd0, one);
+        _fnlV4f yd1 = _fnlV4Sub(yd0, one);
+        _fnlV4f zd1 = _fnlV4Sub(zd0, one);
+
+        _fnlV4f xs = _fnlV4InterpQuintic(xd0);
+        _fnlV4f ys = _fnlV4InterpQuintic(yd0);
+        _fnlV4f zs = _fnlV4InterpQuintic(zd0);
+
+        x0 = _fnlV4MulI(x0, primeX);
+        y0 = _fnlV4MulI(y0, primeY);
+        z0 = _fnlV4MulI(z0, primeZ);
+        _fnlV4i x1 = _fnlV4AddI(x0, primeX);
+        _fnlV4i y1 = _fnlV4AddI(y0, primeY);
+        _fnlV4i z1 = _fnlV4AddI(z0, primeZ);
+
+        _fnlV4f xf00 = _fnlV4Lerp(_fnlV4GradCoord3D(seedV, x0, y0, z0, xd0, yd0, zd0), _fnlV4GradCoord3D(seedV, x1, y0, z0, xd1, yd0, zd0), xs);
+        _fnlV4f xf10 = _fnlV4Lerp(_fnlV4GradCoord3D(seedV, x0, y1, z0, xd0, yd1, zd0), _fnlV4GradCoord3D(seedV, x1, y1, z0, xd1, yd1, zd0), xs);
+        _fnlV4f xf01 = _fnlV4Lerp(_fnlV4GradCoord3D(seedV, x0, y0, z1, xd0, yd0, zd1), _fnlV4GradCoord3D(seedV, x1, y0, z1, xd1, yd0, zd1), xs);
+        _fnlV4f xf11 = _fnlV4Lerp(_fnlV4GradCoord3D(seedV, x0, y1, z1, xd0, yd1, zd1), _fnlV4GradCoord3D(seedV, x1, y1, z1, xd1, yd1, zd1), xs);
+
+        _fnlV4f yf0 = _fnlV4Lerp(xf00, xf10, ys);
+        _fnlV4f yf1 = _fnlV4Lerp(xf01, xf11, ys);
+
+        _fnlV4Store(out + i, _fnlV4Mul(_fnlV4Lerp(yf0, yf1, zs), _fnlV4Set(0.964921414852142333984375f)));
+    }
+#endif
+
+    for (; i < count; i++)
+        out[i] = _fnlSinglePerlin3D(seed, x[i] * frequency, y[i] * frequency, z[i] * frequency);
+}
+
+void fnlGetNoise2DRow(fnl_state *state, const FNLfloat *x, const FNLfloat *y, int count, float *out)
+{
+    if (_fnlIsSinglePerlin(state))
+    {
+        _fnlSinglePerlin2DRow(state->seed, state->frequency, x, y, count, out);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+        out[i] = fnlGetNoise2D(state, x[i], y[i]);
+}
+
+void fnlGetNoise3DRow(fnl_state *state, const FNLfloat *x, const FNLfloat *y, const FNLfloat *z, int count, float *out)
+{
+    if (_fnlIsSinglePerlin(state) && state->rotation_type_3d == FNL_ROTATION_NONE)
+    {
+        _fnlSinglePerlin3DRow(state->seed, state->frequency, x, y, z, count, out);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+        out[i] = fnlGetNoise3D(state, x[i], y[i], z[i]);
+}
+
 void fnlDomainWarp2D(fnl_state *state, FNLfloat *x, FNLfloat *y)
 {
     switch (state->fractal_type)
@@ -31,10 +31,22 @@
 #define MIN_DRAW_DISTANCE 2
 #define MAX_DRAW_DISTANCE 4
 
-// Define how many blocks will be loaded/unloaded from chunk per step in async
-// loading
-#define UNLOAD_CHUNK_BATCH 256
-#define LOAD_CHUNK_BATCH 128
+// Infinite worlds start at the middle of the 16 bit terrain coordinates, so
+// the player can walk away from the spawn in every direction
+#define PAGED_WORLD_ORIGIN 32768
+// Terrain regions are evicted to disk beyond this many bytes
+#define PAGED_WORLD_MEMORY_BUDGET (2 * 1024 * 1024)
+
+// Terrain generated per loading frame, the rest of the frame draws the
+// loading screen
+#define WORLD_LOADING_BUDGET_MS 12.0F
+
+// Seconds between autosaves, and the time each frame writes the running save
+#define AUTOSAVE_INTERVAL 300.0F
+#define AUTOSAVE_BUDGET_MS 2.0F
+
+// Meshing passes over all chunks per terrain layout in the debug benchmark
+#define MESHING_BENCHMARK_ROUNDS 2
 
 /**
  * Define blocks IDs
@@ -14,10 +14,12 @@
 #include <vector>
 #include <algorithm>
 #include "managers/chunck_manager.hpp"
+#include "managers/chunck_mesh_builder.hpp"
 #include "managers/clouds_manager.hpp"
 #include "managers/block_manager.hpp"
 #include "managers/sound_manager.hpp"
 #include "managers/day_night_cycle_manager.hpp"
+#include "managers/light_engine.hpp"
 #include "managers/tick_manager.hpp"
 #include "models/world_light_model.hpp"
 #include "models/new_game_model.hpp"
@@ -61,17 +63,30 @@ class World {
   SoundManager* t_soundManager;
   BlockManager blockManager;
   ChunckManager chunckManager;
+  ChunckMeshBuilder chunckMeshBuilder;
   CloudsManager cloudsManager;
   DayNightCycleManager dayNightCycleManager = DayNightCycleManager();
+  LightEngine lightEngine;
 
   void init(Renderer* t_renderer, ItemRepository* itemRepository,
             SoundManager* t_soundManager);
   void update(Player* t_player, const Vec4& camLookPos,
               const Vec4& camPosition);
   void render();
+
+  /**
+   * @brief Generates the terrain around the spawn for budgetMs at most, then
+   * builds the initial chunks once it is done. Called every loading frame
+   * after init
+   * @returns If the world is ready to play
+   */
+  u8 updateLoading(const float& budgetMs);
+
+  /** @brief Phase and progress of the terrain generated by updateLoading */
+  const WorldgenProgress getLoadingProgress();
+
   inline const Vec4 getGlobalSpawnArea() const { return this->worldSpawnArea; };
   inline const Vec4 getLocalSpawnArea() const { return this->spawnArea; };
-  const std::vector<Block*> getLoadedBlocks();
   void buildInitialPosition();
 
   // From terrain manager
@@ -79,8 +94,7 @@ class World {
 
   Block* targetBlock = nullptr;
 
-  void updateTargetBlock(const Vec4& camLookPos, const Vec4& camPosition,
-                         const std::vector<Chunck*>& chuncks);
+  void updateTargetBlock(const Vec4& camLookPos, const Vec4& camPosition);
   void removeBlock(Block* blockToRemove);
   void putBlock(const Blocks& blockType, Player* t_player);
   inline const u8 validTargetBlock() {
@@ -90,7 +104,6 @@ class World {
   const Vec4 defineSpawnArea();
   const Vec4 calcSpawOffset(int bias = 0);
   void buildChunk(Chunck* t_chunck);
-  void buildChunkAsync(Chunck* t_chunck, const u8& loading_speed);
 
   inline u8 isBreakingBLock() { return this->_isBreakingBlock; };
   void breakTargetBlock(const float& deltaTime);
@@ -102,13 +115,39 @@ class World {
   inline const u8 getDrawDistace() { return worldOptions.drawDistance; };
   inline NewGameOptions* getWorldOptions() { return &worldOptions; };
 
+  /**
+   * @brief Switch between the per face and the greedy chunk mesher,
+   * rebuilding the loaded chunks
+   */
+  void setGreedyMeshing(const u8& enabled);
+  inline const u8 isGreedyMeshing() { return worldOptions.greedyMeshing; };
+
+  /**
+   * @brief Log the time to mesh every chunk with the linear and the bricked
+   * terrain layouts
+   */
+  void benchmarkMeshingLayouts();
+
   void resetWorldData();
   void reloadWorldArea(const Vec4& position);
 
+  /**
+   * @brief Reads the bricks edited since the finite terrain was generated,
+   * see WriteMapEdits, generating their columns first. The light is then
+   * computed again with the edits, as the chunks are built
+   * @returns False if the save is short or invalid
+   */
+  u8 loadTerrainEdits(LevelStream* stream);
+
+  /**
+   * @brief Drops the finite terrain columns left to generate, when the
+   * terrain comes from a save instead
+   */
+  void stopTerrainGeneration();
+
  private:
   MinecraftPipeline mcPip;
   StaticPipeline stapip;
-  std::vector<Block*> loadedBlocks;
   Vec4 worldSpawnArea;
   Vec4 spawnArea;
   Vec4 lastPlayerPosition;
@@ -125,12 +164,45 @@ class World {
 
   WorldLightModel worldLightModel;
 
+  // Generates the finite terrain a chunk column at a time, as the chunks over
+  // it are built. nullptr once every column is generated
+  WorldgenMap* terrainGenerator = nullptr;
+  // Chunk columns generated and lit, the light engine keeps out of the others
+  u8* litColumns = nullptr;
+  // Generates the columns around the spawn while the world loads
+  WorldgenJob* loadingJob = nullptr;
+
+  void initPagedTerrain();
+  void initLazyTerrain();
+  void beginLoadingTerrain();
+
+  /**
+   * @brief Make the terrain regions around the position resident, for
+   * infinite worlds, or generate the finite terrain columns under it
+   */
+  void ensureTerrainAround(const Vec4& position);
+
+  /**
+   * @brief Generates and lights the chunk columns over the cells [minX, maxX]
+   * x [minZ, maxZ] not generated yet, for finite worlds
+   */
+  void ensureTerrainColumns(const int& minX, const int& minZ, const int& maxX,
+                            const int& maxZ);
+
   void updateChunkByPlayerPosition(Player* player);
   void scheduleChunksNeighbors(Chunck* t_chunck, const Vec4 currentPlayerPos,
                                u8 force_loading = 0);
   void loadScheduledChunks();
   void unloadScheduledChunks();
-  void updateNeighBorsChunksByModdedPosition(const Vec4& pos);
+  /**
+   * @brief Relights the terrain around the edited cell and rebuilds the loaded
+   * chunks the light engine reports as dirty
+   */
+  void updateLightByModdedPosition(const Vec4& pos, const u8& previousBlock);
+  /** @brief Rebuilds the loaded chunks the light engine reports as dirty */
+  void rebuildDirtyChunks();
+  void rebuildChunkIfLoaded(Chunck* t_chunck);
+  void releaseChunk(Chunck* t_chunck);
   void addChunkToLoadAsync(Chunck* t_chunck);
   void addChunkToUnloadAsync(Chunck* t_chunck);
   void renderBlockDamageOverlay();
@@ -140,7 +212,7 @@ class World {
   inline void setIntialTime() { g_ticksCounter = worldOptions.initialTime; };
 
   // From terrain manager
-  Ray ray;
+  Vec4 targetBlockNormal;
   ItemRepository* t_itemRepository;
 
   // Breaking control
@@ -154,26 +226,13 @@ class World {
 
   uint32_t seed;
 
-  u8 isBlockAtChunkBorder(const Vec4* blockOffset, const Vec4* chunkMinOffset,
-                          const Vec4* chunkMaxOffset);
-  unsigned int getIndexByOffset(int x, int y, int z);
-
   /**
-   * @brief Update the visible block faces
-   * @return false if the block is completely hidden
-   *
+   * @brief Point targetBlock to the given terrain block, keeping the current
+   * instance (and its damage) when the target has not changed
    */
-  int getBlockVisibleFaces(const Vec4* t_blockOffset);
-
-  inline bool isBlockTransparentAtPosition(const float& x, const float& y,
-                                           const float& z);
-
-  inline bool isTopFaceVisible(const Vec4* t_blockOffset);
-  inline bool isBottomFaceVisible(const Vec4* t_blockOffset);
-  inline bool isLeftFaceVisible(const Vec4* t_blockOffset);
-  inline bool isRightFaceVisible(const Vec4* t_blockOffset);
-  inline bool isFrontFaceVisible(const Vec4* t_blockOffset);
-  inline bool isBackFaceVisible(const Vec4* t_blockOffset);
+  void setTargetBlock(const Vec4& blockOffset, const u8& blockType,
+                      const float& distance);
+  void clearTargetBlock();
 
   void calcRawBlockBBox(MinecraftPipeline* mcPip);
   void getBlockMinMax(Block* t_block);
@@ -213,30 +272,8 @@ void CrossCraft_World_Spawn();
 // bool CrossCraft_World_TryLoad(uint8_t slot, const char* prefix);
 
 /**
- * @brief Generates the world
- * @TODO Offer a callback for world percentage
+ * @brief Generates the whole world at once, World::init generates the
+ * finite worlds a column at a time instead, reporting its progress from
+ * World::getLoadingProgress
  */
 void CrossCraft_World_GenerateMap(WorldType worldType);
-
-void CrossCraft_World_PropagateSunLight(uint32_t tick);
-bool CrossCraft_World_CheckSunLight(uint16_t x, uint16_t y, uint16_t z);
-
-void CrossCraft_World_AddLight(uint16_t x, uint16_t y, uint16_t z,
-                               uint16_t light, uint32_t* updateIDs);
-void CrossCraft_World_RemoveLight(uint16_t x, uint16_t y, uint16_t z,
-                                  uint16_t light, uint32_t* updateIDs);
-
-void updateSpread(uint32_t* updateIDs);
-void updateSpread();
-void checkAddID();
-void updateID(uint16_t x, uint16_t z, uint32_t* updateIDs);
-void propagate(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel,
-               uint32_t* updateIDs);
-void propagate(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel);
-void updateSunlightRemove();
-void updateSunlight();
-void updateRemove();
-void updateRemove(uint32_t* updateIDs);
-void propagateRemove(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel);
-void propagateRemove(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel,
-                     uint32_t* updateIDs);
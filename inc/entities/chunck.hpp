@@ -12,6 +12,8 @@
 #include "renderer/3d/pipeline/minecraft/minecraft_pipeline.hpp"
 #include "renderer/3d/bbox/bbox.hpp"
 #include "managers/block/vertex_block_data.hpp"
+#include "managers/chunck_mesh_builder.hpp"
+#include "entities/level.hpp"
 #include <math/m4x4.hpp>
 #include "models/world_light_model.hpp"
 
@@ -22,13 +24,11 @@ using Tyra::CoreBBoxFrustum;
 using Tyra::M4x4;
 using Tyra::McpipBlock;
 using Tyra::MinecraftPipeline;
-using Tyra::PipelineDirLightsBag;
 using Tyra::Plane;
 using Tyra::Renderer;
 using Tyra::StaPipBag;
 using Tyra::StaPipColorBag;
 using Tyra::StaPipInfoBag;
-using Tyra::StaPipLightingBag;
 using Tyra::StaPipTextureBag;
 using Tyra::StaticPipeline;
 using Tyra::Vec4;
@@ -37,15 +37,13 @@ enum class ChunkState { Loaded, Loading, Clean };
 
 class Chunck {
  public:
-  Chunck(const Vec4& minOffset, const Vec4& maxOffset, const u16& id);
+  Chunck(const Vec4& minOffset, const Vec4& maxOffset, const u32& id);
   ~Chunck();
 
-  u16 id = 0;
+  u32 id = 0;
 
   ChunkState state = ChunkState::Clean;
 
-  std::vector<Block*> blocks;
-  Vec4* tempLoadingOffset = new Vec4();
   Vec4* minOffset = new Vec4();
   Vec4* maxOffset = new Vec4();
   Vec4* center = new Vec4();
@@ -59,7 +57,7 @@ class Chunck {
   void clear();
   void updateFrustumCheck(const Plane* frustumPlanes);
 
-  void loadDrawData();
+  void loadDrawData(LevelMap* terrain, ChunckMeshBuilder* meshBuilder);
   void clearDrawData();
   inline const u8 isDrawDataLoaded() { return _isDrawDataLoaded; };
 
@@ -67,9 +65,6 @@ class Chunck {
     return this->frustumCheck != Tyra::CoreBBoxFrustum::OUTSIDE_FRUSTUM;
   }
 
-  // Block controllers
-  void addBlock(Block* t_block);
-
   inline std::vector<Vec4> getVertexData() { return vertices; }
 
   inline std::vector<Color> getVertexColorData() { return verticesColors; }
@@ -77,28 +72,31 @@ class Chunck {
  private:
   std::vector<Vec4> vertices;
   std::vector<Color> verticesColors;
-  std::vector<Vec4> verticesNormals;
   std::vector<Vec4> uvMap;
 
+  // Face and terrain light of each vertex, see ChunckMeshBuilder::build
+  std::vector<u16> verticesLights;
+  std::vector<ChunckDrawGroup> drawGroups;
+
+  // Translates the chunk local vertices to the world
+  M4x4 model;
+
   float getVisibityByPosition(float d);
   void applyFOG(const Vec4& originPosition);
-  void highLightTargetBlock(Block* t_block, u8& isTarget);
-  void updateBlocks(const Vec4& playerPosition);
-  void filterSingleAndMultiBlocks();
-  void sortBlockByTransparency();
-
-  inline void resetLoadingOffset() {
-    this->tempLoadingOffset->set(*minOffset);
-  };
 
   void deallocDrawBags(StaPipBag* bag);
   StaPipBag* getDrawData();
 
+  /**
+   * @brief Turn the vertices lights into colors for the current sky light,
+   * only done again when it changes
+   */
+  void updateVerticesColors();
+
   inline const bool hasDataToDraw() { return vertices.size() > 0; };
 
-  Vec4 sunPosition;
-  float sunLightIntensity;
-  float ambientLightIntesity;
+  u8 skyLightLevel = 15;
+  u8 verticesColorsSkyLightLevel = 0xFF;
 
   u8 _isDrawDataLoaded = false;
 };
@@ -2,6 +2,28 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include "entities/level_section.hpp"
+#include "entities/level_stream.hpp"
+
+// Bricks are CHUNCK_SIZE cubes, the map dimensions must be multiple of it
+#define LEVEL_MAP_BRICK_SHIFT 3
+#define LEVEL_MAP_BRICK_SIZE (1 << LEVEL_MAP_BRICK_SHIFT)
+#define LEVEL_MAP_BRICK_MASK (LEVEL_MAP_BRICK_SIZE - 1)
+
+typedef enum {
+  // y * length * width + z * width + x
+  LEVEL_MAP_LAYOUT_LINEAR = 0,
+  // Contiguous bricks, laid out as the linear layout, of linear cells
+  LEVEL_MAP_LAYOUT_BRICKED = 1,
+  // Bricked, but blocks are kept in palette compressed sections
+  LEVEL_MAP_LAYOUT_SECTIONED = 2,
+  // Sectioned regions loaded and evicted by the map pager
+  LEVEL_MAP_LAYOUT_PAGED = 3,
+} LevelMapLayout;
+
+typedef struct LevelMapPager LevelMapPager;
+typedef struct LevelMapSnapshot LevelMapSnapshot;
 
 typedef struct {
   uint16_t width;
@@ -12,9 +34,26 @@ typedef struct {
 
   uint8_t* blocks;
 
-  // block data << 4
-  // light data & 0x0F
+  // sky light << 4
+  // block light & 0x0F
+  // NULL when the map has no light, every cell is then in full daylight
   uint8_t* data;
+
+  // One per brick, used instead of blocks by the sectioned layout
+  LevelMapSection* sections;
+
+  // Resident regions of the paged layout
+  LevelMapPager* pager;
+
+  // Order of the cells in blocks and data, use the accessors below
+  uint8_t layout;
+
+  // Bricks edited by SetBlockInMap, one byte per brick in the sectioned
+  // layout order. NULL when edits are not tracked, e.g. while generating
+  uint8_t* edits;
+
+  // Edited bricks still to write by WriteMapSnapshot, NULL without snapshot
+  LevelMapSnapshot* snapshot;
 } LevelMap;
 
 typedef struct {
@@ -25,11 +64,131 @@ uint32_t GetPosFromXYZ(uint32_t x, uint32_t y, uint32_t z);
 
 void GetXYZFromPos(uint32_t pos, uint32_t* x, uint32_t* y, uint32_t* z);
 
+uint32_t GetIndexFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
+
+/**
+ * Allocates the blocks storage of the map layout and dimensions.
+ */
+void CreateMapStorage(LevelMap* map);
+void FreeMapStorage(LevelMap* map);
+
+/**
+ * Allocates the light of the map, one byte per cell in the blocks order.
+ * Cells start dark, paged maps light their regions through the pager.
+ */
+void CreateMapLight(LevelMap* map);
+
+/**
+ * Starts tracking the bricks edited by SetBlockInMap, none edited yet.
+ */
+void CreateMapEdits(LevelMap* map);
+
+/**
+ * Moves blocks (and data, when allocated) to the given layout.
+ */
+void SetMapLayout(LevelMap* map, LevelMapLayout layout);
+
+/**
+ * Shrinks the palettes of a sectioned map, e.g. after generating it.
+ */
+void CompactMapSections(LevelMap* map);
+
+uint32_t GetMapMemoryUsage(LevelMap* map);
+
+/**
+ * Writes the blocks of a resident map as the sections of its bricks, in the
+ * sectioned layout order, whatever the map layout is.
+ * @returns False if the stream could not be written
+ */
+bool WriteMapBlocks(LevelMap* map, LevelStream* stream);
+
+/**
+ * Reads the blocks written by WriteMapBlocks for a map of the same size.
+ * @returns False if the stream is short or invalid
+ */
+bool ReadMapBlocks(LevelMap* map, LevelStream* stream);
+
+/**
+ * Called before the cells of a brick are read, e.g. to generate them first.
+ */
+typedef void (*LevelMapBrickLoader)(LevelMap* map, uint32_t brick,
+                                    void* userData);
+
+/**
+ * Writes the number of edited bricks and their indices, then their sections
+ * in the same order.
+ * @returns False if the stream could not be written
+ */
+bool WriteMapEdits(LevelMap* map, LevelStream* stream);
+
+/**
+ * Reads the bricks written by WriteMapEdits over the map, marking them
+ * edited. The loader, if any, is called for every brick before any of them is
+ * written, so what it generates never sees the edits. The sections are read
+ * one at a time, into the map.
+ * @returns False if the stream is short or invalid, the map may be partly
+ * edited
+ */
+bool ReadMapEdits(LevelMap* map, LevelStream* stream,
+                  LevelMapBrickLoader loader, void* userData);
+
+/**
+ * Freezes the edited bricks of a finite map, so WriteMapSnapshot can write
+ * them over several calls while the map keeps being edited. A brick still to
+ * write is copied by SetBlockInMap before its first change, the file gets the
+ * content of when the snapshot was taken. Replaces any previous snapshot.
+ * @returns False for maps without tracked edits
+ */
+bool CreateMapSnapshot(LevelMap* map);
+
+/**
+ * Writes the next bricks of the snapshot in the WriteMapEdits format, at most
+ * maxBricks of them per call. done is set once every brick is written.
+ * @returns False if the stream could not be written
+ */
+bool WriteMapSnapshot(LevelMap* map, LevelStream* stream,
+                      uint32_t maxBricks, bool* done);
+void FreeMapSnapshot(LevelMap* map);
+
 uint8_t GetDataFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
-uint8_t GetLightFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
+uint8_t GetSkyLightFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
+uint8_t GetBlockLightFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
 uint8_t GetBlockFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
 
 void SetBlockInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint8_t block);
-void SetLightInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint16_t light);
+void SetSkyLightInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint8_t light);
+void SetBlockLightInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint8_t light);
+
+bool BoundCheckMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
+
+typedef struct {
+  // Hit cell
+  uint16_t x, y, z;
+
+  // Normal of the hit face, zero when the ray starts inside the cell
+  int8_t normalX, normalY, normalZ;
+
+  uint8_t block;
+  float distance;
+} LevelMapRayHit;
+
+/**
+ * Walks the cells crossed by a ray (Amanatides & Woo) until a block above
+ * emptyBlock is found or maxDistance is reached. Cell x spans
+ * [(x - 0.5) * cellSize, (x + 0.5) * cellSize) and dir must be normalized.
+ * @returns If a block was hit
+ */
+bool RaycastMap(LevelMap* map, const float origin[3], const float dir[3],
+                float maxDistance, float cellSize, uint8_t emptyBlock,
+                LevelMapRayHit* hit);
 
-bool BoundCheckMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z);
\ No newline at end of file
+/**
+ * Sweeps an axis aligned box along one axis (0 = x, 1 = y, 2 = z), testing
+ * only the cells the box overlaps on the other two axes. Cells outside the
+ * map are empty.
+ * @returns The movement along the axis allowed before touching a block above
+ * emptyBlock, with the same sign as delta
+ */
+float SweepBoxInMap(LevelMap* map, const float boxMin[3],
+                    const float boxMax[3], uint8_t axis, float delta,
+                    float cellSize, uint8_t emptyBlock);
\ No newline at end of file
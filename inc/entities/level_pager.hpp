@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include "entities/level.hpp"
+#include "entities/level_section.hpp"
+
+// Regions are columns of 32x32 cells, as high as the map
+#define LEVEL_REGION_SHIFT 5
+#define LEVEL_REGION_SIZE (1 << LEVEL_REGION_SHIFT)
+#define LEVEL_REGION_MASK (LEVEL_REGION_SIZE - 1)
+
+#define LEVEL_PAGER_BUCKETS 64
+#define LEVEL_PAGER_DIRECTORY_SIZE 256
+
+typedef struct LevelMapRegion {
+  // Region coordinates, the map coordinates >> LEVEL_REGION_SHIFT
+  uint16_t x, z;
+
+  uint32_t lastUse;
+
+  // Edited since it was generated or read, must be written when evicted
+  uint8_t dirty;
+
+  // Same order as the sections of a 32 cells wide sectioned map
+  LevelMapSection* sections;
+
+  // Light of the region cells in the same order, NULL without a lighter.
+  // It is not written, the lighter computes it again when loading
+  uint8_t* light;
+
+  struct LevelMapRegion* next;
+} LevelMapRegion;
+
+/**
+ * Fills a region never written to disk, or lights a loaded one. The window
+ * is a sectioned map of the region size whose sections and light are the
+ * region ones.
+ */
+typedef void (*LevelMapRegionGenerator)(LevelMap* window, uint16_t regionX,
+                                        uint16_t regionZ, void* userData);
+
+struct LevelMapPager {
+  LevelMapRegion* buckets[LEVEL_PAGER_BUCKETS];
+  LevelMapRegion* lastRegion;
+  uint32_t regionsCount;
+
+  // Regions beyond the budget are evicted, least recently ensured first
+  uint32_t memoryBudget;
+  uint32_t useCounter;
+
+  // Where the evicted regions are written, ends with a slash
+  char directory[LEVEL_PAGER_DIRECTORY_SIZE];
+
+  LevelMapRegionGenerator generator;
+  LevelMapRegionGenerator lighter;
+  void* generatorData;
+};
+
+/**
+ * Makes the map an unbounded paged map. Cells are only accessible in the
+ * regions made resident by EnsureMapRegions, BoundCheckMap fails elsewhere.
+ * The map coordinates wrap, so negative coordinates address valid cells.
+ * Without a lighter the regions have no light and are in full daylight.
+ */
+void InitMapPager(LevelMap* map, const char* directory, uint32_t memoryBudget,
+                  LevelMapRegionGenerator generator,
+                  LevelMapRegionGenerator lighter, void* generatorData);
+void FreeMapPager(LevelMap* map);
+
+LevelMapRegion* GetMapRegion(LevelMapPager* pager, uint16_t regionX,
+                             uint16_t regionZ);
+uint32_t GetRegionSectionsCount(LevelMap* map);
+
+/**
+ * Loads or generates the regions within radius cells of x, z and evicts
+ * the least recently used ones while the budget is exceeded.
+ */
+void EnsureMapRegions(LevelMap* map, uint16_t x, uint16_t z, uint16_t radius);
+
+/**
+ * Writes every edited region to disk.
+ * @returns False if a region could not be written
+ */
+bool FlushMapPager(LevelMap* map);
+
+/**
+ * Deletes the region files of the pager directory, e.g. for a new world.
+ */
+void ClearMapPagerDirectory(LevelMapPager* pager);
+
+uint32_t GetPagerMemoryUsage(LevelMap* map);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include "entities/level_stream.hpp"
+
+// Sections are 8x8x8 cells, the same as the map bricks
+#define LEVEL_SECTION_CELLS 512
+
+/**
+ * Palette compressed cells. A section with a single block only stores its
+ * value, otherwise each cell is an index of 1, 2 or 4 bits into a palette,
+ * or the raw block when more than 16 blocks are used.
+ */
+typedef struct {
+  // Bits per cell, 0 when every cell is value
+  uint8_t bits;
+  uint8_t paletteCount;
+  uint8_t value;
+
+  // Palette (1 << bits entries, none for 8 bits) followed by the cells
+  uint8_t* storage;
+} LevelMapSection;
+
+uint8_t GetSectionCell(const LevelMapSection* section, uint16_t cell);
+void SetSectionCell(LevelMapSection* section, uint16_t cell, uint8_t block);
+
+/**
+ * Re-encodes the section with the smallest palette fitting its cells.
+ */
+void CompactSection(LevelMapSection* section);
+void FreeSection(LevelMapSection* section);
+
+/**
+ * Replaces the target content by a copy of the source, palette included.
+ */
+void CopySection(LevelMapSection* target, const LevelMapSection* source);
+
+uint32_t GetSectionMemoryUsage(const LevelMapSection* section);
+
+/**
+ * Bytes of the palette and cells storage for the given bits per cell.
+ */
+uint16_t GetSectionStorageSize(uint8_t bits);
+
+/**
+ * Copies the LEVEL_SECTION_CELLS cells of the section to blocks, or replaces
+ * them by blocks with the smallest palette.
+ */
+void GetSectionCells(const LevelMapSection* section, uint8_t* blocks);
+void SetSectionCells(LevelMapSection* section, const uint8_t* blocks);
+
+/**
+ * Writes the section bits, palette count and value, then its storage.
+ */
+bool WriteSection(LevelStream* stream, const LevelMapSection* section);
+
+/**
+ * Reads a section written by WriteSection into an empty section.
+ * @returns False if the section is short or invalid, it is left empty
+ */
+bool ReadSection(LevelStream* stream, LevelMapSection* section);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Bytes buffered between the codec and the file. The deflate window and
+// memory level keep a deflating stream around 40 KB, instead of the 256 KB of
+// the zlib defaults, an inflating one around 12 KB. LZ streams use 16 KB
+#define LEVEL_STREAM_BUFFER_SIZE 4096
+#define LEVEL_STREAM_WINDOW_BITS 12
+#define LEVEL_STREAM_MEM_LEVEL 5
+
+// LZ matches are found through a hash of their first LEVEL_LZ_MIN_MATCH bytes
+#define LEVEL_LZ_MIN_MATCH 4
+#define LEVEL_LZ_HASH_BITS 12
+
+/**
+ * Codecs of a stream, the ids are written in the save files.
+ */
+typedef enum {
+  // Bytes go straight to the file
+  LEVEL_STREAM_PLAIN = 0,
+  // zlib deflate at the default level, the smallest files
+  LEVEL_STREAM_DEFLATE = 1,
+  // Byte oriented LZ77 in blocks of LEVEL_STREAM_BUFFER_SIZE bytes, several
+  // times faster than deflate for larger files, decompressing the fastest
+  LEVEL_STREAM_LZ = 2,
+} LevelStreamCodec;
+
+#define LEVEL_STREAM_CODECS 3
+
+/**
+ * Bytes of the map blocks written to or read from a file through a fixed
+ * buffer, whatever the size of the map. The file position is undefined once a
+ * compressed stream is opened, the stream is the last part of its file.
+ */
+typedef struct {
+  FILE* file;
+  uint8_t codec;
+  bool writing;
+  bool failed;
+
+  // Buffers and state of the codec, NULL for plain streams
+  void* state;
+} LevelStream;
+
+/**
+ * @returns True if codec is a LevelStreamCodec id, e.g. read from a file
+ */
+bool IsLevelStreamCodec(uint8_t codec);
+
+/**
+ * Starts writing or reading the file at its position with the given codec.
+ * The stream must be closed, even if it could not start.
+ * @returns False if the codec could not start, the stream is then failed
+ */
+bool OpenLevelStream(LevelStream* stream, FILE* file, LevelStreamCodec codec,
+                     bool writing);
+
+/**
+ * @returns False if not every byte could be written or read, every later call
+ * fails too
+ */
+bool WriteLevelStream(LevelStream* stream, const void* data, uint32_t size);
+bool ReadLevelStream(LevelStream* stream, void* data, uint32_t size);
+
+/**
+ * Writes the bytes left in the codec, then frees it. The file stays open.
+ * @returns False if the stream failed
+ */
+bool CloseLevelStream(LevelStream* stream);
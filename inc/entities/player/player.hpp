@@ -22,6 +22,7 @@
 #include "entities/items/tools/axe/axe.hpp"
 #include "models/terrain_height_model.hpp"
 #include "entities/chunck.hpp"
+#include "entities/level.hpp"
 #include "entities/player/player_render_pip.hpp"
 #include "entities/player/player_first_person_render_pip.hpp"
 #include "entities/player/player_third_person_render_pip.hpp"
@@ -53,7 +54,7 @@ class Player {
   ~Player();
 
   void update(const float& deltaTime, const Vec4& movementDir,
-              const Vec4& camDir, const std::vector<Chunck*>& loadedChunks,
+              const Vec4& camDir, LevelMap* terrain,
               TerrainHeightModel* terrainHeight);
   void render();
 
@@ -72,11 +73,11 @@ class Player {
   std::unique_ptr<DynamicMesh> armMesh;
 
   Vec4 spawnArea;
-  u16 currentChunckId = 0;
+  u32 currentChunckId = 0;
 
   // Phisycs variables
   Ray ray;
-  Block* currentBlock = nullptr;
+  Blocks currentBlock = Blocks::VOID;
 
   // Inventory
   u8 inventoryHasChanged = 1;
@@ -109,8 +110,7 @@ class Player {
   void shiftItemToInventory(const ItemId& itemToShift);
   void setItemToInventory(const ItemId& itemToShift);
 
-  TerrainHeightModel getTerrainHeightAtPosition(
-      const std::vector<Chunck*>& loadedChunks);
+  TerrainHeightModel getTerrainHeightAtPosition(LevelMap* terrain);
 
  private:
   BlockManager* t_blockManager;
@@ -139,9 +139,11 @@ class Player {
   void updateGravity(const float& deltaTime, TerrainHeightModel* terrainHeight);
   void fly(const float& deltaTime, const TerrainHeightModel& terrainHeight,
            const Vec4& direction);
-  u8 updatePosition(const std::vector<Chunck*>& loadedChunks,
-                    const float& deltaTime, const Vec4& nextPlayerPos,
-                    u8 isColliding = 0);
+  u8 updatePosition(LevelMap* terrain, const float& deltaTime,
+                    const Vec4& nextPlayerPos);
+  Blocks getBlockUnderFootprint(LevelMap* terrain, const Vec4& minPlayer,
+                                const Vec4& maxPlayer,
+                                const float& groundHeight);
 
   // Inventory
 
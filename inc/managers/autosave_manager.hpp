@@ -0,0 +1,50 @@
+#pragma once
+#include <tamtypes.h>
+#include <stdio.h>
+#include <string>
+#include "tyra"
+#include "constants.hpp"
+#include "entities/level.hpp"
+
+class StateGamePlay;
+
+/**
+ * Saves the game without stopping it. The save header and the edited bricks
+ * are captured when the save starts, see CreateMapSnapshot, then the bricks
+ * are compressed AUTOSAVE_BUDGET_MS per frame to a temporary file replacing
+ * the save once complete, so a save is never left half written.
+ */
+class AutosaveManager {
+ public:
+  AutosaveManager();
+  ~AutosaveManager();
+
+  /**
+   * Starts a save every AUTOSAVE_INTERVAL seconds and writes the running one
+   */
+  void update(StateGamePlay* state, const float& deltaTime);
+
+  /**
+   * Starts saving the game to fullPath with the codec of the blocks, after
+   * finishing the running save
+   */
+  void start(StateGamePlay* state, const std::string& fullPath,
+             const LevelStreamCodec codec);
+
+  /** Writes the rest of the running save at once, e.g. before quitting */
+  void finish();
+
+  inline const u8 isSaving() { return this->saveFile != nullptr; };
+
+ private:
+  FILE* saveFile = nullptr;
+  LevelStream blocksStream;
+  LevelMap* t_map = nullptr;
+  std::string savePath;
+  std::string tempPath;
+  float elapsedTime = 0.0F;
+  u8 written = false;
+
+  void write(const float& budgetMs);
+  void close();
+};
@@ -38,6 +38,14 @@ class BlockManager {
   SfxBlockModel* getDigSoundByBlockType(const Blocks& blockType);
   SfxBlockModel* getStepSoundByBlockType(const Blocks& blockType);
   inline Texture* getBlocksTexture() { return this->blocksTexAtlas; };
+
+  /**
+   * @brief Make the atlas repeat a single tile, so UVs past the tile size wrap
+   * back into it (used by greedy meshed quads)
+   */
+  void useAtlasTile(const u8& col, const u8& row);
+  void useWholeAtlas();
+
   float getBlockBreakingTime();
   McpipBlock* getDamageOverlay(const float& damage_percentage);
 
@@ -47,6 +55,7 @@ class BlockManager {
   void loadBlocksTextures(const std::string& texturePack);
 
   Texture* blocksTexAtlas;
+  u8 isAtlasTiled = false;
   Renderer* t_renderer;
   BlockTextureRepository* t_blockTextureRepository;
 
@@ -12,6 +12,8 @@
 #include "renderer/3d/bbox/bbox.hpp"
 #include <math/m4x4.hpp>
 #include <vector>
+#include <unordered_map>
+#include "entities/level.hpp"
 #include "models/world_light_model.hpp"
 
 using Tyra::BBox;
@@ -26,16 +28,23 @@ class ChunckManager {
   ChunckManager();
   ~ChunckManager();
 
-  Chunck* getChunckByPosition(const Vec4& position);
-  Chunck* getChunckByOffset(const Vec4& offset);
-  Chunck* getChunckById(const u16& id);
+  Chunck* getChunckByGridPosition(const int& x, const int& y, const int& z);
+
+  /**
+   * @brief Chunks are created on demand, only over terrain cells that are
+   * available (resident regions for paged terrains)
+   */
+  Chunck* getOrCreateChunckByGridPosition(const int& x, const int& y,
+                                          const int& z);
+  Chunck* getOrCreateChunckByPosition(const Vec4& position);
+  void releaseChunck(Chunck* t_chunck);
 
   std::vector<Chunck*>& getChuncks() { return chuncks; };
 
   std::vector<Chunck*>& getVisibleChunks();
   inline const u16 getVisibleChunksCounter() { return visibleChunks.size(); };
 
-  void init();
+  void init(LevelMap* terrain);
   void update(const Plane* frustumPlanes, const Vec4& currentPlayerPos,
               WorldLightModel* worldLightModel);
   u8 isChunkVisible(Chunck* chunk);
@@ -44,8 +53,16 @@ class ChunckManager {
   void clearAllChunks();
 
  private:
+  LevelMap* terrain;
+  u32 lastChunckId = 0;
+
   std::vector<Chunck*> chuncks;
   std::vector<Chunck*> visibleChunks;
 
-  void generateChunks();
+  // Chunks by grid position, see getGridKey
+  std::unordered_map<u64, Chunck*> chuncksByGridPosition;
+
+  inline u64 getGridKey(const int& x, const int& y, const int& z) {
+    return ((u64)(u16)x << 32) | ((u64)(u16)z << 16) | (u16)y;
+  }
 };
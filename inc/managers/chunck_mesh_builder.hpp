@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <tamtypes.h>
+#include <math/vec4.hpp>
+#include "constants.hpp"
+#include "entities/level.hpp"
+#include "managers/block_manager.hpp"
+#include "managers/block/vertex_block_data.hpp"
+#include "models/block_info_model.hpp"
+
+using Tyra::Vec4;
+
+/** Range of chunk vertices drawn with the same atlas setup */
+struct ChunckDrawGroup {
+  u32 first = 0;
+  u32 count = 0;
+
+  // Merged quads repeat a single atlas tile, their UVs are relative to it
+  u8 isTiled = false;
+  u8 tileCol = 0;
+  u8 tileRow = 0;
+};
+
+/**
+ * @brief Builds the chunk draw data straight from the terrain voxels.
+ *
+ * Faces are emitted in chunk local space (the chunk model matrix translates
+ * them to the world), reading the per face vertices and UV deltas from tables
+ * filled once at init. Each vertex gets the light of the cell its face looks
+ * into, the chunk turns it into a color.
+ */
+class ChunckMeshBuilder {
+ public:
+  ChunckMeshBuilder();
+  ~ChunckMeshBuilder();
+
+  void init(BlockManager* t_blockManager);
+
+  /**
+   * @brief Fill vertices, lights and uvMap with the visible faces of the
+   * blocks between minOffset (inclusive) and maxOffset (exclusive). Opaque
+   * faces come first, transparent ones last. Lights are the face index << 8
+   * and the terrain data (sky and block light) of the lit cell.
+   */
+  void build(LevelMap* terrain, const Vec4& minOffset, const Vec4& maxOffset,
+             std::vector<Vec4>* vertices, std::vector<u16>* lights,
+             std::vector<Vec4>* uvMap, std::vector<ChunckDrawGroup>* groups);
+
+  /**
+   * @brief Merge coplanar opaque faces sharing the same texture and light
+   * into larger quads. Each merged quad repeats its atlas tile, so they are
+   * drawn in one group per tile.
+   */
+  inline void setGreedyMeshing(const u8& enabled) { greedyMeshing = enabled; };
+  inline const u8 isGreedyMeshing() { return greedyMeshing; };
+
+ private:
+  static const u8 FACES_COUNT = 6;
+  static const u8 VERTICES_PER_FACE = VertexBlockData::FACES_COUNT;
+
+  // Same order as VertexBlockData::getVertexData
+  enum Face { Top, Bottom, Left, Right, Back, Front };
+
+  /** Rectangle of merged faces inside a chunk slice */
+  struct GreedyQuad {
+    u8 face;
+    u8 slice;
+    u8 a, b;  // Min cell along the face U and V axes
+    u8 width, height;
+    u16 tile;
+    u8 light;
+  };
+
+  u8 greedyMeshing = false;
+
+  Vec4 faceVertices[FACES_COUNT][VERTICES_PER_FACE];
+  u8 faceUVs[FACES_COUNT][VERTICES_PER_FACE][2];
+  s8 faceNeighbors[FACES_COUNT][3];
+
+  // Normal, U and V axes (0 = x, 1 = y, 2 = z) of each face
+  u8 faceAxes[FACES_COUNT][3];
+
+  // Index of the col/row pair of each face in BlockInfo::_facesMap
+  u8 faceMapIndex[FACES_COUNT];
+
+  BlockInfo* blocksInfo[(u8)Blocks::TOTAL_OF_BLOCKS];
+  u8 transparentBlocks[(u8)Blocks::TOTAL_OF_BLOCKS];
+
+  // Per cell scratch, reused between builds
+  u8 cellTypes[CHUNCK_LENGTH];
+  u8 cellFaces[CHUNCK_LENGTH];
+  u8 cellLights[CHUNCK_LENGTH][FACES_COUNT];
+  u32 sliceMask[CHUNCK_SIZE][CHUNCK_SIZE];
+  std::vector<GreedyQuad> greedyQuads;
+
+  void loadFaceTables();
+  u8 getVisibleFaces(LevelMap* terrain, const u16& x, const u16& y,
+                     const u16& z);
+  inline bool isTransparentAt(LevelMap* terrain, const u16& x, const u16& y,
+                              const u16& z);
+  inline u16 getFaceTile(const u8& blockType, const u8& face);
+  void emitFaces(const u8& blockType, const u8& visibleFaces,
+                 const u8* faceLights, const Vec4& localPosition,
+                 std::vector<Vec4>* vertices, std::vector<u16>* lights,
+                 std::vector<Vec4>* uvMap);
+
+  void collectGreedyQuads();
+  void mergeSlice(const u8& face, const u8& slice);
+  void emitGreedyQuad(const GreedyQuad& quad, std::vector<Vec4>* vertices,
+                      std::vector<u16>* lights, std::vector<Vec4>* uvMap);
+};
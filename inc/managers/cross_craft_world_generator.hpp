@@ -10,9 +10,116 @@
 #include <time.h>
 #include <tyra>
 
+// Worker threads splitting the generation in x slabs. The EE has one core,
+// so the game generates on the calling thread only
+#define WORLDGEN_MAX_WORKERS 8
+#define WORLDGEN_DEFAULT_WORKERS 1
+
+// Saves of finite worlds only keep their edited bricks and generate the rest
+// from the seed again. Bump it with any change to the cells a seed gives, the
+// saves of other versions are not loaded over the new terrain
+#define WORLDGEN_VERSION 1
+
 void CrossCraft_WorldGenerator_Init(int32_t seed);
+
+/**
+ * Sets the threads generating a map, clamped to [1, WORLDGEN_MAX_WORKERS].
+ * Random numbers are hashes of the seed, stage and position instead of a
+ * shared sequence, so maps are the same for any count.
+ */
+void CrossCraft_WorldGenerator_SetWorkers(uint8_t workers);
+
+/**
+ * Generates a finite map a column of LEVEL_MAP_BRICK_SIZE by
+ * LEVEL_MAP_BRICK_SIZE cells at a time, so only the columns in use need to be.
+ * Features crossing columns (caves, ore veins and the tree attempts) are
+ * staged from their streams when the generation begins, and trees only grow
+ * into air, so a column gets the same cells whatever order the columns are
+ * generated in, the same as generating the whole map at once.
+ */
+typedef struct WorldgenMap WorldgenMap;
+
+/**
+ * Starts generating the map, without writing any cell yet. The staged
+ * features and the noise fields are kept until CrossCraft_WorldGenerator_End.
+ */
+WorldgenMap* CrossCraft_WorldGenerator_Begin(LevelMap* map,
+                                             WorldType worldType);
+
+/**
+ * Generates the columns [minX, maxX) x [minZ, maxZ) not generated yet, in
+ * column coordinates (cells >> LEVEL_MAP_BRICK_SHIFT). Trees reach into the
+ * columns around theirs, the terrain of those is generated too, without their
+ * plants.
+ */
+void CrossCraft_WorldGenerator_Generate_Columns(WorldgenMap* generator,
+                                                uint16_t minX, uint16_t minZ,
+                                                uint16_t maxX, uint16_t maxZ);
+bool CrossCraft_WorldGenerator_Is_Column_Generated(
+    const WorldgenMap* generator, uint16_t x, uint16_t z);
+
+/**
+ * LevelMapBrickLoader of the edits read over a generator, see ReadMapEdits.
+ * A chunk is built with the columns around it, so the plants of the columns
+ * around an edited brick were there before the edit. They are generated
+ * before the edits are written for the same reason, trees check the cells
+ * they grow into.
+ */
+void CrossCraft_WorldGenerator_Load_Edited_Brick(LevelMap* map, uint32_t brick,
+                                                 void* generator);
+
+/** Columns left to generate, the map is complete at 0 */
+uint32_t CrossCraft_WorldGenerator_Get_Pending_Columns(
+    const WorldgenMap* generator);
+
+/**
+ * Generation of columns spread over frames. The job runs the terrain phases
+ * one after another over the columns and the ring around them, then plants
+ * them, a step of one column at a time. Columns generated in between by
+ * CrossCraft_WorldGenerator_Generate_Columns are skipped.
+ */
+typedef struct WorldgenJob WorldgenJob;
+
+typedef struct {
+  // Name of the phase running, "Raising", "Eroding"...
+  const char* phase;
+  // Done of the phase and of the whole job, in [0, 1]
+  float phaseProgress;
+  float progress;
+} WorldgenProgress;
+
+/** Starts a job completing the columns [minX, maxX) x [minZ, maxZ) */
+WorldgenJob* CrossCraft_WorldGenerator_Begin_Job(WorldgenMap* generator,
+                                                 uint16_t minX, uint16_t minZ,
+                                                 uint16_t maxX, uint16_t maxZ);
+
+/**
+ * Runs the job until it is done or budgetMs went by, at least one step.
+ * @return True when the columns are complete
+ */
+bool CrossCraft_WorldGenerator_Run_Job(WorldgenJob* job, float budgetMs);
+WorldgenProgress CrossCraft_WorldGenerator_Get_Job_Progress(
+    const WorldgenJob* job);
+
+/** Frees the job, before the generator it runs on */
+void CrossCraft_WorldGenerator_End_Job(WorldgenJob* job);
+
+/** Frees the generator, the generated columns stay in the map */
+void CrossCraft_WorldGenerator_End(WorldgenMap* generator);
+
 void CrossCraft_WorldGenerator_Generate_Original(LevelMap* map);
 void CrossCraft_WorldGenerator_Generate_Flat(LevelMap* map);
 void CrossCraft_WorldGenerator_Generate_Woods(LevelMap* map);
-void CrossCraft_WorldGenerator_Generate_Island(LevelMap* map);;
-void CrossCraft_WorldGenerator_Generate_Floating(LevelMap* map);
\ No newline at end of file
+void CrossCraft_WorldGenerator_Generate_Island(LevelMap* map);
+void CrossCraft_WorldGenerator_Generate_Floating(LevelMap* map);
+
+/**
+ * Generates one region of a paged world into a window map of the region size.
+ * The terrain is continuous across regions, features crossing the window are
+ * clipped. Islands have no center in an unbounded world and use the original
+ * generator.
+ */
+void CrossCraft_WorldGenerator_Generate_Region(LevelMap* window,
+                                               WorldType worldType,
+                                               uint16_t regionX,
+                                               uint16_t regionZ);
@@ -35,6 +35,11 @@ class DayNightCycleManager {
 
   const float getLightIntensity();
   const float getAmbientLightIntesity();
+
+  /**
+   * @brief Brightest sky light level at this time, in the terrain light range
+   */
+  const u8 getSkyLightLevel();
   inline const u8 isDay() {
     return (g_ticksCounter > DAY_SUNRISE || g_ticksCounter < DAY_SUNSET);
   };
@@ -60,4 +65,8 @@ class DayNightCycleManager {
   const float baseAmbientLightIntensity = 25.0F;
   const float dayAmbientLightIntesity = 30.0F;
   const float nightAmbientLightIntesity = 10.0F;
+
+  const u8 horizonSkyLightLevel = 8;
+  const u8 daySkyLightLevel = 7;
+  const u8 nightSkyLightLevel = 4;
 };
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <tamtypes.h>
+#include "entities/level.hpp"
+
+// Nodes of each engine queue, 128KB per queue
+#define LIGHT_ENGINE_CAPACITY (1 << 15)
+
+// Chunks an edit can report, CHUNCK_SIZE cubes of the terrain grid
+#define LIGHT_ENGINE_MAX_DIRTY_CHUNKS 256
+#define LIGHT_ENGINE_DIRTY_SLOTS (LIGHT_ENGINE_MAX_DIRTY_CHUNKS * 2)
+
+/** Terrain light channels, the shift of each one in the map data */
+enum class LightChannel : u8 { Block = 0, Sky = 4 };
+
+/**
+ * @brief Flood fills the terrain sky and block light with breadth first
+ * passes.
+ *
+ * The queues are fixed capacity rings allocated once, so the passes never
+ * allocate. A node is packed in 32 bits: x and z relative to the pass origin
+ * (10 bits each), y (8 bits) and a light level (4 bits). The origin is
+ * centered on the edited cell, light never travels 512 cells away from it,
+ * and is 0 for whole map passes, which need maps up to 1024 cells wide and
+ * 256 cells high.
+ *
+ * Passes keep their state in the engine and leave the queues empty, so any
+ * pass can follow another and separate engines can light separate maps at
+ * the same time.
+ */
+class LightEngine {
+ public:
+  LightEngine(const u32& capacity = LIGHT_ENGINE_CAPACITY);
+  ~LightEngine();
+
+  /**
+   * @brief Lights the whole map from the sky, dropping its previous sky
+   * light. Paged maps are lit one region window at a time instead.
+   */
+  void propagateSunLight(LevelMap* map);
+
+  /**
+   * @brief Lights the cells [minX, maxX) x [minZ, maxZ) from the sky and from
+   * the lit cells around them, for maps lit a column at a time. The light
+   * spreading out of them marks the chunks it changes as dirty
+   */
+  void propagateSunLight(LevelMap* map, const u16& minX, const u16& minZ,
+                         const u16& maxX, const u16& maxZ);
+
+  /**
+   * @brief Keeps the light out of the columns the mask has at 0, one byte per
+   * LEVEL_MAP_BRICK_SIZE square column, x + z * columnsX. Columns without
+   * their terrain yet are masked, so no light crosses them. nullptr lights
+   * every column
+   */
+  void setColumnMask(const u8* mask, const u16& columnsX);
+
+  /** @brief Makes the cell a light source of the given level */
+  void addBlockLight(LevelMap* map, const u16& x, const u16& y, const u16& z,
+                     const u8& level);
+
+  /**
+   * @brief Removes the light source of the cell, the light of the other
+   * sources fills what it lit
+   */
+  void removeBlockLight(LevelMap* map, const u16& x, const u16& y,
+                        const u16& z);
+
+  /**
+   * @brief Relights the terrain after the cell block replaced previousBlock.
+   * Only the light the edit changed is propagated, from the cell outwards,
+   * instead of scanning sky columns. Marks the chunks of the cell and of
+   * every cell whose light changed as dirty
+   */
+  void updateBlock(LevelMap* map, const u16& x, const u16& y, const u16& z,
+                   const u8& previousBlock);
+
+  /**
+   * @brief Chunks marked dirty by the edits since the last clear, by chunk
+   * grid position (the cell coordinates / CHUNCK_SIZE). A chunk is dirty
+   * when one of its faces looks into a cell that changed
+   */
+  inline const u16 getDirtyChunksCount() { return dirtyChunksCount; };
+  void getDirtyChunk(const u16& index, u16* x, u16* y, u16* z);
+  void clearDirtyChunks();
+
+  /** @brief Some dirty chunks could not be recorded, rebuild them all */
+  inline const u8 hasDirtyChunksOverflow() { return dirtyChunksOverflow; };
+
+  /**
+   * @brief Nodes the last pass dropped because a queue was full, it warns
+   * about them. Their cells keep the light they had before the pass
+   */
+  inline const u32 getDroppedNodes() { return droppedNodes; };
+
+ private:
+  struct LightQueue {
+    u32* nodes;
+    u32 mask;
+    u32 head;
+    u32 count;
+  };
+
+  LightQueue spreadQueue;
+  LightQueue removalQueue;
+
+  u16 originX = 0;
+  u16 originZ = 0;
+  u32 droppedNodes = 0;
+
+  const u8* columnMask = nullptr;
+  u16 columnMaskX = 0;
+
+  // Dirty chunks in marking order, with a hash set of them to skip repeats
+  u32 dirtyChunks[LIGHT_ENGINE_MAX_DIRTY_CHUNKS];
+  u32 dirtyChunksSet[LIGHT_ENGINE_DIRTY_SLOTS];
+  u16 dirtyChunksCount = 0;
+  u8 dirtyChunksOverflow = false;
+  u8 trackDirtyChunks = false;
+
+  void markDirtyChunk(const u16& x, const u16& y, const u16& z);
+  void markDirtyCell(const u16& x, const u16& y, const u16& z);
+
+  void initQueue(LightQueue* queue, const u32& capacity);
+  bool push(LightQueue* queue, const u32& node);
+  u32 pop(LightQueue* queue);
+  inline bool isFull(const LightQueue* queue) {
+    return queue->count > queue->mask;
+  };
+  // Seeding leaves the other half to the spread it drains the queue with
+  inline bool isHalfFull(const LightQueue* queue) {
+    return queue->count > queue->mask / 2;
+  };
+
+  void beginPass(const u16& x, const u16& z);
+  void endPass(const char* pass);
+  inline u32 packNode(const u16& x, const u16& y, const u16& z,
+                      const u8& level);
+  inline void unpackNode(const u32& node, u16* x, u16* y, u16* z, u8* level);
+
+  u8 getLight(LevelMap* map, const LightChannel& channel, const u16& x,
+              const u16& y, const u16& z);
+  void setLight(LevelMap* map, const LightChannel& channel, const u16& x,
+                const u16& y, const u16& z, const u8& level);
+
+  void spreadTo(LevelMap* map, const LightChannel& channel, const u16& x,
+                const u16& y, const u16& z, const u8& level, const u8& loss);
+  void removeFrom(LevelMap* map, const LightChannel& channel, const u16& x,
+                  const u16& y, const u16& z, const u8& level,
+                  const u8& loss);
+  void spread(LevelMap* map, const LightChannel& channel);
+  void unspread(LevelMap* map, const LightChannel& channel);
+
+  void removeCellLight(LevelMap* map, const LightChannel& channel,
+                       const u16& x, const u16& y, const u16& z);
+  void spreadFromNeighbors(LevelMap* map, const LightChannel& channel,
+                           const u16& x, const u16& y, const u16& z);
+};
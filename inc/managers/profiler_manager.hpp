@@ -0,0 +1,101 @@
+#pragma once
+#include <tamtypes.h>
+#include <stdio.h>
+#include <time.h>
+#include <string>
+
+// Frames the averages and max times are taken over
+#define PROFILER_WINDOW_FRAMES 60
+
+// Frames written by a dump, 10 seconds at 60 FPS
+#define PROFILER_DUMP_FRAMES 600
+
+#define PROFILER_DUMP_FILE "profiler.csv"
+
+/**
+ * Stages timed every frame. The time of a stage includes the stages it runs,
+ * e.g. World update includes Chunks update, Chunks load and Meshing. A stage
+ * running within itself, e.g. a chunk load rebuilding other chunks, is timed
+ * once, from its outermost begin to its outermost end.
+ */
+enum class ProfilerStage : u8 {
+  Frame,
+  WorldUpdate,
+  ChunksUpdate,
+  TargetBlock,
+  PlayerUpdate,
+  ChunksLoad,
+  ChunksUnload,
+  Meshing,
+  WorldRender,
+};
+
+#define PROFILER_STAGES 9
+
+/**
+ * Times the stages of the frames between beginFrame and endFrame. Keeps the
+ * last PROFILER_WINDOW_FRAMES frames for the debug overlay and, on request,
+ * writes the next PROFILER_DUMP_FRAMES ones to a CSV file, one line per frame.
+ */
+class ProfilerManager {
+ public:
+  ProfilerManager();
+  ~ProfilerManager();
+
+  void beginFrame();
+  void endFrame();
+
+  inline void begin(const ProfilerStage& stage) {
+    if (stageDepth[(u8)stage]++ == 0) stageStart[(u8)stage] = clock();
+  }
+
+  inline void end(const ProfilerStage& stage) {
+    if (--stageDepth[(u8)stage] == 0)
+      stageMs[(u8)stage] +=
+          (clock() - stageStart[(u8)stage]) * 1000.0F / (float)CLOCKS_PER_SEC;
+  }
+
+  const char* getStageName(const ProfilerStage& stage);
+  float getAverageMs(const ProfilerStage& stage);
+  float getMaxMs(const ProfilerStage& stage);
+
+  /**
+   * Writes the next PROFILER_DUMP_FRAMES frames to fullPath
+   * @returns False if a dump is running or the file could not be created
+   */
+  bool startDump(const std::string& fullPath);
+  inline bool isDumping() { return dumpFile != nullptr; }
+
+ private:
+  void writeDumpLine();
+  void stopDump();
+
+  clock_t stageStart[PROFILER_STAGES];
+  u8 stageDepth[PROFILER_STAGES];
+  float stageMs[PROFILER_STAGES];
+  float history[PROFILER_STAGES][PROFILER_WINDOW_FRAMES];
+  u8 historyIndex = 0;
+  u8 historyCount = 0;
+
+  FILE* dumpFile = nullptr;
+  u32 dumpFrames = 0;
+  u32 framesCounter = 0;
+};
+
+/**
+ * @brief Declaration of the global profiler
+ *
+ */
+extern ProfilerManager g_profiler;
+
+/** Times its stage from its construction to the end of its scope */
+class ProfilerScope {
+ public:
+  explicit ProfilerScope(const ProfilerStage& stage) : stage(stage) {
+    g_profiler.begin(stage);
+  }
+  ~ProfilerScope() { g_profiler.end(stage); }
+
+ private:
+  const ProfilerStage stage;
+};
@@ -6,8 +6,10 @@
 #include "managers/tick_manager.hpp"
 #include "states/game_play/state_game_play.hpp"
 #include "models/save_game_model.hpp"
+#include "models/save_info_model.hpp"
 #include "entities/World.hpp"
 #include "entities/level.hpp"
+#include "entities/level_pager.hpp"
 #include <3libs/nlohmann/json.hpp>
 #include <fstream>
 #include <vector>
@@ -17,164 +19,365 @@
 #include <3libs/gzip/utils.hpp>
 #include <3libs/gzip/version.hpp>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 using Tyra::FileUtils;
 using json = nlohmann::json;
 
+// Binary saves start with this magic and version. Saves without it are the
+// gzipped JSON documents of the older versions, they are still loaded
+#define SAVE_FILE_MAGIC "TCSV"
+#define SAVE_FILE_VERSION 1
+
+// Codecs of the blocks, saves from the menu favour the size, autosaves the
+// time they take
+#define SAVE_FILE_CODEC LEVEL_STREAM_DEFLATE
+#define SAVE_FILE_QUICK_CODEC LEVEL_STREAM_LZ
+
 class SaveManager {
  public:
-  static void SaveGame(StateGamePlay* state, const char* fullPath) {
-    json jsonfile;
-
-    TYRA_LOG("Saving player position...");
-    jsonfile["playerPosition"]["x"] = state->player->getPosition()->x;
-    jsonfile["playerPosition"]["y"] = state->player->getPosition()->y;
-    jsonfile["playerPosition"]["z"] = state->player->getPosition()->z;
-
-    TYRA_LOG("Saving camera params...");
-    jsonfile["cameraParams"]["pitch"] = state->context->t_camera->pitch;
-    jsonfile["cameraParams"]["yaw"] = state->context->t_camera->yaw;
-
-    TYRA_LOG("Saving World Options...");
-    jsonfile["gameOptions"]["name"] = state->world->getWorldOptions()->name;
-    jsonfile["gameOptions"]["seed"] = state->world->getWorldOptions()->seed;
-    jsonfile["gameOptions"]["drawDistance"] =
-        state->world->getWorldOptions()->drawDistance;
-    jsonfile["gameOptions"]["initialTime"] =
-        state->world->getWorldOptions()->initialTime;
-    jsonfile["gameOptions"]["type"] =
-        (uint8_t)state->world->getWorldOptions()->type;
-    jsonfile["gameOptions"]["texturePack"] =
-        state->world->getWorldOptions()->texturePack;
-
-    TYRA_LOG("Saving tick state...");
-    jsonfile["tickState"]["g_ticksCounter"] = g_ticksCounter;
-    jsonfile["tickState"]["elapsedRealTime"] = elapsedRealTime;
-    jsonfile["tickState"]["ticksDayCounter"] = ticksDayCounter;
-
-    TYRA_LOG("Saving World State...");
-    LevelMap* t_map = CrossCraft_World_GetMapPtr();
-    jsonfile["worldLevel"]["map"]["width"] = t_map->width;
-    jsonfile["worldLevel"]["map"]["length"] = t_map->length;
-    jsonfile["worldLevel"]["map"]["height"] = t_map->height;
-    jsonfile["worldLevel"]["map"]["spawnX"] = t_map->spawnX;
-    jsonfile["worldLevel"]["map"]["spawnY"] = t_map->spawnY;
-    jsonfile["worldLevel"]["map"]["spawnZ"] = t_map->spawnZ;
-
-    std::string tempBlocksBuffer;
-    for (size_t i = 0; i < OVERWORLD_SIZE; i++) {
-      tempBlocksBuffer.push_back(t_map->blocks[i] + '0');
-    }
-    jsonfile["worldLevel"]["map"]["blocks"] = tempBlocksBuffer;
+  /**
+   * Captures what the save header holds, the game can go on while the blocks
+   * are written, see AutosaveManager.
+   */
+  static void GetSaveGameModel(StateGamePlay* state, SaveGameModel* model) {
+    model->gameOptions = *state->world->getWorldOptions();
+    model->playerPosition = *state->player->getPosition();
+    model->cameraPitch = state->context->t_camera->pitch;
+    model->cameraYaw = state->context->t_camera->yaw;
+    model->ticksCounter = g_ticksCounter;
+    model->elapsedRealTime = elapsedRealTime;
+    model->ticksDayCounter = ticksDayCounter;
 
-    TYRA_LOG("Compressing data...");
-    auto rawData = jsonfile.dump();
-    std::string compressed_data =
-        gzip::compress(rawData.data(), rawData.size());
+    const LevelMap* t_map = CrossCraft_World_GetMapPtr();
+    LevelMap* map = &model->worldLevel.map;
+    *map = {};
+    map->width = t_map->width;
+    map->length = t_map->length;
+    map->height = t_map->height;
+    map->spawnX = t_map->spawnX;
+    map->spawnY = t_map->spawnY;
+    map->spawnZ = t_map->spawnZ;
+  }
 
-    std::ofstream saveFile(fullPath);
-    saveFile << compressed_data;
-    saveFile.close();
-  };
+  /**
+   * Writes the save header: magic and version, the save info (generator
+   * version, world options and map size) that listings read alone, then
+   * player, camera, tick state and spawn, and last the codec of the blocks.
+   * The bricks of finite worlds edited since they were generated follow it in
+   * a stream of that codec, see WriteMapEdits, the rest of the terrain is
+   * generated again from the seed when loading. Infinite worlds flush their
+   * regions instead.
+   * @returns False if the file could not be written
+   */
+  static bool WriteSaveHeader(FILE* file, const SaveGameModel* model,
+                              const LevelStreamCodec codec) {
+    const LevelMap* map = &model->worldLevel.map;
+    return fwrite(SAVE_FILE_MAGIC, 4, 1, file) == 1 &&
+           WriteValue(file, (u8)SAVE_FILE_VERSION) &&
+           WriteValue(file, (u16)WORLDGEN_VERSION) &&
+           WriteGameOptions(file, &model->gameOptions) &&
+           WriteValue(file, map->width) && WriteValue(file, map->length) &&
+           WriteValue(file, map->height) &&
+           WriteValue(file, model->playerPosition.x) &&
+           WriteValue(file, model->playerPosition.y) &&
+           WriteValue(file, model->playerPosition.z) &&
+           WriteValue(file, model->cameraPitch) &&
+           WriteValue(file, model->cameraYaw) &&
+           WriteValue(file, model->ticksCounter) &&
+           WriteValue(file, model->elapsedRealTime) &&
+           WriteValue(file, model->ticksDayCounter) &&
+           WriteValue(file, map->spawnX) && WriteValue(file, map->spawnY) &&
+           WriteValue(file, map->spawnZ) && WriteValue(file, (u8)codec);
+  }
 
   static void LoadSavedGame(StateGamePlay* state, const char* fullPath) {
     TYRA_LOG("Reseting world data...");
     state->world->resetWorldData();
 
     TYRA_LOG("Reading save file from : ", fullPath);
-    std::ifstream saveFile(fullPath);
-    if (saveFile) {
-      TYRA_LOG("Decompressing data...");
-      std::string compressed_data((std::istreambuf_iterator<char>(saveFile)),
-                                  std::istreambuf_iterator<char>());
-      std::string decompressed_data =
-          gzip::decompress(compressed_data.data(), compressed_data.size());
-      json savedData = json::parse(decompressed_data);
-
-      TYRA_LOG("Loading player Position...");
-      state->player->getPosition()->set(
-          savedData["playerPosition"]["x"].get<float>(),
-          savedData["playerPosition"]["y"].get<float>(),
-          savedData["playerPosition"]["z"].get<float>());
-
-      // TODO: add hot inventory state to save file;
-
-      TYRA_LOG("Loading camera params...");
-      state->context->t_camera->pitch =
-          savedData["cameraParams"]["pitch"].get<float>();
-      state->context->t_camera->yaw =
-          savedData["cameraParams"]["yaw"].get<float>();
-
-      TYRA_LOG("Loading world pptions...");
-      NewGameOptions* gameOptions = state->world->getWorldOptions();
-      gameOptions->name = savedData["gameOptions"]["name"].get<std::string>();
-      gameOptions->seed = savedData["gameOptions"]["seed"].get<uint32_t>();
-      gameOptions->drawDistance =
-          savedData["gameOptions"]["drawDistance"].get<u8>();
-      gameOptions->initialTime =
-          savedData["gameOptions"]["initialTime"].get<float>();
-      gameOptions->type = savedData["gameOptions"]["type"].get<WorldType>();
-      gameOptions->texturePack =
-          savedData["gameOptions"]["texturePack"].get<std::string>();
-
-      TYRA_LOG("Loading tick state...");
-      // These are global scope variables;
-      g_ticksCounter = savedData["tickState"]["g_ticksCounter"].get<float>();
-      elapsedRealTime = savedData["tickState"]["elapsedRealTime"].get<double>();
-      ticksDayCounter =
-          savedData["tickState"]["ticksDayCounter"].get<uint16_t>();
-
-      TYRA_LOG("Loading world state...");
-      LevelMap* t_map = CrossCraft_World_GetMapPtr();
-      t_map->width = savedData["worldLevel"]["map"]["width"].get<uint16_t>();
-      t_map->length = savedData["worldLevel"]["map"]["length"].get<uint16_t>();
-      t_map->height = savedData["worldLevel"]["map"]["height"].get<uint16_t>();
-      t_map->spawnX = savedData["worldLevel"]["map"]["spawnX"].get<uint16_t>();
-      t_map->spawnY = savedData["worldLevel"]["map"]["spawnY"].get<uint16_t>();
-      t_map->spawnZ = savedData["worldLevel"]["map"]["spawnZ"].get<uint16_t>();
+    FILE* saveFile = fopen(fullPath, "rb");
+    if (!saveFile) {
+      TYRA_ERROR("Save file not found at: ", fullPath);
+      return;
+    }
 
-      TYRA_LOG("Loading blocks data...");
-      const char* tempBLocksBuffer =
-          savedData["worldLevel"]["map"]["blocks"].get<std::string>().c_str();
+    bool legacy;
+    if (!ReadHeader(saveFile, &legacy)) {
+      fclose(saveFile);
+      if (legacy) return LoadLegacySavedGame(state, fullPath);
+      TYRA_ERROR("Save file version is not supported: ", fullPath);
+      return;
+    }
 
-      for (size_t i = 0; i < OVERWORLD_SIZE; i++) {
-        uint8_t number = tempBLocksBuffer[i] - 48;
-        t_map->blocks[i] = number;
-      }
+    TYRA_LOG("Loading world options...");
+    uint16_t width, length, height;
+    u16 generatorVersion;
+    bool read = ReadSaveInfo(saveFile, &generatorVersion,
+                             state->world->getWorldOptions(), &width, &length,
+                             &height);
+    if (read && !IsTerrainSupported(generatorVersion,
+                                    state->world->getWorldOptions())) {
+      fclose(saveFile);
+      TYRA_ERROR("Save file terrain is from another world generator: ",
+                 fullPath);
+      return;
+    }
 
-      TYRA_LOG("Reloading world data...");
-      state->world->reloadWorldArea(*state->player->getPosition());
-    } else {
-      TYRA_ERROR("Save file not found at: ", fullPath);
+    TYRA_LOG("Loading player Position...");
+    float x, y, z;
+    read = read && ReadValue(saveFile, &x) && ReadValue(saveFile, &y) &&
+           ReadValue(saveFile, &z);
+    if (read) state->player->getPosition()->set(x, y, z);
+
+    TYRA_LOG("Loading camera params...");
+    read = read && ReadValue(saveFile, &state->context->t_camera->pitch) &&
+           ReadValue(saveFile, &state->context->t_camera->yaw);
+
+    TYRA_LOG("Loading tick state...");
+    // These are global scope variables;
+    read = read && ReadValue(saveFile, &g_ticksCounter) &&
+           ReadValue(saveFile, &elapsedRealTime) &&
+           ReadValue(saveFile, &ticksDayCounter);
+
+    TYRA_LOG("Loading world state...");
+    LevelMap* t_map = CrossCraft_World_GetMapPtr();
+    read = read && ReadValue(saveFile, &t_map->spawnX) &&
+           ReadValue(saveFile, &t_map->spawnY) &&
+           ReadValue(saveFile, &t_map->spawnZ);
+
+    read = read && width == t_map->width && length == t_map->length &&
+           height == t_map->height;
+
+    u8 codec = LEVEL_STREAM_PLAIN;
+    read = read && ReadValue(saveFile, &codec);
+
+    // The blocks are decompressed a buffer at a time, straight to the map
+    LevelStream stream;
+    read = OpenLevelStream(&stream, saveFile, (LevelStreamCodec)codec,
+                           false) &&
+           read;
+
+    // Infinite worlds read their regions on demand
+    if (read && !t_map->pager) {
+      TYRA_LOG("Loading edited blocks...");
+      read = state->world->loadTerrainEdits(&stream);
     }
+    CloseLevelStream(&stream);
+    fclose(saveFile);
+
+    if (!read) TYRA_ERROR("Save file is corrupted: ", fullPath);
+
+    TYRA_LOG("Reloading world data...");
+    state->world->reloadWorldArea(*state->player->getPosition());
   };
 
   static NewGameOptions* GetNewGameOptionsFromSaveFile(const char* fullPath) {
     NewGameOptions* model = new NewGameOptions();
 
-    TYRA_LOG("Decompressing data...");
-    std::ifstream saveFile(fullPath);
-    if (saveFile) {
-      std::string compressed_data((std::istreambuf_iterator<char>(saveFile)),
-                                  std::istreambuf_iterator<char>());
-      std::string decompressed_data =
-          gzip::decompress(compressed_data.data(), compressed_data.size());
-      json savedData = json::parse(decompressed_data);
-
-      TYRA_LOG("Loading world pptions...");
-      model->seed = savedData["gameOptions"]["seed"].get<uint32_t>();
-      model->drawDistance = savedData["gameOptions"]["drawDistance"].get<u8>();
-      model->initialTime = savedData["gameOptions"]["initialTime"].get<float>();
-      model->type = savedData["gameOptions"]["type"].get<WorldType>();
-      model->texturePack =
-          savedData["gameOptions"]["texturePack"].get<std::string>();
-    }
+    FILE* saveFile = fopen(fullPath, "rb");
+    if (!saveFile) return model;
+
+    // The options come first, right after the header
+    TYRA_LOG("Loading world pptions...");
+    uint16_t width, length, height;
+    u16 generatorVersion;
+    bool legacy;
+    if (!(ReadHeader(saveFile, &legacy) &&
+          ReadSaveInfo(saveFile, &generatorVersion, model, &width, &length,
+                       &height)) &&
+        !legacy)
+      TYRA_ERROR("Save file is corrupted: ", fullPath);
+    fclose(saveFile);
 
+    if (legacy) {
+      json savedData = ReadLegacySaveFile(fullPath);
+      ReadLegacyGameOptions(savedData, model);
+    }
     return model;
   }
 
+  /**
+   * Reads the save info of a listed save, the rest of the file is not read.
+   * Legacy saves have none, hasInfo stays false.
+   */
+  static void ReadSaveInfo(const char* fullPath, SaveInfoModel* model) {
+    FILE* saveFile = fopen(fullPath, "rb");
+    if (!saveFile) return;
+
+    u16 generatorVersion;
+    bool legacy;
+    model->hasInfo =
+        ReadHeader(saveFile, &legacy) &&
+        ReadSaveInfo(saveFile, &generatorVersion, &model->gameOptions,
+                     &model->width, &model->length, &model->height);
+    model->isTerrainSupported =
+        !model->hasInfo ||
+        IsTerrainSupported(generatorVersion, &model->gameOptions);
+    fclose(saveFile);
+  }
+
   static bool CheckIfSaveExist(const char* fullPath) {
     struct stat buffer;
     return (stat(fullPath, &buffer) == 0);
   }
-};
\ No newline at end of file
+
+ private:
+  // Values are written in the EE byte order, little endian
+  template <typename T>
+  static bool WriteValue(FILE* file, const T& value) {
+    return fwrite(&value, sizeof(T), 1, file) == 1;
+  }
+
+  template <typename T>
+  static bool ReadValue(FILE* file, T* value) {
+    return fread(value, sizeof(T), 1, file) == 1;
+  }
+
+  static bool WriteString(FILE* file, const std::string& value) {
+    const uint16_t size = value.size();
+    return WriteValue(file, size) &&
+           (size == 0 || fwrite(value.data(), size, 1, file) == 1);
+  }
+
+  static bool ReadString(FILE* file, std::string* value) {
+    uint16_t size;
+    if (!ReadValue(file, &size)) return false;
+
+    value->resize(size);
+    return size == 0 || fread(&(*value)[0], size, 1, file) == 1;
+  }
+
+  // Reads the magic and version, false for legacy saves, without the magic,
+  // and for other versions
+  static bool ReadHeader(FILE* file, bool* legacy) {
+    char magic[4];
+    u8 version;
+    *legacy = fread(magic, sizeof(magic), 1, file) != 1 ||
+              memcmp(magic, SAVE_FILE_MAGIC, sizeof(magic)) != 0;
+    return !*legacy && ReadValue(file, &version) &&
+           version == SAVE_FILE_VERSION;
+  }
+
+  static bool WriteGameOptions(FILE* file, const NewGameOptions* options) {
+    return WriteString(file, options->name) &&
+           WriteValue(file, options->seed) &&
+           WriteValue(file, options->drawDistance) &&
+           WriteValue(file, options->initialTime) &&
+           WriteValue(file, (u8)options->type) &&
+           WriteString(file, options->texturePack) &&
+           WriteValue(file, options->infiniteWorld);
+  }
+
+  static bool ReadGameOptions(FILE* file, NewGameOptions* options) {
+    u8 type;
+    const bool read = ReadString(file, &options->name) &&
+                      ReadValue(file, &options->seed) &&
+                      ReadValue(file, &options->drawDistance) &&
+                      ReadValue(file, &options->initialTime) &&
+                      ReadValue(file, &type) &&
+                      ReadString(file, &options->texturePack) &&
+                      ReadValue(file, &options->infiniteWorld);
+    if (read) options->type = (WorldType)type;
+    return read;
+  }
+
+  // Reads the generator version, the options and the map size
+  static bool ReadSaveInfo(FILE* file, u16* generatorVersion,
+                           NewGameOptions* options, uint16_t* width,
+                           uint16_t* length, uint16_t* height) {
+    return ReadValue(file, generatorVersion) &&
+           ReadGameOptions(file, options) && ReadValue(file, width) &&
+           ReadValue(file, length) && ReadValue(file, height);
+  }
+
+  // Infinite worlds save their regions whole, only the regions never visited
+  // are generated by the current version
+  static bool IsTerrainSupported(const u16 generatorVersion,
+                                 const NewGameOptions* options) {
+    return options->infiniteWorld || generatorVersion == WORLDGEN_VERSION;
+  }
+
+  static json ReadLegacySaveFile(const char* fullPath) {
+    TYRA_LOG("Decompressing data...");
+    std::ifstream saveFile(fullPath);
+    std::string compressed_data((std::istreambuf_iterator<char>(saveFile)),
+                                std::istreambuf_iterator<char>());
+    std::string decompressed_data =
+        gzip::decompress(compressed_data.data(), compressed_data.size());
+    return json::parse(decompressed_data);
+  }
+
+  static void ReadLegacyGameOptions(json& savedData, NewGameOptions* model) {
+    model->name = savedData["gameOptions"]["name"].get<std::string>();
+    model->seed = savedData["gameOptions"]["seed"].get<uint32_t>();
+    model->drawDistance = savedData["gameOptions"]["drawDistance"].get<u8>();
+    model->initialTime = savedData["gameOptions"]["initialTime"].get<float>();
+    model->type = savedData["gameOptions"]["type"].get<WorldType>();
+    model->texturePack =
+        savedData["gameOptions"]["texturePack"].get<std::string>();
+    model->infiniteWorld = savedData["gameOptions"].value("infiniteWorld", 0);
+  }
+
+  // Saves of the older versions, one character per block in a JSON string
+  static void LoadLegacySavedGame(StateGamePlay* state, const char* fullPath) {
+    json savedData = ReadLegacySaveFile(fullPath);
+
+    TYRA_LOG("Loading player Position...");
+    state->player->getPosition()->set(
+        savedData["playerPosition"]["x"].get<float>(),
+        savedData["playerPosition"]["y"].get<float>(),
+        savedData["playerPosition"]["z"].get<float>());
+
+    // TODO: add hot inventory state to save file;
+
+    TYRA_LOG("Loading camera params...");
+    state->context->t_camera->pitch =
+        savedData["cameraParams"]["pitch"].get<float>();
+    state->context->t_camera->yaw =
+        savedData["cameraParams"]["yaw"].get<float>();
+
+    TYRA_LOG("Loading world pptions...");
+    ReadLegacyGameOptions(savedData, state->world->getWorldOptions());
+
+    TYRA_LOG("Loading tick state...");
+    // These are global scope variables;
+    g_ticksCounter = savedData["tickState"]["g_ticksCounter"].get<float>();
+    elapsedRealTime = savedData["tickState"]["elapsedRealTime"].get<double>();
+    ticksDayCounter = savedData["tickState"]["ticksDayCounter"].get<uint16_t>();
+
+    TYRA_LOG("Loading world state...");
+    LevelMap* t_map = CrossCraft_World_GetMapPtr();
+    t_map->width = savedData["worldLevel"]["map"]["width"].get<uint16_t>();
+    t_map->length = savedData["worldLevel"]["map"]["length"].get<uint16_t>();
+    t_map->height = savedData["worldLevel"]["map"]["height"].get<uint16_t>();
+    t_map->spawnX = savedData["worldLevel"]["map"]["spawnX"].get<uint16_t>();
+    t_map->spawnY = savedData["worldLevel"]["map"]["spawnY"].get<uint16_t>();
+    t_map->spawnZ = savedData["worldLevel"]["map"]["spawnZ"].get<uint16_t>();
+
+    // Infinite worlds read their regions on demand
+    if (!t_map->pager) {
+      state->world->stopTerrainGeneration();
+
+      TYRA_LOG("Loading blocks data...");
+      const std::string tempBLocksBuffer =
+          savedData["worldLevel"]["map"]["blocks"].get<std::string>();
+
+      size_t i = 0;
+      for (uint16_t y = 0; y < t_map->height; y++)
+        for (uint16_t z = 0; z < t_map->length; z++)
+          for (uint16_t x = 0; x < t_map->width; x++) {
+            uint8_t number = tempBLocksBuffer[i++] - 48;
+            SetBlockInMap(t_map, x, y, z, number);
+          }
+      CompactMapSections(t_map);
+
+      TYRA_LOG("Lighting blocks...");
+      state->world->lightEngine.propagateSunLight(t_map);
+    }
+
+    TYRA_LOG("Reloading world data...");
+    state->world->reloadWorldArea(*state->player->getPosition());
+  }
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <inttypes.h>
 #include <constants.hpp>
+#include "entities/level.hpp"
 
 class NewGameOptions {
  public:
@@ -11,6 +12,10 @@ class NewGameOptions {
   u8 drawDistance = MIN_DRAW_DISTANCE;
   WorldType type = WorldType::WORLD_TYPE_ORIGINAL;
   float initialTime = 6000;
+  u8 greedyMeshing = false;
+  LevelMapLayout mapLayout = LEVEL_MAP_LAYOUT_LINEAR;
+  // Terrain paged in regions around the player instead of a fixed size map
+  u8 infiniteWorld = false;
   std::string texturePack = "default";
   std::string name;
 };
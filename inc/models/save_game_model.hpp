@@ -7,13 +7,24 @@
 
 using Tyra::Vec4;
 
+/**
+ * Game state written in the save header, captured at once so the blocks can
+ * be written later, see SaveManager::GetSaveGameModel.
+ */
 class SaveGameModel {
  public:
   SaveGameModel(){};
   ~SaveGameModel(){};
 
   NewGameOptions gameOptions;
+  // Size and spawn of the map, its storage is not copied
   Level worldLevel;
   Vec4 playerPosition;
-  
+
+  float cameraPitch;
+  float cameraYaw;
+
+  float ticksCounter;
+  double elapsedRealTime;
+  u16 ticksDayCounter;
 };
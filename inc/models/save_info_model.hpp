@@ -2,6 +2,7 @@
 #include <tyra>
 #include <string>
 #include <inttypes.h>
+#include "new_game_model.hpp"
 
 using Tyra::Sprite;
 
@@ -12,4 +13,15 @@ class SaveInfoModel {
   std::string title;
   std::string createdAt;
   Sprite icon;
+
+  // Save info read from the front of the file, none for legacy saves
+  u8 hasInfo = false;
+  NewGameOptions gameOptions;
+  uint16_t width = 0;
+  uint16_t length = 0;
+  uint16_t height = 0;
+
+  // False for finite worlds generated by another WORLDGEN_VERSION, their
+  // edits would be read over other terrain
+  u8 isTerrainSupported = true;
 };
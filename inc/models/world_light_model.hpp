@@ -12,4 +12,5 @@ class WorldLightModel {
   Vec4 moonPosition;
   float lightIntensity;
   float ambientLightIntensity;
+  u8 skyLightLevel;
 };
@@ -18,6 +18,7 @@
 #include "entities/World.hpp"
 #include "entities/player/player.hpp"
 #include "managers/items_repository.hpp"
+#include "managers/autosave_manager.hpp"
 #include "ui.hpp"
 #include <chrono>
 
@@ -48,7 +49,9 @@ class StateGamePlay : public GameState {
   void setPlayingState(PlayingStateBase* t_playingState);
   PlayingStateBase* getPreviousState();
 
+  /** Saves the game in the background, see AutosaveManager */
   void saveGame();
+  const std::string getSaveFilePath();
 
   // Rotating skybox
   StaticMesh* menuSkybox;
@@ -63,6 +66,7 @@ class StateGamePlay : public GameState {
   PlayingStateBase* previousState = nullptr;
   u8 paused = false;
   u8 isAtWelcomeState = false;
+  AutosaveManager autosaveManager;
 
   void handleGameMode(const GameMode& gameMode);
   void handleInput();
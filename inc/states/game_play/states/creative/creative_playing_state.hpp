@@ -5,6 +5,7 @@
 #include "managers/font/font_manager.hpp"
 #include "managers/font/font_options.hpp"
 #include "managers/tick_manager.hpp"
+#include "managers/profiler_manager.hpp"
 #include "models/terrain_height_model.hpp"
 #include "entities/inventory.hpp"
 #include <tamtypes.h>
@@ -29,6 +30,7 @@ class CreativePlayingState : public PlayingStateBase {
   void navigate();
   void renderCreativeUi();
   void drawDegubInfo();
+  void drawProfilerInfo();
   void playNewRandomSong();
   void openInventory();
   void closeInventory();
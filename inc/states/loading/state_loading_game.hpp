@@ -19,6 +19,7 @@
 #include "managers/items_repository.hpp"
 #include "ui.hpp"
 #include "thread"
+#include "managers/font/font_manager.hpp"
 #include "models/new_game_model.hpp"
 
 using Tyra::Color;
@@ -45,6 +46,7 @@ class StateLoadingGame : public GameState {
   u8 shouldInitItemRepository = 1;
   u8 shouldInitUI = 1;
   u8 shouldInitPlayer = 1;
+  u8 isWorldLoading = 0;
 
   Sprite* background;
   Sprite* loadingSlot;
@@ -52,6 +54,8 @@ class StateLoadingGame : public GameState {
   Sprite* loadingStateText;
   LoadingState _state = LoadingState::Loading;
   float _percent = 1.0F;
+  // Terrain generation phase shown under the bar
+  std::string loadingPhase;
   float BASE_HEIGHT;
 
   StateGamePlay* stateGamePlay = nullptr;
@@ -75,6 +75,8 @@ class Utils {
   static float Raycast(Vec4* origin, Vec4* dir, Vec4* min, Vec4* max);
   static Vec4 GetNormalFromHitPosition(const Vec4& intersection,
                                        const Vec4& min, const Vec4& max);
+  /** @brief Terrain offset of the block that contains a world coordinate */
+  static int GetBlockOffsetFromPosition(const float& position);
   static void GetMinkowskiSum(const Vec4& AMin, const Vec4& AMax,
                               const Vec4& BMin, const Vec4& BMax,
                               Vec4* resultMin, Vec4* resultMax);
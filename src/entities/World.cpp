@@ -7,9 +7,12 @@
 // From CrossCraft
 #include <stdio.h>
 #include "entities/World.hpp"
-#include <queue>
+#include "entities/level_pager.hpp"
+#include "managers/profiler_manager.hpp"
+#include <sys/stat.h>
 
 using Tyra::Color;
+using Tyra::FileUtils;
 using Tyra::M4x4;
 
 World::World(const NewGameOptions& options) {
@@ -24,6 +27,8 @@ World::World(const NewGameOptions& options) {
 }
 
 World::~World() {
+  stopTerrainGeneration();
+  clearTargetBlock();
   delete rawBlockBbox;
   CrossCraft_World_Deinit();
 }
@@ -34,24 +39,67 @@ void World::init(Renderer* renderer, ItemRepository* itemRepository,
   mcPip.setRenderer(&t_renderer->core);
   stapip.setRenderer(&t_renderer->core);
   blockManager.init(t_renderer, &mcPip, worldOptions.texturePack);
-  chunckManager.init();
+  chunckMeshBuilder.init(&blockManager);
+  chunckMeshBuilder.setGreedyMeshing(worldOptions.greedyMeshing);
   cloudsManager.init(t_renderer);
   calcRawBlockBBox(&mcPip);
 
   terrain = CrossCraft_World_GetMapPtr();
+  terrain->layout = worldOptions.mapLayout;
+  if (worldOptions.infiniteWorld) initPagedTerrain();
   CrossCraft_World_Create_Map();
-  CrossCraft_World_GenerateMap(worldOptions.type);
+  if (!worldOptions.infiniteWorld) {
+    // Saves only keep the bricks edited since the terrain was generated
+    CreateMapEdits(terrain);
+    initLazyTerrain();
+  }
+  chunckManager.init(terrain);
 
   // Define global and local spawn area
   worldSpawnArea.set(defineSpawnArea());
   spawnArea.set(worldSpawnArea);
   lastPlayerPosition.set(worldSpawnArea);
+  beginLoadingTerrain();
+};
+
+// The columns of the chunks loaded at the spawn are generated by a job over
+// the loading frames, before the initial chunks are built
+void World::beginLoadingTerrain() {
+  if (!terrainGenerator) return;
+
+  const int x = worldSpawnArea.x / DUBLE_BLOCK_SIZE;
+  const int z = worldSpawnArea.z / DUBLE_BLOCK_SIZE;
+  const int radius = (worldOptions.drawDistance + 1) * CHUNCK_SIZE;
+  loadingJob = CrossCraft_WorldGenerator_Begin_Job(
+      terrainGenerator, std::max(x - radius, 0) >> LEVEL_MAP_BRICK_SHIFT,
+      std::max(z - radius, 0) >> LEVEL_MAP_BRICK_SHIFT,
+      ((x + radius) >> LEVEL_MAP_BRICK_SHIFT) + 1,
+      ((z + radius) >> LEVEL_MAP_BRICK_SHIFT) + 1);
+}
+
+u8 World::updateLoading(const float& budgetMs) {
+  if (loadingJob) {
+    if (!CrossCraft_WorldGenerator_Run_Job(loadingJob, budgetMs)) return false;
+
+    CrossCraft_WorldGenerator_End_Job(loadingJob);
+    loadingJob = nullptr;
+  }
+
   buildInitialPosition();
   setIntialTime();
-};
+  return true;
+}
+
+const WorldgenProgress World::getLoadingProgress() {
+  if (loadingJob) return CrossCraft_WorldGenerator_Get_Job_Progress(loadingJob);
+
+  WorldgenProgress done = {nullptr, 1.0F, 1.0F};
+  return done;
+}
 
 void World::update(Player* t_player, const Vec4& camLookPos,
                    const Vec4& camPosition) {
+  ProfilerScope profile(ProfilerStage::WorldUpdate);
   framesCounter++;
 
   cloudsManager.update();
@@ -61,12 +109,13 @@ void World::update(Player* t_player, const Vec4& camLookPos,
   chunckManager.update(t_renderer->core.renderer3D.frustumPlanes.getAll(),
                        *t_player->getPosition(), &worldLightModel);
   updateChunkByPlayerPosition(t_player);
-  updateTargetBlock(camLookPos, camPosition, chunckManager.getVisibleChunks());
+  updateTargetBlock(camLookPos, camPosition);
 
   framesCounter %= 60;
 };
 
 void World::render() {
+  ProfilerScope profile(ProfilerStage::WorldRender);
   t_renderer->core.setClearScreenColor(dayNightCycleManager.getSkyColor());
 
   chunckManager.renderer(t_renderer, &stapip, &blockManager);
@@ -79,8 +128,137 @@ void World::render() {
   }
 };
 
+// Fills the regions of infinite worlds, they are written to disk once edited
+static void generateTerrainRegion(LevelMap* window, uint16_t regionX,
+                                  uint16_t regionZ, void* userData) {
+  World* world = (World*)userData;
+  CrossCraft_WorldGenerator_Generate_Region(
+      window, world->getWorldOptions()->type, regionX, regionZ);
+}
+
+// Sunlight does not cross the region borders, the shade of the terrain on
+// the other side is not known
+static void lightTerrainRegion(LevelMap* window, uint16_t regionX,
+                               uint16_t regionZ, void* userData) {
+  ((World*)userData)->lightEngine.propagateSunLight(window);
+}
+
+void World::initPagedTerrain() {
+  const std::string regionsPath =
+      FileUtils::fromCwd("saves/" + worldOptions.name + "_regions/");
+  InitMapPager(terrain, regionsPath.c_str(), PAGED_WORLD_MEMORY_BUDGET,
+               generateTerrainRegion, lightTerrainRegion, this);
+
+  // Drop the regions written by an unsaved world with the same name
+  struct stat buffer;
+  const std::string savePath =
+      FileUtils::fromCwd("saves/" + worldOptions.name + ".tcw");
+  if (stat(savePath.c_str(), &buffer) != 0)
+    ClearMapPagerDirectory(terrain->pager);
+}
+
+void World::initLazyTerrain() {
+  terrainGenerator =
+      CrossCraft_WorldGenerator_Begin(terrain, worldOptions.type);
+
+  const u16 columnsX = terrain->length >> LEVEL_MAP_BRICK_SHIFT;
+  const u16 columnsZ = terrain->width >> LEVEL_MAP_BRICK_SHIFT;
+  litColumns = new u8[columnsX * columnsZ]();
+  lightEngine.setColumnMask(litColumns, columnsX);
+}
+
+void World::stopTerrainGeneration() {
+  if (!terrainGenerator) return;
+
+  if (loadingJob) CrossCraft_WorldGenerator_End_Job(loadingJob);
+  loadingJob = nullptr;
+  CrossCraft_WorldGenerator_End(terrainGenerator);
+  terrainGenerator = nullptr;
+  lightEngine.setColumnMask(nullptr, 0);
+  delete[] litColumns;
+  litColumns = nullptr;
+}
+
+u8 World::loadTerrainEdits(LevelStream* stream) {
+  if (!terrainGenerator) {
+    const u8 read = ReadMapEdits(terrain, stream, nullptr, nullptr);
+    lightEngine.propagateSunLight(terrain);
+    return read;
+  }
+
+  // Columns lit so far are lit again with the edits
+  const u16 columnsX = terrain->length >> LEVEL_MAP_BRICK_SHIFT;
+  const u16 columnsZ = terrain->width >> LEVEL_MAP_BRICK_SHIFT;
+  memset(litColumns, 0, columnsX * columnsZ);
+  memset(terrain->data, 0, terrain->length * terrain->width * terrain->height);
+
+  // Edited bricks are read over the generated columns around them
+  const u8 read =
+      ReadMapEdits(terrain, stream, CrossCraft_WorldGenerator_Load_Edited_Brick,
+                   terrainGenerator);
+  CompactMapSections(terrain);
+  return read;
+}
+
+void World::ensureTerrainColumns(const int& minX, const int& minZ,
+                                 const int& maxX, const int& maxZ) {
+  if (!terrainGenerator) return;
+
+  const int columnsX = terrain->length >> LEVEL_MAP_BRICK_SHIFT;
+  const int columnsZ = terrain->width >> LEVEL_MAP_BRICK_SHIFT;
+  const u16 fromX = std::max(minX >> LEVEL_MAP_BRICK_SHIFT, 0);
+  const u16 fromZ = std::max(minZ >> LEVEL_MAP_BRICK_SHIFT, 0);
+  const u16 toX = std::min((maxX >> LEVEL_MAP_BRICK_SHIFT) + 1, columnsX);
+  const u16 toZ = std::min((maxZ >> LEVEL_MAP_BRICK_SHIFT) + 1, columnsZ);
+  if (fromX >= toX || fromZ >= toZ) return;
+
+  CrossCraft_WorldGenerator_Generate_Columns(terrainGenerator, fromX, fromZ,
+                                             toX, toZ);
+
+  // The light of the new columns reaches the chunks built around them
+  bool lit = false;
+  for (u16 z = fromZ; z < toZ; z++) {
+    for (u16 x = fromX; x < toX; x++) {
+      if (litColumns[x + z * columnsX] ||
+          !CrossCraft_WorldGenerator_Is_Column_Generated(terrainGenerator, x,
+                                                         z))
+        continue;
+
+      litColumns[x + z * columnsX] = true;
+      lightEngine.propagateSunLight(terrain, x << LEVEL_MAP_BRICK_SHIFT,
+                                    z << LEVEL_MAP_BRICK_SHIFT,
+                                    (x + 1) << LEVEL_MAP_BRICK_SHIFT,
+                                    (z + 1) << LEVEL_MAP_BRICK_SHIFT);
+      lit = true;
+    }
+  }
+  if (lit) rebuildDirtyChunks();
+
+  if (CrossCraft_WorldGenerator_Get_Pending_Columns(terrainGenerator) == 0) {
+    stopTerrainGeneration();
+    CompactMapSections(terrain);
+  }
+}
+
+void World::ensureTerrainAround(const Vec4& position) {
+  const int x = position.x / DUBLE_BLOCK_SIZE;
+  const int z = position.z / DUBLE_BLOCK_SIZE;
+
+  // The player collides with the cells around it before their chunks are
+  // built
+  ensureTerrainColumns(x - CHUNCK_SIZE, z - CHUNCK_SIZE, x + CHUNCK_SIZE,
+                       z + CHUNCK_SIZE);
+  if (!terrain->pager) return;
+
+  // One more chunk than the drawn ones, so their borders can be meshed
+  const u16 radius = (worldOptions.drawDistance + 1) * CHUNCK_SIZE;
+  EnsureMapRegions(terrain, x, z, radius);
+}
+
 void World::buildInitialPosition() {
-  Chunck* initialChunck = chunckManager.getChunckByPosition(worldSpawnArea);
+  ensureTerrainAround(worldSpawnArea);
+  Chunck* initialChunck =
+      chunckManager.getOrCreateChunckByPosition(worldSpawnArea);
   if (initialChunck != nullptr) {
     initialChunck->clear();
     buildChunk(initialChunck);
@@ -90,25 +268,16 @@ void World::buildInitialPosition() {
 
 void World::resetWorldData() { chunckManager.clearAllChunks(); }
 
-const std::vector<Block*> World::getLoadedBlocks() {
-  loadedBlocks.clear();
-  loadedBlocks.shrink_to_fit();
-  const auto& visibleChuncks = chunckManager.getVisibleChunks();
-  for (u16 i = 0; i < visibleChuncks.size(); i++) {
-    for (u16 j = 0; j < visibleChuncks[i]->blocks.size(); j++)
-      loadedBlocks.push_back(visibleChuncks[i]->blocks[j]);
-  }
-  return loadedBlocks;
-}
-
 void World::updateChunkByPlayerPosition(Player* t_player) {
   Vec4 currentPlayerPos = *t_player->getPosition();
   if (lastPlayerPosition.distanceTo(currentPlayerPos) > CHUNCK_SIZE) {
     lastPlayerPosition.set(currentPlayerPos);
-    Chunck* currentChunck = chunckManager.getChunckByPosition(currentPlayerPos);
+    Chunck* currentChunck =
+        chunckManager.getOrCreateChunckByPosition(currentPlayerPos);
 
     if (currentChunck && t_player->currentChunckId != currentChunck->id) {
       t_player->currentChunckId = currentChunck->id;
+      ensureTerrainAround(currentPlayerPos);
       scheduleChunksNeighbors(currentChunck, currentPlayerPos);
     }
   }
@@ -120,104 +289,91 @@ void World::updateChunkByPlayerPosition(Player* t_player) {
 }
 
 void World::reloadWorldArea(const Vec4& position) {
-  Chunck* currentChunck = chunckManager.getChunckByPosition(position);
+  ensureTerrainAround(position);
+  Chunck* currentChunck = chunckManager.getOrCreateChunckByPosition(position);
   if (currentChunck) {
     buildChunk(currentChunck);
     scheduleChunksNeighbors(currentChunck, position, true);
   }
 }
 
-void World::updateNeighBorsChunksByModdedPosition(const Vec4& pos) {
-  Chunck* currentChunk = chunckManager.getChunckByOffset(pos);
-  if (!currentChunk) return;
-
-  const u8 isAtBorder = isBlockAtChunkBorder(&pos, currentChunk->minOffset,
-                                             currentChunk->maxOffset);
-
-  if (isAtBorder) {
-    if (currentChunk->maxOffset->z - 1 == pos.z) {
-      // Left
-      Chunck* leftChunk =
-          chunckManager.getChunckByOffset(Vec4(pos.x, pos.y, pos.z + 1));
-      if (leftChunk && leftChunk->id != currentChunk->id) {
-        leftChunk->clear();
-        buildChunk(leftChunk);
-      }
-    } else if (currentChunk->minOffset->z == pos.z) {
-      // Right
-      Chunck* rightChunk =
-          chunckManager.getChunckByOffset(Vec4(pos.x, pos.y, pos.z - 1));
-
-      if (rightChunk && rightChunk->id != currentChunk->id) {
-        rightChunk->clear();
-        buildChunk(rightChunk);
-      }
-    }
-
-    if (currentChunk->maxOffset->x - 1 == pos.x) {
-      // Front
-      Chunck* frontChunk =
-          chunckManager.getChunckByOffset(Vec4(pos.x + 1, pos.y, pos.z));
-
-      if (frontChunk && frontChunk->id != currentChunk->id) {
-        frontChunk->clear();
-        buildChunk(frontChunk);
-      }
-    } else if (currentChunk->minOffset->x == pos.x) {
-      // Back
-      Chunck* backChunk =
-          chunckManager.getChunckByOffset(Vec4(pos.x - 1, pos.y, pos.z));
-      if (backChunk && backChunk->id != currentChunk->id) {
-        backChunk->clear();
-        buildChunk(backChunk);
-      }
-    }
-
-    if (currentChunk->maxOffset->y - 1 == pos.y) {
-      // Top
-      Chunck* topChunk =
-          chunckManager.getChunckByOffset(Vec4(pos.x, pos.y + 1, pos.z));
+void World::updateLightByModdedPosition(const Vec4& pos,
+                                        const u8& previousBlock) {
+  lightEngine.updateBlock(terrain, pos.x, pos.y, pos.z, previousBlock);
+  rebuildDirtyChunks();
+}
 
-      if (topChunk && topChunk->id != currentChunk->id) {
-        topChunk->clear();
-        buildChunk(topChunk);
-      }
-    } else if (currentChunk->minOffset->y == pos.y) {
-      // Bottom
-      Chunck* bottomChunk =
-          chunckManager.getChunckByOffset(Vec4(pos.x, pos.y - 1, pos.z));
-
-      if (bottomChunk && bottomChunk->id != currentChunk->id) {
-        bottomChunk->clear();
-        buildChunk(bottomChunk);
-      }
+void World::rebuildDirtyChunks() {
+  // Too many chunks changed to list them, rebuild everything loaded
+  if (lightEngine.hasDirtyChunksOverflow()) {
+    for (Chunck* chunck : chunckManager.getChuncks())
+      rebuildChunkIfLoaded(chunck);
+  } else {
+    u16 x, y, z;
+    for (u16 i = 0; i < lightEngine.getDirtyChunksCount(); i++) {
+      lightEngine.getDirtyChunk(i, &x, &y, &z);
+      rebuildChunkIfLoaded(chunckManager.getChunckByGridPosition(x, y, z));
     }
   }
 
-  currentChunk->clear();
-  buildChunk(currentChunk);
+  lightEngine.clearDirtyChunks();
+}
+
+void World::rebuildChunkIfLoaded(Chunck* t_chunck) {
+  // Clean chunks will get the change when they are scheduled to load
+  if (!t_chunck || t_chunck->state != ChunkState::Loaded) return;
+  t_chunck->clear();
+  buildChunk(t_chunck);
 }
 
 void World::scheduleChunksNeighbors(Chunck* t_chunck,
                                     const Vec4 currentPlayerPos,
                                     u8 force_loading) {
-  const auto& chuncks = chunckManager.getChuncks();
+  const int drawDistance = worldOptions.drawDistance;
+
+  // Unload the far chunks, and release them once cleaned and out of reach
+  const std::vector<Chunck*> chuncks = chunckManager.getChuncks();
   for (u16 i = 0; i < chuncks.size(); i++) {
     float distance =
         floor(t_chunck->center->distanceTo(*chuncks[i]->center) / CHUNCK_SIZE) +
         1;
 
-    if (distance > worldOptions.drawDistance) {
-      if (force_loading)
-        chuncks[i]->clear();
-      else if (chuncks[i]->state != ChunkState::Clean)
-        addChunkToUnloadAsync(chuncks[i]);
-    } else {
-      if (force_loading) {
-        chuncks[i]->clear();
-        buildChunkAsync(chuncks[i], worldOptions.drawDistance);
-      } else if (chuncks[i]->state != ChunkState::Loaded) {
-        addChunkToLoadAsync(chuncks[i]);
+    if (distance <= drawDistance) continue;
+
+    if (force_loading)
+      chuncks[i]->clear();
+    else if (chuncks[i]->state != ChunkState::Clean)
+      addChunkToUnloadAsync(chuncks[i]);
+
+    if (distance > drawDistance + 1 && chuncks[i]->state == ChunkState::Clean)
+      releaseChunk(chuncks[i]);
+  }
+
+  // Create and load the chunks in draw distance
+  const int chunckX = t_chunck->minOffset->x / CHUNCK_SIZE;
+  const int chunckY = t_chunck->minOffset->y / CHUNCK_SIZE;
+  const int chunckZ = t_chunck->minOffset->z / CHUNCK_SIZE;
+  const int chuncksY = terrain->height / CHUNCK_SIZE;
+
+  for (int x = chunckX - drawDistance; x <= chunckX + drawDistance; x++) {
+    for (int z = chunckZ - drawDistance; z <= chunckZ + drawDistance; z++) {
+      for (int y = 0; y < chuncksY; y++) {
+        const int dx = x - chunckX;
+        const int dy = y - chunckY;
+        const int dz = z - chunckZ;
+        float distance = floor(sqrtf(dx * dx + dy * dy + dz * dz)) + 1;
+        if (distance > drawDistance) continue;
+
+        Chunck* chunck =
+            chunckManager.getOrCreateChunckByGridPosition(x, y, z);
+        if (!chunck) continue;
+
+        if (force_loading) {
+          chunck->clear();
+          buildChunk(chunck);
+        } else if (chunck->state != ChunkState::Loaded) {
+          addChunkToLoadAsync(chunck);
+        }
       }
     }
   }
@@ -225,6 +381,18 @@ void World::scheduleChunksNeighbors(Chunck* t_chunck,
   if (tempChuncksToLoad.size()) sortChunksToLoad(currentPlayerPos);
 }
 
+void World::releaseChunk(Chunck* t_chunck) {
+  for (size_t i = 0; i < tempChuncksToLoad.size(); i++)
+    if (tempChuncksToLoad[i] == t_chunck)
+      tempChuncksToLoad.erase(tempChuncksToLoad.begin() + i--);
+
+  for (size_t i = 0; i < tempChuncksToUnLoad.size(); i++)
+    if (tempChuncksToUnLoad[i] == t_chunck)
+      tempChuncksToUnLoad.erase(tempChuncksToUnLoad.begin() + i--);
+
+  chunckManager.releaseChunck(t_chunck);
+}
+
 void World::sortChunksToLoad(const Vec4& currentPlayerPos) {
   std::sort(tempChuncksToLoad.begin(), tempChuncksToLoad.end(),
             [currentPlayerPos](const Chunck* a, const Chunck* b) {
@@ -239,12 +407,13 @@ void World::sortChunksToLoad(const Vec4& currentPlayerPos) {
 void World::loadScheduledChunks() {
   if (tempChuncksToLoad.size() > 0) {
     if (tempChuncksToLoad[0]->state != ChunkState::Loaded)
-      return buildChunkAsync(tempChuncksToLoad[0], worldOptions.drawDistance);
+      buildChunk(tempChuncksToLoad[0]);
     tempChuncksToLoad.erase(tempChuncksToLoad.begin());
   };
 }
 
 void World::unloadScheduledChunks() {
+  ProfilerScope profile(ProfilerStage::ChunksUnload);
   const size_t size = tempChuncksToUnLoad.size();
   const u8 limit = 2;
   u8 counter = 0;
@@ -329,76 +498,7 @@ void World::updateLightModel() {
   worldLightModel.moonPosition.set(dayNightCycleManager.getMoonPosition());
   worldLightModel.ambientLightIntensity =
       dayNightCycleManager.getAmbientLightIntesity();
-}
-
-unsigned int World::getIndexByOffset(int x, int y, int z) {
-  return (y * terrain->length * terrain->width) + (z * terrain->width) + x;
-}
-
-bool World::isBlockTransparentAtPosition(const float& x, const float& y,
-                                         const float& z) {
-  if (BoundCheckMap(terrain, x, y, z)) {
-    const u8 blockType = GetBlockFromMap(terrain, x, y, z);
-    return blockType <= (u8)Blocks::AIR_BLOCK ||
-           blockManager.isBlockTransparent(static_cast<Blocks>(blockType));
-  } else {
-    return false;
-  }
-}
-
-bool World::isTopFaceVisible(const Vec4* t_blockOffset) {
-  return isBlockTransparentAtPosition(t_blockOffset->x, t_blockOffset->y + 1,
-                                      t_blockOffset->z);
-}
-
-bool World::isBottomFaceVisible(const Vec4* t_blockOffset) {
-  return isBlockTransparentAtPosition(t_blockOffset->x, t_blockOffset->y - 1,
-                                      t_blockOffset->z);
-}
-
-bool World::isFrontFaceVisible(const Vec4* t_blockOffset) {
-  return isBlockTransparentAtPosition(t_blockOffset->x - 1, t_blockOffset->y,
-                                      t_blockOffset->z);
-}
-
-bool World::isBackFaceVisible(const Vec4* t_blockOffset) {
-  return isBlockTransparentAtPosition(t_blockOffset->x + 1, t_blockOffset->y,
-                                      t_blockOffset->z);
-}
-
-bool World::isLeftFaceVisible(const Vec4* t_blockOffset) {
-  return isBlockTransparentAtPosition(t_blockOffset->x, t_blockOffset->y,
-                                      t_blockOffset->z - 1);
-}
-
-bool World::isRightFaceVisible(const Vec4* t_blockOffset) {
-  return isBlockTransparentAtPosition(t_blockOffset->x, t_blockOffset->y,
-                                      t_blockOffset->z + 1);
-}
-
-int World::getBlockVisibleFaces(const Vec4* t_blockOffset) {
-  int result = 0x000000;
-
-  // Front
-  if (isFrontFaceVisible(t_blockOffset)) result = result | FRONT_VISIBLE;
-
-  // Back
-  if (isBackFaceVisible(t_blockOffset)) result = result | BACK_VISIBLE;
-
-  // Right
-  if (isRightFaceVisible(t_blockOffset)) result = result | RIGHT_VISIBLE;
-
-  // Left
-  if (isLeftFaceVisible(t_blockOffset)) result = result | LEFT_VISIBLE;
-
-  // Top
-  if (isTopFaceVisible(t_blockOffset)) result = result | TOP_VISIBLE;
-
-  // Bottom
-  if (isBottomFaceVisible(t_blockOffset)) result = result | BOTTOM_VISIBLE;
-
-  // printf("Result for index %i -> 0x%X\n", blockIndex, result);
-  return result;
+  worldLightModel.skyLightLevel = dayNightCycleManager.getSkyLightLevel();
 }
 
 void World::calcRawBlockBBox(MinecraftPipeline* mcPip) {
@@ -420,11 +520,15 @@ const Vec4 World::calcSpawOffset(int bias) {
   bool found = false;
   u8 airBlockCounter = 0;
   // Pick a X and Z coordinates based on the seed;
-  int posX = ((seed + bias) % HALF_OVERWORLD_H_DISTANCE);
-  int posZ = ((seed - bias) % HALF_OVERWORLD_H_DISTANCE);
+  const int origin = terrain->pager ? PAGED_WORLD_ORIGIN : 0;
+  int posX = origin + ((seed + bias) % HALF_OVERWORLD_H_DISTANCE);
+  int posZ = origin + ((seed - bias) % HALF_OVERWORLD_H_DISTANCE);
   Vec4 result;
 
-  for (int posY = OVERWORLD_MAX_HEIGH; posY >= OVERWORLD_MIN_HEIGH; posY--) {
+  if (terrain->pager) EnsureMapRegions(terrain, posX, posZ, 0);
+  ensureTerrainColumns(posX, posZ, posX, posZ);
+
+  for (int posY = terrain->height - 1; posY >= OVERWORLD_MIN_HEIGH; posY--) {
     u8 type = GetBlockFromMap(terrain, posX, posY, posZ);
     if (type != (u8)Blocks::AIR_BLOCK && airBlockCounter >= 4) {
       found = true;
@@ -445,41 +549,18 @@ const Vec4 World::calcSpawOffset(int bias) {
 }
 
 void World::removeBlock(Block* blockToRemove) {
+  const u8 previousBlock =
+      GetBlockFromMap(terrain, blockToRemove->offset.x, blockToRemove->offset.y,
+                      blockToRemove->offset.z);
   SetBlockInMap(terrain, blockToRemove->offset.x, blockToRemove->offset.y,
                 blockToRemove->offset.z, (u8)Blocks::AIR_BLOCK);
-  updateNeighBorsChunksByModdedPosition(blockToRemove->offset);
+  updateLightByModdedPosition(blockToRemove->offset, previousBlock);
   // playDestroyBlockSound(blockToRemove->type);
 }
 
 void World::putBlock(const Blocks& blockToPlace, Player* t_player) {
-  Vec4 targetPos = ray.at(targetBlock->distance);
-  Vec4 blockOffset = Vec4(targetBlock->offset);
-
-  // Front
-  if (std::round(targetPos.z) ==
-      targetBlock->bbox->getFrontFace().axisPosition) {
-    blockOffset.z++;
-    // Back
-  } else if (std::round(targetPos.z) ==
-             targetBlock->bbox->getBackFace().axisPosition) {
-    blockOffset.z--;
-    // Right
-  } else if (std::round(targetPos.x) ==
-             targetBlock->bbox->getRightFace().axisPosition) {
-    blockOffset.x++;
-    // Left
-  } else if (std::round(targetPos.x) ==
-             targetBlock->bbox->getLeftFace().axisPosition) {
-    blockOffset.x--;
-    // Up
-  } else if (std::round(targetPos.y) ==
-             targetBlock->bbox->getTopFace().axisPosition) {
-    blockOffset.y++;
-    // Down
-  } else if (std::round(targetPos.y) ==
-             targetBlock->bbox->getBottomFace().axisPosition) {
-    blockOffset.y--;
-  }
+  // Place against the face hit by the target raycast
+  Vec4 blockOffset = targetBlock->offset + targetBlockNormal;
 
   // Is a valid index?
   if (BoundCheckMap(terrain, blockOffset.x, blockOffset.y, blockOffset.z)) {
@@ -514,12 +595,11 @@ void World::putBlock(const Blocks& blockToPlace, Player* t_player) {
     if (blockType == (u8)Blocks::AIR_BLOCK) {
       SetBlockInMap(terrain, blockOffset.x, blockOffset.y, blockOffset.z,
                     (u8)blockToPlace);
+      updateLightByModdedPosition(blockOffset, blockType);
     }
 
     // playPutBlockSound(blockToPlace);
   }
-
-  updateNeighBorsChunksByModdedPosition(blockOffset);
 }
 
 void World::stopBreakTargetBlock() {
@@ -597,514 +677,138 @@ void World::playBreakingBlockSound(const Blocks& blockType) {
   }
 }
 
-u8 World::isBlockAtChunkBorder(const Vec4* blockOffset,
-                               const Vec4* chunkMinOffset,
-                               const Vec4* chunkMaxOffset) {
-  return blockOffset->y == chunkMinOffset->y ||
-         blockOffset->y == chunkMaxOffset->y - 1 ||
-         blockOffset->x == chunkMinOffset->x ||
-         blockOffset->x == chunkMaxOffset->x - 1 ||
-         blockOffset->z == chunkMinOffset->z ||
-         blockOffset->z == chunkMaxOffset->z - 1;
-}
-
 void World::buildChunk(Chunck* t_chunck) {
-  for (size_t x = t_chunck->minOffset->x; x < t_chunck->maxOffset->x; x++) {
-    for (size_t z = t_chunck->minOffset->z; z < t_chunck->maxOffset->z; z++) {
-      for (size_t y = t_chunck->minOffset->y; y < t_chunck->maxOffset->y; y++) {
-        unsigned int blockIndex = getIndexByOffset(x, y, z);
-        u8 block_type = GetBlockFromMap(terrain, x, y, z);
-
-        if (block_type <= (u8)Blocks::AIR_BLOCK ||
-            !BoundCheckMap(terrain, x, y, z))
-          continue;
-
-        Vec4 tempBlockOffset = Vec4(x, y, z);
-        Vec4 blockPosition = (tempBlockOffset * DUBLE_BLOCK_SIZE);
-
-        const int visibleFaces = getBlockVisibleFaces(&tempBlockOffset);
-        const bool isVisible = visibleFaces > 0;
-
-        // Are block's coordinates in world range?
-        if (isVisible) {
-          BlockInfo* blockInfo =
-              blockManager.getBlockInfoByType(static_cast<Blocks>(block_type));
-          if (blockInfo) {
-            Block* block = new Block(blockInfo);
-            block->index = blockIndex;
-            block->offset.set(tempBlockOffset);
-            block->chunkId = t_chunck->id;
-            block->visibleFaces = visibleFaces;
-            block->isAtChunkBorder = isBlockAtChunkBorder(
-                &tempBlockOffset, t_chunck->minOffset, t_chunck->maxOffset);
-
-            block->setPosition(blockPosition);
-            block->scale.scale(BLOCK_SIZE);
-            block->updateModelMatrix();
-
-            // Calc min and max corners
-            {
-              BBox tempBBox = rawBlockBbox->getTransformed(block->model);
-              block->bbox = new BBox(tempBBox);
-              block->bbox->getMinMax(&block->minCorner, &block->maxCorner);
-            }
-
-            t_chunck->addBlock(block);
-          }
-        }
-      }
-    }
-  }
-
-  t_chunck->state = ChunkState::Loaded;
-  t_chunck->loadDrawData();
-}
-
-void World::buildChunkAsync(Chunck* t_chunck, const u8& loading_speed) {
-  uint16_t safeWhileBreak = 0;
-  uint16_t batchCounter = 0;
-  uint16_t x = t_chunck->tempLoadingOffset->x;
-  uint16_t y = t_chunck->tempLoadingOffset->y;
-  uint16_t z = t_chunck->tempLoadingOffset->z;
-
-  while (batchCounter < LOAD_CHUNK_BATCH * loading_speed) {
-    if (x >= t_chunck->maxOffset->x) break;
-    safeWhileBreak++;
-
-    unsigned int blockIndex = getIndexByOffset(x, y, z);
-    u8 block_type = GetBlockFromMap(terrain, x, y, z);
-    if (block_type > (u8)Blocks::AIR_BLOCK &&
-        block_type < (u8)Blocks::TOTAL_OF_BLOCKS) {
-      Vec4 tempBlockOffset = Vec4(x, y, z);
-      Vec4 blockPosition = (tempBlockOffset * DUBLE_BLOCK_SIZE);
-
-      const int visibleFaces = getBlockVisibleFaces(&tempBlockOffset);
-      const bool isVisible = visibleFaces > 0;
-
-      // Are block's coordinates in world range?
-      if (isVisible && BoundCheckMap(terrain, x, y, z)) {
-        BlockInfo* blockInfo =
-            blockManager.getBlockInfoByType(static_cast<Blocks>(block_type));
-
-        if (blockInfo) {
-          Block* block = new Block(blockInfo);
-          block->index = blockIndex;
-          block->offset.set(tempBlockOffset);
-          block->chunkId = t_chunck->id;
-          block->visibleFaces = visibleFaces;
-          block->isAtChunkBorder = isBlockAtChunkBorder(
-              &tempBlockOffset, t_chunck->minOffset, t_chunck->maxOffset);
-
-          block->setPosition(blockPosition);
-          block->scale.scale(BLOCK_SIZE);
-          block->updateModelMatrix();
-
-          // Calc min and max corners
-          {
-            BBox tempBBox = rawBlockBbox->getTransformed(block->model);
-            block->bbox = new BBox(tempBBox);
-            block->bbox->getMinMax(&block->minCorner, &block->maxCorner);
-          }
-
-          t_chunck->addBlock(block);
-        }
-        batchCounter++;
-      }
-    }
-
-    y++;
-    if (y >= t_chunck->maxOffset->y) {
-      y = t_chunck->minOffset->y;
-      z++;
-    }
-    if (z >= t_chunck->maxOffset->z) {
-      z = t_chunck->minOffset->z;
-      x++;
-    }
-
-    if (safeWhileBreak > CHUNCK_LENGTH) break;
-  }
-
-  if (batchCounter >= LOAD_CHUNK_BATCH * loading_speed) {
-    t_chunck->tempLoadingOffset->set(x, y, z);
-    return;
-  }
-
+  ProfilerScope profile(ProfilerStage::ChunksLoad);
+  // The mesh looks into the cells around the chunk
+  ensureTerrainColumns(t_chunck->minOffset->x - 1, t_chunck->minOffset->z - 1,
+                       t_chunck->maxOffset->x, t_chunck->maxOffset->z);
   t_chunck->state = ChunkState::Loaded;
-  t_chunck->loadDrawData();
+  t_chunck->loadDrawData(terrain, &chunckMeshBuilder);
 }
 
-void World::updateTargetBlock(const Vec4& camLookPos, const Vec4& camPosition,
-                              const std::vector<Chunck*>& chuncks) {
-  u8 hitedABlock = 0;
-  float tempTargetDistance = -1.0f;
-  float tempPlayerDistance = -1.0f;
-  Block* tempTargetBlock = nullptr;
-
-  // Reset the current target block;
-  targetBlock = nullptr;
+void World::updateTargetBlock(const Vec4& camLookPos,
+                              const Vec4& camPosition) {
+  ProfilerScope profile(ProfilerStage::TargetBlock);
 
   // Prepate the raycast
   Vec4 rayDir = camLookPos - camPosition;
   rayDir.normalize();
-  ray.origin.set(camPosition);
-  ray.direction.set(rayDir);
-
-  for (u16 h = 0; h < chuncks.size(); h++) {
-    for (u16 i = 0; i < chuncks[h]->blocks.size(); i++) {
-      float distanceFromCurrentBlockToPlayer =
-          camPosition.distanceTo(*chuncks[h]->blocks[i]->getPosition());
-
-      if (distanceFromCurrentBlockToPlayer <= MAX_RANGE_PICKER) {
-        // Reset block state
-        chuncks[h]->blocks[i]->isTarget = 0;
-        chuncks[h]->blocks[i]->distance = -1.0f;
-
-        float intersectionPoint;
-        if (ray.intersectBox(chuncks[h]->blocks[i]->minCorner,
-                             chuncks[h]->blocks[i]->maxCorner,
-                             &intersectionPoint)) {
-          hitedABlock = 1;
-          if (tempTargetDistance == -1.0f ||
-              (distanceFromCurrentBlockToPlayer < tempPlayerDistance)) {
-            tempTargetBlock = chuncks[h]->blocks[i];
-            tempTargetDistance = intersectionPoint;
-            tempPlayerDistance = distanceFromCurrentBlockToPlayer;
-          }
-        }
-      }
-    }
-  }
 
-  if (hitedABlock) {
-    targetBlock = tempTargetBlock;
-    targetBlock->isTarget = 1;
-    targetBlock->distance = tempTargetDistance;
-  }
-}
+  const float origin[3] = {camPosition.x, camPosition.y, camPosition.z};
+  const float direction[3] = {rayDir.x, rayDir.y, rayDir.z};
 
-void World::setDrawDistace(const u8& drawDistanceInChunks) {
-  if (drawDistanceInChunks >= MIN_DRAW_DISTANCE &&
-      drawDistanceInChunks <= MAX_DRAW_DISTANCE) {
-    worldOptions.drawDistance = drawDistanceInChunks;
-    Chunck* currentChunck =
-        chunckManager.getChunckByPosition(lastPlayerPosition);
-    if (currentChunck)
-      scheduleChunksNeighbors(currentChunck, lastPlayerPosition, true);
+  LevelMapRayHit hit;
+  if (RaycastMap(terrain, origin, direction, MAX_RANGE_PICKER,
+                 DUBLE_BLOCK_SIZE, (u8)Blocks::AIR_BLOCK, &hit)) {
+    targetBlockNormal.set(hit.normalX, hit.normalY, hit.normalZ, 0.0F);
+    return setTargetBlock(Vec4(hit.x, hit.y, hit.z), hit.block, hit.distance);
   }
-}
 
-// From CrossCraft
-struct LightNode {
-  uint16_t x, y, z;
-  LightNode(uint16_t lx, uint16_t ly, uint16_t lz, uint16_t l)
-      : x(lx), y(ly), z(lz), val(l) {}
-  uint16_t val;
-};
-
-std::queue<LightNode> lightBfsQueue;
-std::queue<LightNode> lightRemovalBfsQueue;
-
-std::queue<LightNode> sunlightBfsQueue;
-std::queue<LightNode> sunlightRemovalBfsQueue;
-
-auto encodeID(uint16_t x, uint16_t z) -> uint32_t {
-  uint16_t nx = x / 16;
-  uint16_t ny = z / 16;
-  uint32_t id = nx << 16 | (ny & 0xFFFF);
-  return id;
-}
-
-void checkAddID(uint32_t* updateIDs, uint32_t id) {
-  // Check that the ID is not already existing
-  for (int i = 0; i < 10; i++) {
-    if (id == updateIDs[i]) return;
-  }
-
-  // Find a slot to insert.
-  for (int i = 0; i < 10; i++) {
-    if (updateIDs[i] == 0xFFFFFFFF) {
-      updateIDs[i] = id;
-      return;
-    }
-  }
-}
-
-void updateID(uint16_t x, uint16_t z, uint32_t* updateIDs) {
-  checkAddID(updateIDs, encodeID(x, z));
-}
-
-void propagate(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel,
-               uint32_t* updateIDs) {
-  auto map = CrossCraft_World_GetMapPtr();
-  if (!BoundCheckMap(map, x, y, z)) return;
-
-  updateID(x, z, updateIDs);
-
-  auto blk = GetBlockFromMap(map, x, y, z);
-
-  if ((blk == 0 || blk == 20 || blk == 18 || (blk >= 8 && blk <= 11) ||
-       (blk >= 37 && blk <= 40)) &&
-      GetLightFromMap(map, x, y, z) + 2 <= lightLevel) {
-    if (blk == 18 || (blk >= 8 && blk <= 11) || (blk >= 37 && blk <= 40)) {
-      lightLevel -= 2;
-    }
-    SetLightInMap(map, x, y, z, lightLevel - 1);
-    lightBfsQueue.emplace(x, y, z, 0);
-  }
+  clearTargetBlock();
 }
 
-void propagate(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel) {
-  auto map = CrossCraft_World_GetMapPtr();
-  if (!BoundCheckMap(map, x, y, z)) return;
-
-  if (GetBlockFromMap(map, x, y, z) == 0 &&
-      GetLightFromMap(map, x, y, z) + 2 <= lightLevel) {
-    SetLightInMap(map, x, y, z, lightLevel - 1);
-    sunlightBfsQueue.emplace(x, y, z, 0);
+void World::setTargetBlock(const Vec4& blockOffset, const u8& blockType,
+                           const float& distance) {
+  if (targetBlock && targetBlock->offset.x == blockOffset.x &&
+      targetBlock->offset.y == blockOffset.y &&
+      targetBlock->offset.z == blockOffset.z &&
+      (u8)targetBlock->type == blockType) {
+    targetBlock->distance = distance;
+    return;
   }
-}
-
-void propagateRemove(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel,
-                     uint32_t* updateIDs) {
-  auto map = CrossCraft_World_GetMapPtr();
-  if (!BoundCheckMap(map, x, y, z)) return;
-
-  auto neighborLevel = GetLightFromMap(map, x, y, z);
-
-  updateID(x, z, updateIDs);
 
-  if (neighborLevel != 0 && neighborLevel < lightLevel) {
-    SetLightInMap(map, x, y, z, 0);
-    lightRemovalBfsQueue.emplace(x, y, z, neighborLevel);
-  } else if (neighborLevel >= lightLevel) {
-    lightBfsQueue.emplace(x, y, z, 0);
-  }
-}
+  BlockInfo* blockInfo =
+      blockManager.getBlockInfoByType(static_cast<Blocks>(blockType));
+  if (!blockInfo) return clearTargetBlock();
 
-void propagateRemove(uint16_t x, uint16_t y, uint16_t z, uint16_t lightLevel) {
-  auto map = CrossCraft_World_GetMapPtr();
-  if (!BoundCheckMap(map, x, y, z)) return;
+  clearTargetBlock();
 
-  auto neighborLevel = GetLightFromMap(map, x, y, z);
+  targetBlock = new Block(blockInfo);
+  targetBlock->offset.set(blockOffset);
+  targetBlock->setPosition(blockOffset * DUBLE_BLOCK_SIZE);
+  targetBlock->scale.scale(BLOCK_SIZE);
+  targetBlock->updateModelMatrix();
 
-  if (neighborLevel != 0 && neighborLevel < lightLevel) {
-    SetLightInMap(map, x, y, z, 0);
-    sunlightRemovalBfsQueue.emplace(x, y, z, neighborLevel);
-  } else if (neighborLevel >= lightLevel) {
-    sunlightBfsQueue.emplace(x, y, z, 0);
-  }
-}
+  BBox tempBBox = rawBlockBbox->getTransformed(targetBlock->model);
+  targetBlock->bbox = new BBox(tempBBox);
+  targetBlock->bbox->getMinMax(&targetBlock->minCorner,
+                               &targetBlock->maxCorner);
 
-void updateRemove(uint32_t* updateIDs) {
-  while (!lightRemovalBfsQueue.empty()) {
-    auto node = lightRemovalBfsQueue.front();
-
-    uint16_t nx = node.x;
-    uint16_t ny = node.y;
-    uint16_t nz = node.z;
-    uint8_t lightLevel = node.val;
-    lightRemovalBfsQueue.pop();
-
-    propagateRemove(nx + 1, ny, nz, lightLevel, updateIDs);
-    propagateRemove(nx - 1, ny, nz, lightLevel, updateIDs);
-    propagateRemove(nx, ny + 1, nz, lightLevel, updateIDs);
-    propagateRemove(nx, ny - 1, nz, lightLevel, updateIDs);
-    propagateRemove(nx, ny, nz + 1, lightLevel, updateIDs);
-    propagateRemove(nx, ny, nz - 1, lightLevel, updateIDs);
-  }
+  targetBlock->isTarget = 1;
+  targetBlock->distance = distance;
 }
 
-void updateRemove() {
-  while (!lightRemovalBfsQueue.empty()) {
-    auto node = lightRemovalBfsQueue.front();
-
-    uint16_t nx = node.x;
-    uint16_t ny = node.y;
-    uint16_t nz = node.z;
-    uint8_t lightLevel = node.val;
-    lightRemovalBfsQueue.pop();
-
-    propagateRemove(nx + 1, ny, nz, lightLevel);
-    propagateRemove(nx - 1, ny, nz, lightLevel);
-    propagateRemove(nx, ny + 1, nz, lightLevel);
-    propagateRemove(nx, ny - 1, nz, lightLevel);
-    propagateRemove(nx, ny, nz + 1, lightLevel);
-    propagateRemove(nx, ny, nz - 1, lightLevel);
-  }
+void World::clearTargetBlock() {
+  if (targetBlock) delete targetBlock;
+  targetBlock = nullptr;
 }
 
-void updateSpread(uint32_t* updateIDs) {
-  while (!lightBfsQueue.empty()) {
-    auto node = lightBfsQueue.front();
-
-    uint16_t nx = node.x;
-    uint16_t ny = node.y;
-    uint16_t nz = node.z;
-    uint8_t lightLevel =
-        GetLightFromMap(CrossCraft_World_GetMapPtr(), nx, ny, nz);
-    lightBfsQueue.pop();
-
-    propagate(nx + 1, ny, nz, lightLevel, updateIDs);
-    propagate(nx - 1, ny, nz, lightLevel, updateIDs);
-    propagate(nx, ny + 1, nz, lightLevel, updateIDs);
-    propagate(nx, ny - 1, nz, lightLevel, updateIDs);
-    propagate(nx, ny, nz + 1, lightLevel, updateIDs);
-    propagate(nx, ny, nz - 1, lightLevel, updateIDs);
+void World::setDrawDistace(const u8& drawDistanceInChunks) {
+  if (drawDistanceInChunks >= MIN_DRAW_DISTANCE &&
+      drawDistanceInChunks <= MAX_DRAW_DISTANCE) {
+    worldOptions.drawDistance = drawDistanceInChunks;
+    ensureTerrainAround(lastPlayerPosition);
+    Chunck* currentChunck =
+        chunckManager.getOrCreateChunckByPosition(lastPlayerPosition);
+    if (currentChunck)
+      scheduleChunksNeighbors(currentChunck, lastPlayerPosition, true);
   }
 }
 
-void updateSpread() {
-  while (!lightBfsQueue.empty()) {
-    auto node = lightBfsQueue.front();
-
-    uint16_t nx = node.x;
-    uint16_t ny = node.y;
-    uint16_t nz = node.z;
-    uint8_t lightLevel =
-        GetLightFromMap(CrossCraft_World_GetMapPtr(), nx, ny, nz);
-    lightBfsQueue.pop();
-
-    propagate(nx + 1, ny, nz, lightLevel);
-    propagate(nx - 1, ny, nz, lightLevel);
-    propagate(nx, ny + 1, nz, lightLevel);
-    propagate(nx, ny - 1, nz, lightLevel);
-    propagate(nx, ny, nz + 1, lightLevel);
-    propagate(nx, ny, nz - 1, lightLevel);
-  }
-}
+void World::setGreedyMeshing(const u8& enabled) {
+  if (worldOptions.greedyMeshing == enabled) return;
 
-void updateSunlight() {
-  while (!sunlightBfsQueue.empty()) {
-    auto node = sunlightBfsQueue.front();
-
-    uint16_t nx = node.x;
-    uint16_t ny = node.y;
-    uint16_t nz = node.z;
-    int8_t lightLevel = node.val - 1;
-    sunlightBfsQueue.pop();
-    if (lightLevel <= 0) continue;
-
-    propagate(nx + 1, ny, nz, lightLevel);
-    propagate(nx - 1, ny, nz, lightLevel);
-    propagate(nx, ny + 1, nz, lightLevel);
-    propagate(nx, ny - 1, nz, lightLevel);
-    propagate(nx, ny, nz + 1, lightLevel);
-    propagate(nx, ny, nz - 1, lightLevel);
-  }
-}
+  worldOptions.greedyMeshing = enabled;
+  chunckMeshBuilder.setGreedyMeshing(enabled);
 
-void updateSunlightRemove() {
-  while (!sunlightRemovalBfsQueue.empty()) {
-    auto node = sunlightRemovalBfsQueue.front();
-
-    uint16_t nx = node.x;
-    uint16_t ny = node.y;
-    uint16_t nz = node.z;
-    int8_t lightLevel = node.val;
-    sunlightRemovalBfsQueue.pop();
-    if (lightLevel <= 0) continue;
-
-    propagateRemove(nx + 1, ny, nz, lightLevel);
-    propagateRemove(nx - 1, ny, nz, lightLevel);
-    propagateRemove(nx, ny + 1, nz, lightLevel);
-    propagateRemove(nx, ny - 1, nz, lightLevel);
-    propagateRemove(nx, ny, nz + 1, lightLevel);
-    propagateRemove(nx, ny, nz - 1, lightLevel);
+  std::vector<Chunck*>& chuncks = chunckManager.getChuncks();
+  for (size_t i = 0; i < chuncks.size(); i++) {
+    if (chuncks[i]->isDrawDataLoaded())
+      chuncks[i]->loadDrawData(terrain, &chunckMeshBuilder);
   }
 }
 
-void CrossCraft_World_AddLight(uint16_t x, uint16_t y, uint16_t z,
-                               uint16_t light, uint32_t* updateIDs) {
-  SetLightInMap(CrossCraft_World_GetMapPtr(), x, y, z, light);
-  updateID(x, z, updateIDs);
-  lightBfsQueue.emplace(x, y, z, light);
-
-  updateSpread(updateIDs);
-}
-
-void CrossCraft_World_RemoveLight(uint16_t x, uint16_t y, uint16_t z,
-                                  uint16_t light, uint32_t* updateIDs) {
-  auto map = CrossCraft_World_GetMapPtr();
-
-  auto val = GetLightFromMap(map, x, y, z);
-  lightRemovalBfsQueue.emplace(x, y, z, val);
-
-  SetLightInMap(map, x, y, z, light);
-  updateID(x, z, updateIDs);
-
-  updateRemove(updateIDs);
-  updateSpread(updateIDs);
-}
-
-void singleCheck(uint16_t x, uint16_t y, uint16_t z) {
-  auto map = CrossCraft_World_GetMapPtr();
-
-  if (y == 0) return;
-
-  auto lv = 15;
-  for (int y2 = map->height - 1; y2 >= 0; y2--) {
-    auto blk = GetBlockFromMap(map, x, y2, z);
-
-    if (blk == 18 || (blk >= 37 && blk <= 40) || (blk >= 8 && blk <= 11)) {
-      lv -= 2;
-    } else if (blk != 0 && blk != 20) {
-      lv = 0;
-    }
-
-    auto lv2 = GetLightFromMap(map, x, y2, z);
-
-    if (lv2 < lv) {
-      SetLightInMap(map, x, y2, z, lv);
-      sunlightRemovalBfsQueue.emplace(x, y2, z, 0);
-    } else {
-      SetLightInMap(map, x, y2, z, lv);
-      sunlightBfsQueue.emplace(x, y2, z, lv);
-    }
+void World::benchmarkMeshingLayouts() {
+  if (terrain->pager) {
+    TYRA_LOG("Infinite worlds can't change their terrain layout");
+    return;
   }
-}
-
-bool CrossCraft_World_CheckSunLight(uint16_t x, uint16_t y, uint16_t z) {
-  singleCheck(x, y, z);
-  singleCheck(x + 1, y, z);
-  singleCheck(x - 1, y, z);
-  singleCheck(x, y, z + 1);
-  singleCheck(x, y, z - 1);
 
-  updateSunlightRemove();
-  updateSunlight();
-
-  return true;
-}
-
-void CrossCraft_World_PropagateSunLight(uint32_t tick) {
-  auto map = CrossCraft_World_GetMapPtr();
-
-  for (int x = 0; x < map->length; x++) {
-    for (int z = 0; z < map->width; z++) {
-      auto lv = 4;
-      if (tick >= 0 && tick <= 12000) {
-        lv = 15;
+  const LevelMapLayout originalLayout = (LevelMapLayout)terrain->layout;
+  const LevelMapLayout layouts[2] = {LEVEL_MAP_LAYOUT_LINEAR,
+                                     LEVEL_MAP_LAYOUT_BRICKED};
+  const char* layoutNames[2] = {"linear", "bricked"};
+
+  std::vector<Vec4> vertices;
+  std::vector<u16> lights;
+  std::vector<Vec4> uvMap;
+  std::vector<ChunckDrawGroup> drawGroups;
+  std::vector<Chunck*>& chuncks = chunckManager.getChuncks();
+
+  // Alternate the layouts so both run with a warm and a cold cache
+  for (u8 round = 0; round < MESHING_BENCHMARK_ROUNDS; round++) {
+    for (u8 i = 0; i < 2; i++) {
+      SetMapLayout(terrain, layouts[i]);
+
+      const clock_t start = clock();
+      for (size_t j = 0; j < chuncks.size(); j++) {
+        vertices.clear();
+        lights.clear();
+        uvMap.clear();
+        drawGroups.clear();
+        chunckMeshBuilder.build(terrain, *chuncks[j]->minOffset,
+                                *chuncks[j]->maxOffset, &vertices, &lights,
+                                &uvMap, &drawGroups);
       }
+      const float elapsedMs =
+          (clock() - start) * 1000.0F / (float)CLOCKS_PER_SEC;
 
-      for (int y = map->height - 1; y >= 0; y--) {
-        auto blk = GetBlockFromMap(map, x, y, z);
-
-        if (blk == 18 || (blk >= 37 && blk <= 40) || (blk >= 8 && blk <= 11)) {
-          lv -= 2;
-        } else if (blk != 0 && blk != 20) {
-          break;
-        }
-
-        if (lv < 0) break;
-
-        SetLightInMap(map, x, y, z, lv);
-        sunlightBfsQueue.emplace(x, y, z, lv);
-      }
+      TYRA_LOG("Meshing ", chuncks.size(), " chunks with the ",
+               layoutNames[i], " layout took ", elapsedMs, "ms");
     }
   }
 
-  updateSunlight();
+  SetMapLayout(terrain, originalLayout);
 }
 
 void CrossCraft_World_Init(const uint32_t& seed) {
@@ -1122,7 +826,13 @@ void CrossCraft_World_Init(const uint32_t& seed) {
                   .spawnZ = 128,
 
                   .blocks = NULL,
-                  .data = NULL};
+                  .data = NULL,
+                  .sections = NULL,
+                  .pager = NULL,
+
+                  .layout = LEVEL_MAP_LAYOUT_LINEAR,
+                  .edits = NULL,
+                  .snapshot = NULL};
   level.map = map;
 
   TYRA_LOG("Generated base level template");
@@ -1130,8 +840,7 @@ void CrossCraft_World_Init(const uint32_t& seed) {
 
 void CrossCraft_World_Deinit() {
   TYRA_LOG("Destroying the world");
-  if (level.map.blocks) delete[] level.map.blocks;
-  // if (level.map.data) delete[] level.map.data;
+  FreeMapStorage(&level.map);
   TYRA_LOG("World freed");
 }
 
@@ -1140,14 +849,14 @@ void CrossCraft_World_Create_Map() {
   level.map.width = OVERWORLD_H_DISTANCE;
   level.map.height = OVERWORLD_V_DISTANCE;
 
-  uint32_t blockCount = level.map.length * level.map.height * level.map.width;
-  level.map.blocks = new uint8_t[blockCount];
-  // level.map.data = new uint8_t[blockCount];
+  CreateMapStorage(&level.map);
+  CreateMapLight(&level.map);
 }
 
 /**
- * @brief Generates the world
- * @TODO Offer a callback for world percentage
+ * @brief Generates the whole world at once, World::init generates the
+ * finite worlds a column at a time instead, reporting its progress from
+ * World::getLoadingProgress
  */
 void CrossCraft_World_GenerateMap(WorldType worldType) {
   switch (worldType) {
@@ -1167,6 +876,8 @@ void CrossCraft_World_GenerateMap(WorldType worldType) {
       CrossCraft_WorldGenerator_Generate_Floating(&level.map);
       break;
   }
+
+  CompactMapSections(&level.map);
 }
 
 /**
@@ -1,12 +1,21 @@
 #include "entities/chunck.hpp"
+#include "managers/profiler_manager.hpp"
 #include <vector>
 #include <functional>
 #include <iterator>
 #include <algorithm>
 
-Chunck::Chunck(const Vec4& minOffset, const Vec4& maxOffset, const u16& id) {
+// Brightness of the terrain light levels, 0.135 + 0.865 * 0.8^(15 - level):
+// 0.8 times the level above, over a floor so caves are not pitch black
+static const float lightLevelBrightness[16] = {
+    0.165F, 0.173F, 0.183F, 0.194F, 0.209F, 0.228F, 0.251F, 0.280F,
+    0.316F, 0.362F, 0.418F, 0.489F, 0.578F, 0.689F, 0.827F, 1.000F};
+
+// Fixed shade per face (ChunckMeshBuilder order), instead of a sun light
+static const float faceShade[6] = {1.0F, 0.5F, 0.8F, 0.8F, 0.6F, 0.6F};
+
+Chunck::Chunck(const Vec4& minOffset, const Vec4& maxOffset, const u32& id) {
   this->id = id;
-  this->tempLoadingOffset->set(minOffset);
   this->minOffset->set(minOffset);
   this->maxOffset->set(maxOffset);
   this->center->set((maxOffset + minOffset) / 2);
@@ -28,6 +37,9 @@ Chunck::Chunck(const Vec4& minOffset, const Vec4& maxOffset, const u16& id) {
       Vec4(tempMax.x, tempMax.y, tempMin.z),
   };
   this->bbox = new BBox(_vertices, count);
+
+  this->model.identity();
+  this->model.translate(tempMin);
 };
 
 Chunck::~Chunck() {
@@ -40,9 +52,7 @@ Chunck::~Chunck() {
 
 void Chunck::update(const Plane* frustumPlanes, const Vec4& currentPlayerPos,
                     WorldLightModel* worldLightModel) {
-  sunPosition.set(worldLightModel->sunPosition);
-  sunLightIntensity = worldLightModel->lightIntensity;
-  ambientLightIntesity = worldLightModel->ambientLightIntensity;
+  skyLightLevel = worldLightModel->skyLightLevel;
   this->updateFrustumCheck(frustumPlanes);
   // if (isVisible()) applyFOG(currentPlayerPos);
   // if (!isVisible() && isDrawDataLoaded()) {
@@ -60,62 +70,46 @@ void Chunck::applyFOG(const Vec4& originPosition) {
   // }
 }
 
-void Chunck::highLightTargetBlock(Block* t_block, u8& isTarget) {
-  t_block->color.r = isTarget ? 160 : 116;
-  t_block->color.g = isTarget ? 160 : 116;
-  t_block->color.b = isTarget ? 160 : 116;
-}
-
 void Chunck::renderer(Renderer* t_renderer, StaticPipeline* stapip,
                       BlockManager* t_blockManager) {
   if (isDrawDataLoaded()) {
     t_renderer->renderer3D.usePipeline(stapip);
 
-    M4x4 lightMatrix;
-    lightMatrix.identity();
-    lightMatrix.scale(10);
-    lightMatrix.translate(sunPosition);
-
-    M4x4 rawMatrix;
-    rawMatrix.identity();
-
-    PipelineDirLightsBag dirLightsBag;
-    dirLightsBag.setAmbientColor(Color(
-        ambientLightIntesity, ambientLightIntesity, ambientLightIntesity));
-    dirLightsBag.setDirectionalLightColor(
-        Color(sunLightIntensity, sunLightIntensity, sunLightIntensity), 0);
-    dirLightsBag.setDirectionalLightDirection(
-        (sunPosition - CENTER_WORLD_POS).getNormalized(), 0);
-
-    StaPipLightingBag lightBag;
-    lightBag.lightMatrix = &lightMatrix;
-    lightBag.dirLights = &dirLightsBag;
-    lightBag.normals = verticesNormals.data();
+    if (verticesColorsSkyLightLevel != skyLightLevel) updateVerticesColors();
 
     StaPipTextureBag textureBag;
     textureBag.texture = t_blockManager->getBlocksTexture();
-    textureBag.coordinates = uvMap.data();
 
     StaPipInfoBag infoBag;
-    infoBag.model = &rawMatrix;
+    infoBag.model = &model;
     infoBag.shadingType = Tyra::TyraShadingGouraud;
     infoBag.textureMappingType = Tyra::TyraNearest;
 
-    // Apply multiple colors
+    // Baked terrain light
     StaPipColorBag colorBag;
-    // colorBag.many = verticesColors.data();
-    Color baseColor = Color(110.0F, 110.0F, 110.0F);
-    colorBag.single = &baseColor;
 
     StaPipBag bag;
-    bag.count = vertices.size();
-    bag.vertices = vertices.data();
-    bag.lighting = &lightBag;
     bag.color = &colorBag;
     bag.info = &infoBag;
     bag.texture = &textureBag;
 
-    stapip->core.render(&bag);
+    for (size_t i = 0; i < drawGroups.size(); i++) {
+      const ChunckDrawGroup& group = drawGroups[i];
+
+      if (group.isTiled)
+        t_blockManager->useAtlasTile(group.tileCol, group.tileRow);
+      else
+        t_blockManager->useWholeAtlas();
+
+      bag.count = group.count;
+      bag.vertices = vertices.data() + group.first;
+      colorBag.many = verticesColors.data() + group.first;
+      textureBag.coordinates = uvMap.data() + group.first;
+
+      stapip->core.render(&bag);
+    }
+
+    t_blockManager->useWholeAtlas();
 
     // deallocDrawBags(&bag);
     // t_renderer->renderer3D.utility.drawBBox(*bbox, Color(255, 0, 0));
@@ -131,29 +125,9 @@ float Chunck::getVisibityByPosition(float d) {
 
 void Chunck::clear() {
   clearDrawData();
-
-  for (u16 blockIndex = 0; blockIndex < this->blocks.size(); blockIndex++) {
-    delete this->blocks[blockIndex];
-    this->blocks[blockIndex] = NULL;
-  }
-
-  this->blocks.clear();
-  this->blocks.shrink_to_fit();
-
-  resetLoadingOffset();
-
   this->state = ChunkState::Clean;
 }
 
-void Chunck::addBlock(Block* t_block) { this->blocks.push_back(t_block); }
-
-void Chunck::updateBlocks(const Vec4& playerPosition) {
-  for (u16 blockIndex = 0; blockIndex < this->blocks.size(); blockIndex++) {
-    this->highLightTargetBlock(this->blocks[blockIndex],
-                               this->blocks[blockIndex]->isTarget);
-  }
-}
-
 void Chunck::clearDrawData() {
   vertices.clear();
   vertices.shrink_to_fit();
@@ -161,140 +135,42 @@ void Chunck::clearDrawData() {
   verticesColors.shrink_to_fit();
   uvMap.clear();
   uvMap.shrink_to_fit();
-  verticesNormals.clear();
-  verticesNormals.shrink_to_fit();
+  verticesLights.clear();
+  verticesLights.shrink_to_fit();
+  drawGroups.clear();
+  drawGroups.shrink_to_fit();
 
   _isDrawDataLoaded = false;
 }
 
-void Chunck::loadDrawData() {
-  sortBlockByTransparency();
-
-  const float scale = 1.0F / 16.0F;
-  const Vec4 scaleVec = Vec4(scale, scale, 1.0F, 0.0F);
-  const Vec4* rawData = VertexBlockData::getVertexData();
-
-  for (size_t i = 0; i < blocks.size(); i++) {
-    int vert = 0;
-
-    if (blocks[i]->isTopFaceVisible()) {
-      for (size_t j = 0; j < VertexBlockData::FACES_COUNT; j++) {
-        vertices.push_back(blocks[i]->model * rawData[vert++]);
-        // verticesColors.push_back(Color(120, 120, 120));
-        verticesNormals.push_back(Vec4(0.0F, 1.0F, 0.0F));
-      }
-
-      const u8& X = blocks[i]->topMapX();
-      const u8& Y = blocks[i]->topMapY();
-
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-    }
-    vert = 6;
-
-    if (blocks[i]->isBottomFaceVisible()) {
-      for (size_t j = 0; j < VertexBlockData::FACES_COUNT; j++) {
-        vertices.push_back(blocks[i]->model * rawData[vert++]);
-        // verticesColors.push_back(Color(60, 60, 60));
-        verticesNormals.push_back(Vec4(0.0F, -1.0F, 0.0F));
-      }
-      const u8& X = blocks[i]->bottomMapX();
-      const u8& Y = blocks[i]->bottomMapY();
-
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-    }
-    vert = 12;
-
-    if (blocks[i]->isLeftFaceVisible()) {
-      for (size_t j = 0; j < VertexBlockData::FACES_COUNT; j++) {
-        vertices.push_back(blocks[i]->model * rawData[vert++]);
-        // verticesColors.push_back(Color(70, 70, 70));
-        verticesNormals.push_back(Vec4(0.0F, 0.0F, -1.0F));
-      }
-      const u8& X = blocks[i]->leftMapX();
-      const u8& Y = blocks[i]->leftMapY();
-
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-    }
-    vert = 18;
-
-    if (blocks[i]->isRightFaceVisible()) {
-      for (size_t j = 0; j < VertexBlockData::FACES_COUNT; j++) {
-        vertices.push_back(blocks[i]->model * rawData[vert++]);
-        // verticesColors.push_back(Color(100, 100, 100));
-        verticesNormals.push_back(Vec4(0.0F, 0.0F, 1.0F));
-      }
-      const u8& X = blocks[i]->rightMapX();
-      const u8& Y = blocks[i]->rightMapY();
-
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-    }
-    vert = 24;
-
-    if (blocks[i]->isBackFaceVisible()) {
-      for (size_t j = 0; j < VertexBlockData::FACES_COUNT; j++) {
-        vertices.push_back(blocks[i]->model * rawData[vert++]);
-        // verticesColors.push_back(Color(80, 80, 80));
-        verticesNormals.push_back(Vec4(1.0F, 0.0F, 0.0F));
-      }
-
-      const u8& X = blocks[i]->backMapX();
-      const u8& Y = blocks[i]->backMapY();
-
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
+void Chunck::loadDrawData(LevelMap* terrain, ChunckMeshBuilder* meshBuilder) {
+  ProfilerScope profile(ProfilerStage::Meshing);
+  clearDrawData();
+  meshBuilder->build(terrain, *minOffset, *maxOffset, &vertices,
+                     &verticesLights, &uvMap, &drawGroups);
+  verticesColors.resize(vertices.size());
+  verticesColorsSkyLightLevel = 0xFF;
+  _isDrawDataLoaded = true;
+}
 
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-    }
-    vert = 30;
-
-    if (blocks[i]->isFrontFaceVisible()) {
-      for (size_t j = 0; j < VertexBlockData::FACES_COUNT; j++) {
-        vertices.push_back(blocks[i]->model * rawData[vert++]);
-        // verticesColors.push_back(Color(110, 110, 110));
-        verticesNormals.push_back(Vec4(-1.0F, 0.0F, 0.0F));
-      }
-      const u8& X = blocks[i]->frontMapX();
-      const u8& Y = blocks[i]->frontMapY();
-
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-
-      uvMap.push_back(Vec4(X, (Y + 1.0F), 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4(X, Y, 1.0F, 0.0F) * scaleVec);
-      uvMap.push_back(Vec4((X + 1.0F), Y, 1.0F, 0.0F) * scaleVec);
-    }
+void Chunck::updateVerticesColors() {
+  // The same 16 levels and 6 faces repeat over the whole chunk
+  float brightness[6][16];
+  for (u8 face = 0; face < 6; face++)
+    for (u8 level = 0; level < 16; level++)
+      brightness[face][level] =
+          128.0F * faceShade[face] * lightLevelBrightness[level];
+
+  for (size_t i = 0; i < verticesLights.size(); i++) {
+    const u8 face = verticesLights[i] >> 8;
+    const u8 skyLight = std::min<u8>((verticesLights[i] >> 4) & 0x0F,
+                                     skyLightLevel);
+    const u8 blockLight = verticesLights[i] & 0x0F;
+    const float value = brightness[face][std::max(skyLight, blockLight)];
+    verticesColors[i] = Color(value, value, value, 128.0F);
   }
 
-  _isDrawDataLoaded = true;
-  delete rawData;
+  verticesColorsSkyLightLevel = skyLightLevel;
 }
 
 void Chunck::updateFrustumCheck(const Plane* frustumPlanes) {
@@ -312,9 +188,3 @@ void Chunck::deallocDrawBags(StaPipBag* bag) {
     delete bag->lighting;
   }
 }
-
-void Chunck::sortBlockByTransparency() {
-  std::sort(blocks.begin(), blocks.end(), [](const Block* a, const Block* b) {
-    return (u8)a->hasTransparency < (u8)b->hasTransparency;
-  });
-}
@@ -1,4 +1,7 @@
 #include "entities/level.hpp"
+#include "entities/level_pager.hpp"
+#include <math.h>
+#include <string.h>
 
 // Gets the position in the data array from the given x, y, and z coordinates.
 uint32_t GetPosFromXYZ(uint32_t x, uint32_t y, uint32_t z) {
@@ -12,37 +15,637 @@ void GetXYZFromPos(uint32_t pos, uint32_t* x, uint32_t* y, uint32_t* z) {
     *z = (pos >> 20) % 1024;
 }
 
+// Gets the position in the blocks and data arrays of the given coordinates.
+uint32_t GetIndexFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
+    if (map->layout != LEVEL_MAP_LAYOUT_LINEAR) {
+        uint32_t bricksX = map->width >> LEVEL_MAP_BRICK_SHIFT;
+        uint32_t bricksZ = map->length >> LEVEL_MAP_BRICK_SHIFT;
+
+        // Index inside the region
+        if (map->layout == LEVEL_MAP_LAYOUT_PAGED) {
+            x &= LEVEL_REGION_MASK;
+            z &= LEVEL_REGION_MASK;
+            bricksX = bricksZ = LEVEL_REGION_SIZE >> LEVEL_MAP_BRICK_SHIFT;
+        }
+
+        uint32_t brick = ((y >> LEVEL_MAP_BRICK_SHIFT) * bricksZ +
+                          (z >> LEVEL_MAP_BRICK_SHIFT)) * bricksX +
+                         (x >> LEVEL_MAP_BRICK_SHIFT);
+        uint32_t cell =
+            ((y & LEVEL_MAP_BRICK_MASK) << (2 * LEVEL_MAP_BRICK_SHIFT)) |
+            ((z & LEVEL_MAP_BRICK_MASK) << LEVEL_MAP_BRICK_SHIFT) |
+            (x & LEVEL_MAP_BRICK_MASK);
+        return (brick << (3 * LEVEL_MAP_BRICK_SHIFT)) | cell;
+    }
+
+    return (y * map->length * map->width) + (z * map->width) + x;
+}
+
+// Gets the brick of the given coordinates, in the sectioned layout order.
+static uint32_t GetBrickFromMap(LevelMap* map, uint16_t x, uint16_t y,
+                                uint16_t z) {
+    uint32_t bricksX = map->width >> LEVEL_MAP_BRICK_SHIFT;
+    uint32_t bricksZ = map->length >> LEVEL_MAP_BRICK_SHIFT;
+    return ((y >> LEVEL_MAP_BRICK_SHIFT) * bricksZ +
+            (z >> LEVEL_MAP_BRICK_SHIFT)) * bricksX +
+           (x >> LEVEL_MAP_BRICK_SHIFT);
+}
+
+// Gets the number of sections of a region of the paged map.
+uint32_t GetRegionSectionsCount(LevelMap* map) {
+    return (LEVEL_REGION_SIZE * LEVEL_REGION_SIZE * map->height) /
+           LEVEL_SECTION_CELLS;
+}
+
+// Gets the number of cells of the map.
+static uint32_t GetMapCellsCount(LevelMap* map) {
+    return map->width * map->length * map->height;
+}
+
+// Allocates the blocks array or the sections of the map.
+void CreateMapStorage(LevelMap* map) {
+    uint32_t count = GetMapCellsCount(map);
+
+    // Paged maps get their regions from the pager
+    if (map->layout == LEVEL_MAP_LAYOUT_PAGED) return;
+
+    if (map->layout == LEVEL_MAP_LAYOUT_SECTIONED) {
+        uint32_t sectionsCount = count / LEVEL_SECTION_CELLS;
+        map->sections = new LevelMapSection[sectionsCount];
+        memset(map->sections, 0, sectionsCount * sizeof(LevelMapSection));
+    } else {
+        map->blocks = new uint8_t[count];
+        // Void, like new sections, generators may leave cells unset
+        memset(map->blocks, 0, count);
+    }
+}
+
+// Allocates the light array of the map, without light.
+void CreateMapLight(LevelMap* map) {
+    if (map->layout == LEVEL_MAP_LAYOUT_PAGED || map->data) return;
+
+    uint32_t count = GetMapCellsCount(map);
+    map->data = new uint8_t[count];
+    memset(map->data, 0, count);
+}
+
+// Frees the blocks, sections, regions and data of the map.
+void FreeMapStorage(LevelMap* map) {
+    if (map->pager) FreeMapPager(map);
+
+    if (map->sections) {
+        uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+        for (uint32_t i = 0; i < sectionsCount; i++)
+            FreeSection(&map->sections[i]);
+        delete[] map->sections;
+        map->sections = NULL;
+    }
+
+    if (map->blocks) delete[] map->blocks;
+    map->blocks = NULL;
+
+    if (map->data) delete[] map->data;
+    map->data = NULL;
+
+    if (map->edits) delete[] map->edits;
+    map->edits = NULL;
+
+    FreeMapSnapshot(map);
+}
+
+// Allocates the edited bricks of a resident map, none edited.
+void CreateMapEdits(LevelMap* map) {
+    if (map->layout == LEVEL_MAP_LAYOUT_PAGED || map->edits) return;
+
+    uint32_t count = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    map->edits = new uint8_t[count];
+    memset(map->edits, 0, count);
+}
+
+// Moves the map content to a new storage with the given layout.
+void SetMapLayout(LevelMap* map, LevelMapLayout layout) {
+    // A paged map is never fully resident
+    if (map->layout == layout || map->layout == LEVEL_MAP_LAYOUT_PAGED ||
+        layout == LEVEL_MAP_LAYOUT_PAGED)
+        return;
+
+    LevelMap target = *map;
+    target.layout = layout;
+    target.blocks = NULL;
+    target.sections = NULL;
+    target.data = NULL;
+    // Moving the cells is no edit, the edited bricks move with the map
+    target.edits = NULL;
+    target.snapshot = NULL;
+    CreateMapStorage(&target);
+    if (map->data) target.data = new uint8_t[GetMapCellsCount(map)];
+
+    for (uint16_t y = 0; y < map->height; y++)
+        for (uint16_t z = 0; z < map->length; z++)
+            for (uint16_t x = 0; x < map->width; x++) {
+                SetBlockInMap(&target, x, y, z, GetBlockFromMap(map, x, y, z));
+                if (map->data)
+                    target.data[GetIndexFromMap(&target, x, y, z)] =
+                        GetDataFromMap(map, x, y, z);
+            }
+
+    CompactMapSections(&target);
+    target.edits = map->edits;
+    map->edits = NULL;
+    target.snapshot = map->snapshot;
+    map->snapshot = NULL;
+    FreeMapStorage(map);
+    *map = target;
+}
+
+// Shrinks the palettes of the map sections to the blocks they still use.
+void CompactMapSections(LevelMap* map) {
+    if (map->pager) {
+        for (uint16_t i = 0; i < LEVEL_PAGER_BUCKETS; i++)
+            for (LevelMapRegion* region = map->pager->buckets[i]; region;
+                 region = region->next) {
+                uint32_t sectionsCount = GetRegionSectionsCount(map);
+                for (uint32_t j = 0; j < sectionsCount; j++)
+                    CompactSection(&region->sections[j]);
+            }
+        return;
+    }
+
+    if (!map->sections) return;
+
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    for (uint32_t i = 0; i < sectionsCount; i++)
+        CompactSection(&map->sections[i]);
+}
+
+// Gets the bytes used by the map blocks and data.
+uint32_t GetMapMemoryUsage(LevelMap* map) {
+    if (map->pager) return GetPagerMemoryUsage(map);
+
+    uint32_t count = GetMapCellsCount(map);
+    uint32_t usage = map->data ? count : 0;
+
+    if (!map->sections) return usage + (map->blocks ? count : 0);
+
+    for (uint32_t i = 0; i < count / LEVEL_SECTION_CELLS; i++)
+        usage += GetSectionMemoryUsage(&map->sections[i]);
+    return usage;
+}
+
+// Gets the origin cell of the given brick, in the sectioned layout order.
+static void GetBrickOrigin(LevelMap* map, uint32_t brick, uint16_t* x,
+                           uint16_t* y, uint16_t* z) {
+    uint32_t bricksX = map->width >> LEVEL_MAP_BRICK_SHIFT;
+    uint32_t bricksZ = map->length >> LEVEL_MAP_BRICK_SHIFT;
+    *x = (brick % bricksX) << LEVEL_MAP_BRICK_SHIFT;
+    *z = ((brick / bricksX) % bricksZ) << LEVEL_MAP_BRICK_SHIFT;
+    *y = (brick / (bricksX * bricksZ)) << LEVEL_MAP_BRICK_SHIFT;
+}
+
+// Copies the cells of the brick to blocks, in the section cells order.
+static void GetMapBrickCells(LevelMap* map, uint32_t brick, uint8_t* blocks) {
+    uint16_t originX, originY, originZ;
+    GetBrickOrigin(map, brick, &originX, &originY, &originZ);
+    for (uint16_t cell = 0; cell < LEVEL_SECTION_CELLS; cell++)
+        blocks[cell] = GetBlockFromMap(
+            map, originX + (cell & LEVEL_MAP_BRICK_MASK),
+            originY + (cell >> (2 * LEVEL_MAP_BRICK_SHIFT)),
+            originZ + ((cell >> LEVEL_MAP_BRICK_SHIFT) & LEVEL_MAP_BRICK_MASK));
+}
+
+// Writes the cells of the brick as a section, temp holds the sections of
+// maps without them.
+static bool WriteMapBrick(LevelMap* map, uint32_t brick, LevelStream* stream,
+                          LevelMapSection* temp) {
+    if (map->sections) return WriteSection(stream, &map->sections[brick]);
+
+    uint8_t blocks[LEVEL_SECTION_CELLS];
+    GetMapBrickCells(map, brick, blocks);
+    SetSectionCells(temp, blocks);
+    return WriteSection(stream, temp);
+}
+
+// Puts a section read by ReadSection into the brick cells, taking it.
+static void SetMapBrick(LevelMap* map, uint32_t brick,
+                        LevelMapSection section) {
+    if (map->sections) {
+        FreeSection(&map->sections[brick]);
+        map->sections[brick] = section;
+        if (map->edits) map->edits[brick] = true;
+        return;
+    }
+
+    uint8_t blocks[LEVEL_SECTION_CELLS];
+    GetSectionCells(&section, blocks);
+    FreeSection(&section);
+
+    uint16_t originX, originY, originZ;
+    GetBrickOrigin(map, brick, &originX, &originY, &originZ);
+    for (uint16_t cell = 0; cell < LEVEL_SECTION_CELLS; cell++)
+        SetBlockInMap(map, originX + (cell & LEVEL_MAP_BRICK_MASK),
+                      originY + (cell >> (2 * LEVEL_MAP_BRICK_SHIFT)),
+                      originZ + ((cell >> LEVEL_MAP_BRICK_SHIFT) &
+                                 LEVEL_MAP_BRICK_MASK),
+                      blocks[cell]);
+}
+
+// Reads a section written by WriteMapBrick into the brick cells.
+static bool ReadMapBrick(LevelMap* map, uint32_t brick, LevelStream* stream) {
+    LevelMapSection section = {0, 0, 0, NULL};
+    if (!ReadSection(stream, &section)) return false;
+    SetMapBrick(map, brick, section);
+    return true;
+}
+
+// Writes the map blocks as one section per brick.
+bool WriteMapBlocks(LevelMap* map, LevelStream* stream) {
+    if (map->layout == LEVEL_MAP_LAYOUT_PAGED) return false;
+
+    LevelMapSection temp = {0, 0, 0, NULL};
+    bool written = true;
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    for (uint32_t i = 0; written && i < sectionsCount; i++)
+        written = WriteMapBrick(map, i, stream, &temp);
+    FreeSection(&temp);
+    return written;
+}
+
+// Reads the map blocks written by WriteMapBlocks.
+bool ReadMapBlocks(LevelMap* map, LevelStream* stream) {
+    if (map->layout == LEVEL_MAP_LAYOUT_PAGED) return false;
+
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    for (uint32_t i = 0; i < sectionsCount; i++)
+        if (!ReadMapBrick(map, i, stream)) return false;
+    return true;
+}
+
+// Writes the count and the indices of the edited bricks of the map, then
+// their sections in the same order.
+bool WriteMapEdits(LevelMap* map, LevelStream* stream) {
+    if (!map->edits) return false;
+
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < sectionsCount; i++)
+        if (map->edits[i]) count++;
+    bool written = WriteLevelStream(stream, &count, sizeof(count));
+    for (uint32_t i = 0; written && i < sectionsCount; i++)
+        if (map->edits[i]) written = WriteLevelStream(stream, &i, sizeof(i));
+
+    LevelMapSection temp = {0, 0, 0, NULL};
+    for (uint32_t i = 0; written && i < sectionsCount; i++)
+        if (map->edits[i]) written = WriteMapBrick(map, i, stream, &temp);
+    FreeSection(&temp);
+    return written;
+}
+
+// Reads the edited bricks written by WriteMapEdits.
+bool ReadMapEdits(LevelMap* map, LevelStream* stream,
+                  LevelMapBrickLoader loader, void* userData) {
+    if (map->layout == LEVEL_MAP_LAYOUT_PAGED) return false;
+
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    uint32_t count;
+    if (!ReadLevelStream(stream, &count, sizeof(count)) ||
+        count > sectionsCount)
+        return false;
+
+    // The indices come first, the loader runs for all of them before the
+    // sections are read one at a time
+    uint32_t* bricks = new uint32_t[count];
+    bool read = ReadLevelStream(stream, bricks, count * sizeof(uint32_t));
+    for (uint32_t i = 0; read && i < count; i++)
+        read = bricks[i] < sectionsCount;
+
+    if (read && loader)
+        for (uint32_t i = 0; i < count; i++) loader(map, bricks[i], userData);
+
+    for (uint32_t i = 0; read && i < count; i++)
+        read = ReadMapBrick(map, bricks[i], stream);
+
+    delete[] bricks;
+    return read;
+}
+
+// State of a brick in the snapshot
+#define LEVEL_SNAPSHOT_SKIPPED 0
+#define LEVEL_SNAPSHOT_PENDING 1
+// Edited since the snapshot, its snapshot content is in the copies
+#define LEVEL_SNAPSHOT_COPIED 2
+
+// Edited bricks of the map when the snapshot was taken.
+struct LevelMapSnapshot {
+    // One state per brick, in the sectioned layout order
+    uint8_t* bricks;
+    LevelMapSection* copies;
+    uint32_t count;
+    // Next brick to look at, the count and indices are written first
+    uint32_t next;
+    bool started;
+};
+
+// Freezes the edited bricks of the map, the map content is copied on write.
+bool CreateMapSnapshot(LevelMap* map) {
+    FreeMapSnapshot(map);
+    if (!map->edits) return false;
+
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    LevelMapSnapshot* snapshot = new LevelMapSnapshot;
+    snapshot->bricks = new uint8_t[sectionsCount];
+    snapshot->copies = new LevelMapSection[sectionsCount];
+    memset(snapshot->copies, 0, sectionsCount * sizeof(LevelMapSection));
+    snapshot->count = 0;
+    snapshot->next = 0;
+    snapshot->started = false;
+
+    for (uint32_t i = 0; i < sectionsCount; i++) {
+        snapshot->bricks[i] =
+            map->edits[i] ? LEVEL_SNAPSHOT_PENDING : LEVEL_SNAPSHOT_SKIPPED;
+        if (map->edits[i]) snapshot->count++;
+    }
+
+    map->snapshot = snapshot;
+    return true;
+}
+
+// Copies a brick still to write before its first change.
+static void PreserveSnapshotBrick(LevelMap* map, uint32_t brick) {
+    LevelMapSnapshot* snapshot = map->snapshot;
+    if (snapshot->bricks[brick] != LEVEL_SNAPSHOT_PENDING) return;
+
+    if (map->sections) {
+        CopySection(&snapshot->copies[brick], &map->sections[brick]);
+    } else {
+        uint8_t blocks[LEVEL_SECTION_CELLS];
+        GetMapBrickCells(map, brick, blocks);
+        SetSectionCells(&snapshot->copies[brick], blocks);
+    }
+    snapshot->bricks[brick] = LEVEL_SNAPSHOT_COPIED;
+}
+
+// Writes the next pending bricks of the snapshot, from the copies if edited.
+bool WriteMapSnapshot(LevelMap* map, LevelStream* stream,
+                      uint32_t maxBricks, bool* done) {
+    LevelMapSnapshot* snapshot = map->snapshot;
+    *done = false;
+    if (!snapshot) return false;
+
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    if (!snapshot->started) {
+        bool written = WriteLevelStream(stream, &snapshot->count,
+                                        sizeof(snapshot->count));
+        for (uint32_t i = 0; written && i < sectionsCount; i++)
+            if (snapshot->bricks[i] != LEVEL_SNAPSHOT_SKIPPED)
+                written = WriteLevelStream(stream, &i, sizeof(i));
+        if (!written) return false;
+        snapshot->started = true;
+    }
+
+    LevelMapSection temp = {0, 0, 0, NULL};
+    bool written = true;
+    uint32_t bricks = 0;
+    for (; written && bricks < maxBricks && snapshot->next < sectionsCount;
+         snapshot->next++) {
+        uint32_t i = snapshot->next;
+        if (snapshot->bricks[i] == LEVEL_SNAPSHOT_SKIPPED) continue;
+
+        if (snapshot->bricks[i] == LEVEL_SNAPSHOT_COPIED)
+            written = WriteSection(stream, &snapshot->copies[i]);
+        else
+            written = WriteMapBrick(map, i, stream, &temp);
+
+        // Written, later edits need no copy
+        FreeSection(&snapshot->copies[i]);
+        snapshot->bricks[i] = LEVEL_SNAPSHOT_SKIPPED;
+        bricks++;
+    }
+    FreeSection(&temp);
+
+    *done = written && snapshot->next == sectionsCount;
+    return written;
+}
+
+// Frees the snapshot and the copies of the bricks not written.
+void FreeMapSnapshot(LevelMap* map) {
+    LevelMapSnapshot* snapshot = map->snapshot;
+    if (!snapshot) return;
+
+    uint32_t sectionsCount = GetMapCellsCount(map) / LEVEL_SECTION_CELLS;
+    for (uint32_t i = 0; i < sectionsCount; i++)
+        FreeSection(&snapshot->copies[i]);
+    delete[] snapshot->copies;
+    delete[] snapshot->bricks;
+    delete snapshot;
+    map->snapshot = NULL;
+}
+
+// Gets the light byte of the given coordinates, or NULL without light.
+static uint8_t* GetLightCell(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
+    uint32_t index = GetIndexFromMap(map, x, y, z);
+    if (map->pager) {
+        LevelMapRegion* region = GetMapRegion(
+            map->pager, x >> LEVEL_REGION_SHIFT, z >> LEVEL_REGION_SHIFT);
+        if (!region || !region->light) return NULL;
+        return &region->light[index];
+    }
+    if (!map->data) return NULL;
+    return &map->data[index];
+}
+
 // Gets the data value at the given coordinates in the map.
 uint8_t GetDataFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
-    uint32_t index = (y * map->length * map->width) + (z * map->width) + x;
-    return map->data[index];
+    uint8_t* cell = GetLightCell(map, x, y, z);
+    return cell ? *cell : 0xF0;
 }
 
-// Gets the light value at the given coordinates in the map.
-uint8_t GetLightFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
+// Gets the sky light value at the given coordinates in the map.
+uint8_t GetSkyLightFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
+    uint8_t data = GetDataFromMap(map, x, y, z);
+    return data >> 4;
+}
+
+// Gets the block light value at the given coordinates in the map.
+uint8_t GetBlockLightFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
     uint8_t data = GetDataFromMap(map, x, y, z);
     return data & 0x0F;
 }
 
 // Gets the block ID at the given coordinates in the map.
 uint8_t GetBlockFromMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
-    uint32_t index = (y * map->length * map->width) + (z * map->width) + x;
+    uint32_t index = GetIndexFromMap(map, x, y, z);
+    if (map->pager) {
+        LevelMapRegion* region = GetMapRegion(
+            map->pager, x >> LEVEL_REGION_SHIFT, z >> LEVEL_REGION_SHIFT);
+        if (!region) return 0;
+        return GetSectionCell(&region->sections[index / LEVEL_SECTION_CELLS],
+                              index % LEVEL_SECTION_CELLS);
+    }
+    if (map->sections)
+        return GetSectionCell(&map->sections[index / LEVEL_SECTION_CELLS],
+                              index % LEVEL_SECTION_CELLS);
     return map->blocks[index];
 }
 
 // Sets the block ID at the given coordinates in the map.
 void SetBlockInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint8_t block) {
-    uint32_t index = (y * map->length * map->width) + (z * map->width) + x;
+    uint32_t index = GetIndexFromMap(map, x, y, z);
+    if (map->pager) {
+        LevelMapRegion* region = GetMapRegion(
+            map->pager, x >> LEVEL_REGION_SHIFT, z >> LEVEL_REGION_SHIFT);
+        if (!region) return;
+        region->dirty = true;
+        return SetSectionCell(&region->sections[index / LEVEL_SECTION_CELLS],
+                              index % LEVEL_SECTION_CELLS, block);
+    }
+    if (map->edits || map->snapshot) {
+        uint32_t brick = GetBrickFromMap(map, x, y, z);
+        if (map->snapshot) PreserveSnapshotBrick(map, brick);
+        if (map->edits) map->edits[brick] = true;
+    }
+    if (map->sections)
+        return SetSectionCell(&map->sections[index / LEVEL_SECTION_CELLS],
+                              index % LEVEL_SECTION_CELLS, block);
     map->blocks[index] = block;
 }
 
-// Sets the light value at the given coordinates in the map.
-void SetLightInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint16_t light) {
-    uint32_t index = (y * map->length * map->width) + (z * map->width) + x;
-    map->data[index] = (map->data[index] & 0xF0) | (light & 0xF);
+// Sets the sky light value at the given coordinates in the map.
+void SetSkyLightInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint8_t light) {
+    uint8_t* cell = GetLightCell(map, x, y, z);
+    if (cell) *cell = (*cell & 0x0F) | (light << 4);
+}
+
+// Sets the block light value at the given coordinates in the map.
+void SetBlockLightInMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z, uint8_t light) {
+    uint8_t* cell = GetLightCell(map, x, y, z);
+    if (cell) *cell = (*cell & 0xF0) | (light & 0x0F);
 }
 
 // Returns true if the given coordinates are within the bounds of the map.
 bool BoundCheckMap(LevelMap* map, uint16_t x, uint16_t y, uint16_t z) {
+    if (map->pager)
+        return y < map->height &&
+               GetMapRegion(map->pager, x >> LEVEL_REGION_SHIFT,
+                            z >> LEVEL_REGION_SHIFT) != NULL;
     return (x < map->length && y < map->height && z < map->width);
-}
\ No newline at end of file
+}
+
+// Walks the grid cells crossed by the ray until hitting a non empty block.
+bool RaycastMap(LevelMap* map, const float origin[3], const float dir[3],
+                float maxDistance, float cellSize, uint8_t emptyBlock,
+                LevelMapRayHit* hit) {
+    int cell[3];
+    int step[3];
+    float tMax[3];
+    float tDelta[3];
+    int8_t normal[3] = {0, 0, 0};
+
+    for (int i = 0; i < 3; i++) {
+        // Grid space, cells start at integer coordinates
+        float gridPos = origin[i] / cellSize + 0.5F;
+        cell[i] = (int)floorf(gridPos);
+
+        if (dir[i] > 0.0F) {
+            step[i] = 1;
+            tDelta[i] = cellSize / dir[i];
+            tMax[i] = (cell[i] + 1 - gridPos) * tDelta[i];
+        } else if (dir[i] < 0.0F) {
+            step[i] = -1;
+            tDelta[i] = -cellSize / dir[i];
+            tMax[i] = (gridPos - cell[i]) * tDelta[i];
+        } else {
+            step[i] = 0;
+            tDelta[i] = INFINITY;
+            tMax[i] = INFINITY;
+        }
+    }
+
+    float distance = 0.0F;
+    while (distance <= maxDistance) {
+        // Negative cells wrap and fail the bound check
+        if (BoundCheckMap(map, cell[0], cell[1], cell[2])) {
+            uint8_t block = GetBlockFromMap(map, cell[0], cell[1], cell[2]);
+            if (block > emptyBlock) {
+                hit->x = cell[0];
+                hit->y = cell[1];
+                hit->z = cell[2];
+                hit->normalX = normal[0];
+                hit->normalY = normal[1];
+                hit->normalZ = normal[2];
+                hit->block = block;
+                hit->distance = distance;
+                return true;
+            }
+        }
+
+        int axis = 0;
+        if (tMax[1] < tMax[axis]) axis = 1;
+        if (tMax[2] < tMax[axis]) axis = 2;
+
+        distance = tMax[axis];
+        tMax[axis] += tDelta[axis];
+        cell[axis] += step[axis];
+
+        normal[0] = normal[1] = normal[2] = 0;
+        normal[axis] = -step[axis];
+    }
+
+    return false;
+}
+
+// Tolerance, in cells, so boxes resting on a cell face don't overlap it.
+#define SWEEP_EPSILON 0.0001F
+
+// Returns true if there is a non empty block in the cells [min, max].
+static bool HasBlockInCells(LevelMap* map, const int min[3], const int max[3],
+                            uint8_t emptyBlock) {
+    for (int y = min[1]; y <= max[1]; y++)
+        for (int z = min[2]; z <= max[2]; z++)
+            for (int x = min[0]; x <= max[0]; x++)
+                if (BoundCheckMap(map, x, y, z) &&
+                    GetBlockFromMap(map, x, y, z) > emptyBlock)
+                    return true;
+    return false;
+}
+
+// Moves the box along one axis until it touches a non empty block.
+float SweepBoxInMap(LevelMap* map, const float boxMin[3],
+                    const float boxMax[3], uint8_t axis, float delta,
+                    float cellSize, uint8_t emptyBlock) {
+    if (delta == 0.0F) return 0.0F;
+
+    // Cells overlapped by the box, in grid space cell x spans [x, x + 1)
+    int min[3], max[3];
+    for (int i = 0; i < 3; i++) {
+        min[i] = (int)floorf(boxMin[i] / cellSize + 0.5F + SWEEP_EPSILON);
+        max[i] = (int)ceilf(boxMax[i] / cellSize + 0.5F - SWEEP_EPSILON) - 1;
+    }
+
+    const float gridDelta = delta / cellSize;
+
+    if (delta > 0.0F) {
+        const float lead = boxMax[axis] / cellSize + 0.5F;
+        const int last = (int)ceilf(lead + gridDelta - SWEEP_EPSILON) - 1;
+
+        for (int cell = max[axis] + 1; cell <= last; cell++) {
+            min[axis] = max[axis] = cell;
+            if (HasBlockInCells(map, min, max, emptyBlock)) {
+                const float allowed = (cell - lead) * cellSize;
+                return allowed > 0.0F ? allowed : 0.0F;
+            }
+        }
+    } else {
+        const float lead = boxMin[axis] / cellSize + 0.5F;
+        const int last = (int)floorf(lead + gridDelta + SWEEP_EPSILON);
+
+        for (int cell = min[axis] - 1; cell >= last; cell--) {
+            min[axis] = max[axis] = cell;
+            if (HasBlockInCells(map, min, max, emptyBlock)) {
+                const float allowed = (cell + 1 - lead) * cellSize;
+                return allowed < 0.0F ? allowed : 0.0F;
+            }
+        }
+    }
+
+    return delta;
+}
@@ -0,0 +1,309 @@
+#include "entities/level_pager.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Region files start with this magic and version, then the map height.
+#define LEVEL_REGION_MAGIC "TCRG"
+#define LEVEL_REGION_VERSION 1
+
+// Regions per axis of the 16 bit map coordinates.
+#define LEVEL_REGIONS_PER_AXIS (0x10000 >> LEVEL_REGION_SHIFT)
+
+// Region file names are "r.<x>.<z>.bin", with 16 bit region coordinates.
+#define LEVEL_REGION_NAME_SIZE sizeof("r.65535.65535.bin")
+#define LEVEL_REGION_PATH_SIZE \
+    (LEVEL_PAGER_DIRECTORY_SIZE + LEVEL_REGION_NAME_SIZE)
+
+// Gets the hash bucket of the given region.
+static inline uint16_t GetRegionBucket(uint16_t regionX, uint16_t regionZ) {
+    return (regionX * 31 + regionZ) & (LEVEL_PAGER_BUCKETS - 1);
+}
+
+// Writes the path of the region file to path, LEVEL_REGION_PATH_SIZE bytes.
+// Returns false if it did not fit, rather than opening a truncated path.
+static bool GetRegionPath(LevelMapPager* pager, uint16_t regionX,
+                          uint16_t regionZ, char* path) {
+    int length = snprintf(path, LEVEL_REGION_PATH_SIZE, "%sr.%u.%u.bin",
+                          pager->directory, regionX, regionZ);
+    return length > 0 && length < (int)LEVEL_REGION_PATH_SIZE;
+}
+
+// Gets the number of cells of a region.
+static uint32_t GetRegionCellsCount(LevelMap* map) {
+    return LEVEL_REGION_SIZE * LEVEL_REGION_SIZE * map->height;
+}
+
+// Gets the bytes used by the region sections and light.
+static uint32_t GetRegionMemoryUsage(LevelMap* map, LevelMapRegion* region) {
+    uint32_t usage = sizeof(LevelMapRegion);
+    if (region->light) usage += GetRegionCellsCount(map);
+    uint32_t sectionsCount = GetRegionSectionsCount(map);
+    for (uint32_t i = 0; i < sectionsCount; i++)
+        usage += GetSectionMemoryUsage(&region->sections[i]);
+    return usage;
+}
+
+// Writes the region sections to its file.
+static bool WriteRegion(LevelMap* map, LevelMapRegion* region) {
+    char path[LEVEL_REGION_PATH_SIZE];
+    if (!GetRegionPath(map->pager, region->x, region->z, path)) return false;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    uint8_t header[7] = {0};
+    memcpy(header, LEVEL_REGION_MAGIC, 4);
+    header[4] = LEVEL_REGION_VERSION;
+    header[5] = map->height & 0xFF;
+    header[6] = map->height >> 8;
+    bool written = fwrite(header, sizeof(header), 1, file) == 1;
+
+    LevelStream stream;
+    OpenLevelStream(&stream, file, LEVEL_STREAM_PLAIN, true);
+    uint32_t sectionsCount = GetRegionSectionsCount(map);
+    for (uint32_t i = 0; written && i < sectionsCount; i++)
+        written = WriteSection(&stream, &region->sections[i]);
+    CloseLevelStream(&stream);
+
+    if (fclose(file) != 0) written = false;
+    if (written) region->dirty = false;
+    return written;
+}
+
+// Reads the region sections from its file.
+static bool ReadRegion(LevelMap* map, LevelMapRegion* region) {
+    char path[LEVEL_REGION_PATH_SIZE];
+    if (!GetRegionPath(map->pager, region->x, region->z, path)) return false;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t header[7];
+    bool read = fread(header, sizeof(header), 1, file) == 1 &&
+                memcmp(header, LEVEL_REGION_MAGIC, 4) == 0 &&
+                header[4] == LEVEL_REGION_VERSION &&
+                (header[5] | (header[6] << 8)) == map->height;
+
+    LevelStream stream;
+    OpenLevelStream(&stream, file, LEVEL_STREAM_PLAIN, false);
+    uint32_t sectionsCount = GetRegionSectionsCount(map);
+    for (uint32_t i = 0; read && i < sectionsCount; i++)
+        read = ReadSection(&stream, &region->sections[i]);
+    CloseLevelStream(&stream);
+
+    fclose(file);
+
+    // Regenerate broken files rather than using half read regions
+    if (!read)
+        for (uint32_t i = 0; i < sectionsCount; i++)
+            FreeSection(&region->sections[i]);
+    return read;
+}
+
+// Makes a map of the region size over the region sections and light.
+static void GetRegionWindow(LevelMap* map, LevelMapRegion* region,
+                            LevelMap* window) {
+    memset(window, 0, sizeof(LevelMap));
+    window->width = LEVEL_REGION_SIZE;
+    window->length = LEVEL_REGION_SIZE;
+    window->height = map->height;
+    window->layout = LEVEL_MAP_LAYOUT_SECTIONED;
+    window->sections = region->sections;
+    window->data = region->light;
+
+    // Outside the window unless the spawn is in this region
+    window->spawnX = map->spawnX - (region->x << LEVEL_REGION_SHIFT);
+    window->spawnY = map->spawnY;
+    window->spawnZ = map->spawnZ - (region->z << LEVEL_REGION_SHIFT);
+}
+
+// Reads or generates the region and adds it to the pager.
+static LevelMapRegion* LoadRegion(LevelMap* map, uint16_t regionX,
+                                  uint16_t regionZ) {
+    LevelMapPager* pager = map->pager;
+    uint32_t sectionsCount = GetRegionSectionsCount(map);
+
+    LevelMapRegion* region = new LevelMapRegion;
+    region->x = regionX;
+    region->z = regionZ;
+    region->lastUse = pager->useCounter;
+    region->dirty = false;
+    region->sections = new LevelMapSection[sectionsCount];
+    memset(region->sections, 0, sectionsCount * sizeof(LevelMapSection));
+
+    region->light = NULL;
+
+    LevelMap window;
+    GetRegionWindow(map, region, &window);
+
+    if (!ReadRegion(map, region)) {
+        if (pager->generator)
+            pager->generator(&window, regionX, regionZ, pager->generatorData);
+        CompactMapSections(&window);
+    }
+
+    if (pager->lighter) {
+        uint32_t cellsCount = GetRegionCellsCount(map);
+        region->light = window.data = new uint8_t[cellsCount];
+        memset(region->light, 0, cellsCount);
+        pager->lighter(&window, regionX, regionZ, pager->generatorData);
+    }
+
+    uint16_t bucket = GetRegionBucket(regionX, regionZ);
+    region->next = pager->buckets[bucket];
+    pager->buckets[bucket] = region;
+    pager->regionsCount++;
+
+    return region;
+}
+
+// Removes the region from the pager and frees it.
+static void FreeRegion(LevelMap* map, LevelMapRegion* region) {
+    LevelMapPager* pager = map->pager;
+
+    LevelMapRegion** link = &pager->buckets[GetRegionBucket(region->x,
+                                                            region->z)];
+    while (*link != region) link = &(*link)->next;
+    *link = region->next;
+
+    if (pager->lastRegion == region) pager->lastRegion = NULL;
+    pager->regionsCount--;
+
+    uint32_t sectionsCount = GetRegionSectionsCount(map);
+    for (uint32_t i = 0; i < sectionsCount; i++)
+        FreeSection(&region->sections[i]);
+    delete[] region->sections;
+    if (region->light) delete[] region->light;
+    delete region;
+}
+
+// Makes the map a paged map without resident regions.
+void InitMapPager(LevelMap* map, const char* directory, uint32_t memoryBudget,
+                  LevelMapRegionGenerator generator,
+                  LevelMapRegionGenerator lighter, void* generatorData) {
+    LevelMapPager* pager = new LevelMapPager;
+    memset(pager, 0, sizeof(LevelMapPager));
+    pager->memoryBudget = memoryBudget;
+    pager->generator = generator;
+    pager->lighter = lighter;
+    pager->generatorData = generatorData;
+    strncpy(pager->directory, directory, sizeof(pager->directory) - 1);
+
+    mkdir(pager->directory, 0777);
+
+    map->layout = LEVEL_MAP_LAYOUT_PAGED;
+    map->pager = pager;
+}
+
+// Frees every resident region, without writing them.
+void FreeMapPager(LevelMap* map) {
+    if (!map->pager) return;
+
+    for (uint16_t i = 0; i < LEVEL_PAGER_BUCKETS; i++)
+        while (map->pager->buckets[i])
+            FreeRegion(map, map->pager->buckets[i]);
+
+    delete map->pager;
+    map->pager = NULL;
+}
+
+// Gets the resident region, or NULL.
+LevelMapRegion* GetMapRegion(LevelMapPager* pager, uint16_t regionX,
+                             uint16_t regionZ) {
+    LevelMapRegion* region = pager->lastRegion;
+    if (region && region->x == regionX && region->z == regionZ) return region;
+
+    region = pager->buckets[GetRegionBucket(regionX, regionZ)];
+    while (region && (region->x != regionX || region->z != regionZ))
+        region = region->next;
+
+    if (region) pager->lastRegion = region;
+    return region;
+}
+
+// Makes the regions around x, z resident and evicts the oldest ones.
+void EnsureMapRegions(LevelMap* map, uint16_t x, uint16_t z, uint16_t radius) {
+    LevelMapPager* pager = map->pager;
+    pager->useCounter++;
+
+    uint16_t minX = x - radius;
+    uint16_t minZ = z - radius;
+    uint16_t countX = (((minX & LEVEL_REGION_MASK) + 2 * radius) >>
+                       LEVEL_REGION_SHIFT) + 1;
+    uint16_t countZ = (((minZ & LEVEL_REGION_MASK) + 2 * radius) >>
+                       LEVEL_REGION_SHIFT) + 1;
+
+    for (uint16_t i = 0; i < countX; i++)
+        for (uint16_t j = 0; j < countZ; j++) {
+            uint16_t regionX = ((minX >> LEVEL_REGION_SHIFT) + i) &
+                               (LEVEL_REGIONS_PER_AXIS - 1);
+            uint16_t regionZ = ((minZ >> LEVEL_REGION_SHIFT) + j) &
+                               (LEVEL_REGIONS_PER_AXIS - 1);
+
+            LevelMapRegion* region = GetMapRegion(pager, regionX, regionZ);
+            if (!region) region = LoadRegion(map, regionX, regionZ);
+            region->lastUse = pager->useCounter;
+        }
+
+    uint32_t usage = GetPagerMemoryUsage(map);
+    while (usage > pager->memoryBudget) {
+        LevelMapRegion* oldest = NULL;
+        for (uint16_t i = 0; i < LEVEL_PAGER_BUCKETS; i++)
+            for (LevelMapRegion* region = pager->buckets[i]; region;
+                 region = region->next)
+                if (region->lastUse != pager->useCounter &&
+                    (!oldest || region->lastUse < oldest->lastUse))
+                    oldest = region;
+
+        // Everything left is in use
+        if (!oldest) break;
+
+        // Keep edits that could not be written in memory
+        if (oldest->dirty && !WriteRegion(map, oldest)) {
+            oldest->lastUse = pager->useCounter;
+            continue;
+        }
+
+        usage -= GetRegionMemoryUsage(map, oldest);
+        FreeRegion(map, oldest);
+    }
+}
+
+// Writes the edited regions.
+bool FlushMapPager(LevelMap* map) {
+    bool written = true;
+    for (uint16_t i = 0; i < LEVEL_PAGER_BUCKETS; i++)
+        for (LevelMapRegion* region = map->pager->buckets[i]; region;
+             region = region->next)
+            if (region->dirty && !WriteRegion(map, region)) written = false;
+    return written;
+}
+
+// Deletes the region files written by a previous pager.
+void ClearMapPagerDirectory(LevelMapPager* pager) {
+    DIR* directory = opendir(pager->directory);
+    if (!directory) return;
+
+    char path[LEVEL_REGION_PATH_SIZE];
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL) {
+        if (strncmp(entry->d_name, "r.", 2) != 0) continue;
+        int length = snprintf(path, sizeof(path), "%s%s", pager->directory,
+                              entry->d_name);
+        if (length > 0 && length < (int)sizeof(path)) remove(path);
+    }
+
+    closedir(directory);
+}
+
+// Gets the bytes used by the resident regions.
+uint32_t GetPagerMemoryUsage(LevelMap* map) {
+    uint32_t usage = sizeof(LevelMapPager);
+    for (uint16_t i = 0; i < LEVEL_PAGER_BUCKETS; i++)
+        for (LevelMapRegion* region = map->pager->buckets[i]; region;
+             region = region->next)
+            usage += GetRegionMemoryUsage(map, region);
+    return usage;
+}
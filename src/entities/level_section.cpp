@@ -0,0 +1,186 @@
+#include "entities/level_section.hpp"
+#include <string.h>
+
+// Palette entries for the given bits per cell.
+static inline uint16_t GetPaletteSize(uint8_t bits) {
+    return bits == 8 ? 0 : 1 << bits;
+}
+
+// Bytes of the section storage for the given bits per cell.
+uint16_t GetSectionStorageSize(uint8_t bits) {
+    return GetPaletteSize(bits) + (LEVEL_SECTION_CELLS * bits) / 8;
+}
+
+// Gets the block at the given cell.
+uint8_t GetSectionCell(const LevelMapSection* section, uint16_t cell) {
+    if (section->bits == 0) return section->value;
+
+    const uint8_t* cells = section->storage + GetPaletteSize(section->bits);
+    if (section->bits == 8) return cells[cell];
+
+    uint16_t bitIndex = cell * section->bits;
+    uint8_t index = (cells[bitIndex >> 3] >> (bitIndex & 7)) &
+                    ((1 << section->bits) - 1);
+    return section->storage[index];
+}
+
+// Writes every cell of the section to blocks.
+static void DecodeSection(const LevelMapSection* section, uint8_t* blocks) {
+    for (uint16_t i = 0; i < LEVEL_SECTION_CELLS; i++)
+        blocks[i] = GetSectionCell(section, i);
+}
+
+// Replaces the section content by the given blocks, with the smallest palette.
+static void EncodeSection(LevelMapSection* section, const uint8_t* blocks) {
+    uint8_t paletteIndex[256];
+    uint8_t palette[256];
+    bool used[256] = {false};
+    uint16_t count = 0;
+
+    for (uint16_t i = 0; i < LEVEL_SECTION_CELLS; i++) {
+        if (used[blocks[i]]) continue;
+        used[blocks[i]] = true;
+        paletteIndex[blocks[i]] = count;
+        palette[count++] = blocks[i];
+    }
+
+    FreeSection(section);
+
+    if (count == 1) {
+        section->value = blocks[0];
+        return;
+    }
+
+    uint8_t bits = count <= 2 ? 1 : count <= 4 ? 2 : count <= 16 ? 4 : 8;
+    section->bits = bits;
+    section->paletteCount = bits == 8 ? 0 : count;
+    section->storage = new uint8_t[GetSectionStorageSize(bits)];
+    memset(section->storage, 0, GetSectionStorageSize(bits));
+
+    uint8_t* cells = section->storage + GetPaletteSize(bits);
+    if (bits == 8) {
+        memcpy(cells, blocks, LEVEL_SECTION_CELLS);
+        return;
+    }
+
+    memcpy(section->storage, palette, count);
+    for (uint16_t i = 0; i < LEVEL_SECTION_CELLS; i++) {
+        uint16_t bitIndex = i * bits;
+        cells[bitIndex >> 3] |= paletteIndex[blocks[i]] << (bitIndex & 7);
+    }
+}
+
+// Sets the block at the given cell, growing the palette when needed.
+void SetSectionCell(LevelMapSection* section, uint16_t cell, uint8_t block) {
+    if (section->bits == 0 && section->value == block) return;
+
+    if (section->bits == 8) {
+        section->storage[cell] = block;
+        return;
+    }
+
+    if (section->bits > 0) {
+        uint8_t index = 0;
+        while (index < section->paletteCount &&
+               section->storage[index] != block)
+            index++;
+
+        if (index == section->paletteCount &&
+            section->paletteCount < GetPaletteSize(section->bits))
+            section->storage[section->paletteCount++] = block;
+
+        if (index < section->paletteCount) {
+            uint8_t* cells = section->storage + GetPaletteSize(section->bits);
+            uint16_t bitIndex = cell * section->bits;
+            uint8_t mask = ((1 << section->bits) - 1) << (bitIndex & 7);
+            cells[bitIndex >> 3] = (cells[bitIndex >> 3] & ~mask) |
+                                   (index << (bitIndex & 7));
+            return;
+        }
+    }
+
+    // Uniform section or full palette, re-encode with the new block
+    uint8_t blocks[LEVEL_SECTION_CELLS];
+    DecodeSection(section, blocks);
+    blocks[cell] = block;
+    EncodeSection(section, blocks);
+}
+
+// Drops the palette entries no longer used by any cell.
+void CompactSection(LevelMapSection* section) {
+    if (section->bits == 0) return;
+
+    uint8_t blocks[LEVEL_SECTION_CELLS];
+    DecodeSection(section, blocks);
+    EncodeSection(section, blocks);
+}
+
+// Frees the section storage, leaving it uniform.
+void FreeSection(LevelMapSection* section) {
+    if (section->storage) delete[] section->storage;
+    section->storage = NULL;
+    section->bits = 0;
+    section->paletteCount = 0;
+}
+
+// Copies the header and storage of the source into the target.
+void CopySection(LevelMapSection* target, const LevelMapSection* source) {
+    FreeSection(target);
+    *target = *source;
+    if (!source->bits) return;
+
+    uint16_t size = GetSectionStorageSize(source->bits);
+    target->storage = new uint8_t[size];
+    memcpy(target->storage, source->storage, size);
+}
+
+// Gets the bytes used by the section.
+uint32_t GetSectionMemoryUsage(const LevelMapSection* section) {
+    return sizeof(LevelMapSection) +
+           (section->bits == 0 ? 0 : GetSectionStorageSize(section->bits));
+}
+
+// Copies the cells of the section to blocks.
+void GetSectionCells(const LevelMapSection* section, uint8_t* blocks) {
+    DecodeSection(section, blocks);
+}
+
+// Replaces the cells of the section by blocks.
+void SetSectionCells(LevelMapSection* section, const uint8_t* blocks) {
+    EncodeSection(section, blocks);
+}
+
+// Writes the section header and storage to the stream.
+bool WriteSection(LevelStream* stream, const LevelMapSection* section) {
+    const uint8_t header[3] = {section->bits, section->paletteCount,
+                               section->value};
+    if (!WriteLevelStream(stream, header, sizeof(header))) return false;
+    return section->bits == 0 ||
+           WriteLevelStream(stream, section->storage,
+                            GetSectionStorageSize(section->bits));
+}
+
+// Reads the section header and storage from the stream.
+bool ReadSection(LevelStream* stream, LevelMapSection* section) {
+    uint8_t header[3];
+    if (!ReadLevelStream(stream, header, sizeof(header))) return false;
+
+    section->bits = header[0];
+    section->paletteCount = header[1];
+    section->value = header[2];
+    if (!section->bits) return true;
+
+    if (section->bits != 1 && section->bits != 2 && section->bits != 4 &&
+        section->bits != 8) {
+        section->bits = 0;
+        return false;
+    }
+
+    section->storage = new uint8_t[GetSectionStorageSize(section->bits)];
+    if (ReadLevelStream(stream, section->storage,
+                        GetSectionStorageSize(section->bits)))
+        return true;
+
+    FreeSection(section);
+    return false;
+}
@@ -0,0 +1,404 @@
+#include "entities/level_stream.hpp"
+#include <zlib.h>
+#include <string.h>
+
+// Functions of a codec, by LevelStreamCodec id.
+typedef struct {
+    bool (*open)(LevelStream* stream);
+    bool (*write)(LevelStream* stream, const uint8_t* data, uint32_t size);
+    bool (*read)(LevelStream* stream, uint8_t* data, uint32_t size);
+    // Writes what the codec still holds when writing, then frees its state
+    bool (*close)(LevelStream* stream);
+} LevelStreamCodecFunctions;
+
+// Plain streams read and write the file directly.
+static bool OpenPlainStream(LevelStream*) { return true; }
+
+static bool WritePlainStream(LevelStream* stream, const uint8_t* data,
+                             uint32_t size) {
+    return fwrite(data, size, 1, stream->file) == 1;
+}
+
+static bool ReadPlainStream(LevelStream* stream, uint8_t* data,
+                            uint32_t size) {
+    return fread(data, size, 1, stream->file) == 1;
+}
+
+static bool ClosePlainStream(LevelStream*) { return true; }
+
+typedef struct {
+    z_stream zlib;
+    // Compressed bytes
+    uint8_t buffer[LEVEL_STREAM_BUFFER_SIZE];
+} DeflateState;
+
+// Starts zlib with the small window and memory level.
+static bool OpenDeflateStream(LevelStream* stream) {
+    DeflateState* state = new DeflateState;
+    memset(&state->zlib, 0, sizeof(z_stream));
+    stream->state = state;
+
+    if (!stream->writing)
+        return inflateInit2(&state->zlib, LEVEL_STREAM_WINDOW_BITS) == Z_OK;
+
+    state->zlib.next_out = state->buffer;
+    state->zlib.avail_out = LEVEL_STREAM_BUFFER_SIZE;
+    return deflateInit2(&state->zlib, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                        LEVEL_STREAM_WINDOW_BITS, LEVEL_STREAM_MEM_LEVEL,
+                        Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+// Writes the compressed bytes of the buffer to the file.
+static bool FlushDeflateStream(LevelStream* stream) {
+    DeflateState* state = (DeflateState*)stream->state;
+    uint32_t size = LEVEL_STREAM_BUFFER_SIZE - state->zlib.avail_out;
+    if (size && fwrite(state->buffer, size, 1, stream->file) != 1)
+        return false;
+
+    state->zlib.next_out = state->buffer;
+    state->zlib.avail_out = LEVEL_STREAM_BUFFER_SIZE;
+    return true;
+}
+
+// Compresses the bytes, writing the buffer each time it is full.
+static bool DeflateStream(LevelStream* stream, const uint8_t* data,
+                          uint32_t size, int flush) {
+    z_stream* zlib = &((DeflateState*)stream->state)->zlib;
+    zlib->next_in = (Bytef*)data;
+    zlib->avail_in = size;
+
+    while (true) {
+        int result = deflate(zlib, flush);
+        if (result == Z_STREAM_ERROR) return false;
+        if (zlib->avail_out == 0 && !FlushDeflateStream(stream)) return false;
+
+        if (flush == Z_FINISH ? result == Z_STREAM_END : zlib->avail_in == 0)
+            return true;
+    }
+}
+
+static bool WriteDeflateStream(LevelStream* stream, const uint8_t* data,
+                               uint32_t size) {
+    return DeflateStream(stream, data, size, Z_NO_FLUSH);
+}
+
+// Decompresses size bytes, reading the file a buffer at a time.
+static bool ReadDeflateStream(LevelStream* stream, uint8_t* data,
+                              uint32_t size) {
+    DeflateState* state = (DeflateState*)stream->state;
+    z_stream* zlib = &state->zlib;
+    zlib->next_out = data;
+    zlib->avail_out = size;
+
+    while (zlib->avail_out > 0) {
+        if (zlib->avail_in == 0) {
+            zlib->next_in = state->buffer;
+            zlib->avail_in = fread(state->buffer, 1, LEVEL_STREAM_BUFFER_SIZE,
+                                   stream->file);
+            if (zlib->avail_in == 0) return false;
+        }
+
+        int result = inflate(zlib, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) return zlib->avail_out == 0;
+        if (result != Z_OK) return false;
+    }
+    return true;
+}
+
+static bool CloseDeflateStream(LevelStream* stream) {
+    DeflateState* state = (DeflateState*)stream->state;
+    bool closed = true;
+    if (stream->writing) {
+        closed = stream->failed || (DeflateStream(stream, NULL, 0, Z_FINISH) &&
+                                    FlushDeflateStream(stream));
+        deflateEnd(&state->zlib);
+    } else {
+        inflateEnd(&state->zlib);
+    }
+    delete state;
+    return closed;
+}
+
+// LZ streams are blocks of a u16 unpacked size, a u16 packed size, then the
+// packed bytes, or the unpacked bytes when packing did not shrink them. The
+// packed bytes are sequences of a token, literals count << 4 | match length
+// - LEVEL_LZ_MIN_MATCH, each 15 followed by bytes added until one is not
+// 255, the literals, then the u16 offset back to the match. The last sequence
+// has literals only.
+typedef struct {
+    // Unpacked bytes of the block and the next one to write or read
+    uint8_t block[LEVEL_STREAM_BUFFER_SIZE];
+    uint16_t blockSize;
+    uint16_t blockPosition;
+    uint8_t packed[LEVEL_STREAM_BUFFER_SIZE];
+    // Last position + 1 of each hash of LEVEL_LZ_MIN_MATCH bytes, writing only
+    uint16_t positions[1 << LEVEL_LZ_HASH_BITS];
+} LzState;
+
+static bool OpenLzStream(LevelStream* stream) {
+    LzState* state = new LzState;
+    state->blockSize = 0;
+    state->blockPosition = 0;
+    stream->state = state;
+    return true;
+}
+
+static inline uint32_t ReadLzWord(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) |
+           ((uint32_t)data[3] << 24);
+}
+
+static inline uint32_t HashLzWord(uint32_t word) {
+    return (word * 2654435761u) >> (32 - LEVEL_LZ_HASH_BITS);
+}
+
+// Writes a length over the 15 of its token.
+static bool PackLzLength(uint8_t* packed, uint16_t* size, uint16_t limit,
+                         uint32_t length) {
+    for (length -= 15; length >= 255; length -= 255) {
+        if (*size >= limit) return false;
+        packed[(*size)++] = 255;
+    }
+    if (*size >= limit) return false;
+    packed[(*size)++] = length;
+    return true;
+}
+
+// Writes a sequence, without match when length is 0.
+static bool PackLzSequence(uint8_t* packed, uint16_t* size, uint16_t limit,
+                           const uint8_t* literals, uint32_t literalsCount,
+                           uint16_t offset, uint32_t length) {
+    if (*size >= limit) return false;
+    uint32_t matchCode = length ? length - LEVEL_LZ_MIN_MATCH : 0;
+    packed[(*size)++] = ((literalsCount < 15 ? literalsCount : 15) << 4) |
+                        (matchCode < 15 ? matchCode : 15);
+
+    if (literalsCount >= 15 &&
+        !PackLzLength(packed, size, limit, literalsCount))
+        return false;
+    if (*size + literalsCount > limit) return false;
+    memcpy(&packed[*size], literals, literalsCount);
+    *size += literalsCount;
+    if (!length) return true;
+
+    if (*size + 2 > limit) return false;
+    packed[(*size)++] = offset & 0xFF;
+    packed[(*size)++] = offset >> 8;
+    return matchCode < 15 || PackLzLength(packed, size, limit, matchCode);
+}
+
+// Packs the block, returns 0 when it does not get smaller.
+static uint16_t PackLzBlock(LzState* state) {
+    const uint8_t* block = state->block;
+    const uint16_t blockSize = state->blockSize;
+    const uint16_t limit = blockSize - 1;
+    memset(state->positions, 0, sizeof(state->positions));
+
+    uint16_t size = 0;
+    uint32_t anchor = 0;
+    uint32_t position = 0;
+    while (position + LEVEL_LZ_MIN_MATCH <= blockSize) {
+        uint32_t word = ReadLzWord(&block[position]);
+        uint16_t* entry = &state->positions[HashLzWord(word)];
+        uint32_t candidate = *entry;
+        *entry = position + 1;
+
+        if (!candidate-- || ReadLzWord(&block[candidate]) != word) {
+            position++;
+            continue;
+        }
+
+        uint32_t length = LEVEL_LZ_MIN_MATCH;
+        while (position + length < blockSize &&
+               block[candidate + length] == block[position + length])
+            length++;
+
+        if (!PackLzSequence(state->packed, &size, limit, &block[anchor],
+                            position - anchor, position - candidate, length))
+            return 0;
+        position += length;
+        anchor = position;
+    }
+
+    if (!PackLzSequence(state->packed, &size, limit, &block[anchor],
+                        blockSize - anchor, 0, 0))
+        return 0;
+    return size;
+}
+
+// Writes the block, packed when that makes it smaller.
+static bool FlushLzStream(LevelStream* stream) {
+    LzState* state = (LzState*)stream->state;
+    if (!state->blockSize) return true;
+
+    uint16_t packedSize = PackLzBlock(state);
+    const uint8_t* data = packedSize ? state->packed : state->block;
+    if (!packedSize) packedSize = state->blockSize;
+
+    const uint8_t header[4] = {
+        (uint8_t)(state->blockSize & 0xFF), (uint8_t)(state->blockSize >> 8),
+        (uint8_t)(packedSize & 0xFF), (uint8_t)(packedSize >> 8)};
+    state->blockSize = 0;
+    return fwrite(header, sizeof(header), 1, stream->file) == 1 &&
+           fwrite(data, packedSize, 1, stream->file) == 1;
+}
+
+static bool WriteLzStream(LevelStream* stream, const uint8_t* data,
+                          uint32_t size) {
+    LzState* state = (LzState*)stream->state;
+    while (size > 0) {
+        uint32_t count = LEVEL_STREAM_BUFFER_SIZE - state->blockSize;
+        if (count > size) count = size;
+        memcpy(&state->block[state->blockSize], data, count);
+        state->blockSize += count;
+        data += count;
+        size -= count;
+
+        if (state->blockSize == LEVEL_STREAM_BUFFER_SIZE &&
+            !FlushLzStream(stream))
+            return false;
+    }
+    return true;
+}
+
+// Reads a length over the 15 of its token.
+static bool UnpackLzLength(const uint8_t* packed, uint16_t* position,
+                           uint16_t size, uint32_t* length) {
+    uint8_t byte;
+    do {
+        if (*position >= size) return false;
+        byte = packed[(*position)++];
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Unpacks the sequences of a block, checking every length and offset.
+static bool UnpackLzBlock(LzState* state, uint16_t packedSize) {
+    const uint8_t* packed = state->packed;
+    uint8_t* block = state->block;
+    uint16_t position = 0;
+    uint32_t size = 0;
+
+    while (true) {
+        if (position >= packedSize) return false;
+        uint8_t token = packed[position++];
+
+        uint32_t literalsCount = token >> 4;
+        if (literalsCount == 15 &&
+            !UnpackLzLength(packed, &position, packedSize, &literalsCount))
+            return false;
+        if (position + literalsCount > packedSize ||
+            size + literalsCount > state->blockSize)
+            return false;
+        memcpy(&block[size], &packed[position], literalsCount);
+        position += literalsCount;
+        size += literalsCount;
+        if (position == packedSize) return size == state->blockSize;
+
+        if (position + 2 > packedSize) return false;
+        uint32_t offset = packed[position] | (packed[position + 1] << 8);
+        position += 2;
+        uint32_t length = token & 0x0F;
+        if (length == 15 &&
+            !UnpackLzLength(packed, &position, packedSize, &length))
+            return false;
+        length += LEVEL_LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > size || size + length > state->blockSize)
+            return false;
+        // Byte by byte, the match may overlap the bytes it writes
+        for (uint32_t i = 0; i < length; i++, size++)
+            block[size] = block[size - offset];
+    }
+}
+
+// Reads and unpacks the next block.
+static bool FillLzStream(LevelStream* stream) {
+    LzState* state = (LzState*)stream->state;
+    uint8_t header[4];
+    if (fread(header, sizeof(header), 1, stream->file) != 1) return false;
+
+    state->blockSize = header[0] | (header[1] << 8);
+    state->blockPosition = 0;
+    uint16_t packedSize = header[2] | (header[3] << 8);
+    if (state->blockSize == 0 || state->blockSize > LEVEL_STREAM_BUFFER_SIZE ||
+        packedSize == 0 || packedSize > state->blockSize)
+        return false;
+
+    if (packedSize == state->blockSize)
+        return fread(state->block, packedSize, 1, stream->file) == 1;
+    return fread(state->packed, packedSize, 1, stream->file) == 1 &&
+           UnpackLzBlock(state, packedSize);
+}
+
+static bool ReadLzStream(LevelStream* stream, uint8_t* data, uint32_t size) {
+    LzState* state = (LzState*)stream->state;
+    while (size > 0) {
+        if (state->blockPosition == state->blockSize && !FillLzStream(stream))
+            return false;
+
+        uint32_t count = state->blockSize - state->blockPosition;
+        if (count > size) count = size;
+        memcpy(data, &state->block[state->blockPosition], count);
+        state->blockPosition += count;
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+static bool CloseLzStream(LevelStream* stream) {
+    bool closed = !stream->writing || stream->failed || FlushLzStream(stream);
+    delete (LzState*)stream->state;
+    return closed;
+}
+
+static const LevelStreamCodecFunctions codecs[LEVEL_STREAM_CODECS] = {
+    {OpenPlainStream, WritePlainStream, ReadPlainStream, ClosePlainStream},
+    {OpenDeflateStream, WriteDeflateStream, ReadDeflateStream,
+     CloseDeflateStream},
+    {OpenLzStream, WriteLzStream, ReadLzStream, CloseLzStream},
+};
+
+// Checks a codec id read from a file.
+bool IsLevelStreamCodec(uint8_t codec) { return codec < LEVEL_STREAM_CODECS; }
+
+// Starts the codec of the stream over its file.
+bool OpenLevelStream(LevelStream* stream, FILE* file, LevelStreamCodec codec,
+                     bool writing) {
+    stream->file = file;
+    stream->codec = codec;
+    stream->writing = writing;
+    stream->state = NULL;
+    stream->failed = !IsLevelStreamCodec(codec) || !codecs[codec].open(stream);
+    return !stream->failed;
+}
+
+// Writes the bytes through the codec.
+bool WriteLevelStream(LevelStream* stream, const void* data, uint32_t size) {
+    if (stream->failed || !stream->writing) return false;
+    if (size == 0) return true;
+
+    stream->failed =
+        !codecs[stream->codec].write(stream, (const uint8_t*)data, size);
+    return !stream->failed;
+}
+
+// Reads the bytes through the codec.
+bool ReadLevelStream(LevelStream* stream, void* data, uint32_t size) {
+    if (stream->failed || stream->writing) return false;
+    if (size == 0) return true;
+
+    stream->failed = !codecs[stream->codec].read(stream, (uint8_t*)data, size);
+    return !stream->failed;
+}
+
+// Ends the codec, writing what it still holds.
+bool CloseLevelStream(LevelStream* stream) {
+    if (IsLevelStreamCodec(stream->codec) &&
+        !codecs[stream->codec].close(stream))
+        stream->failed = true;
+    stream->state = NULL;
+    return !stream->failed;
+}
@@ -1,4 +1,5 @@
 #include "entities/player/player.hpp"
+#include "managers/profiler_manager.hpp"
 
 using Tyra::Renderer3D;
 
@@ -44,7 +45,6 @@ Player::Player(Renderer* t_renderer, SoundManager* t_soundManager,
 }
 
 Player::~Player() {
-  currentBlock = nullptr;
   delete hitBox;
   delete handledItem;
   delete this->renderPip;
@@ -73,9 +73,9 @@ Player::~Player() {
 // ----
 
 void Player::update(const float& deltaTime, const Vec4& movementDir,
-                    const Vec4& camDir,
-                    const std::vector<Chunck*>& loadedChunks,
+                    const Vec4& camDir, LevelMap* terrain,
                     TerrainHeightModel* terrainHeight) {
+  ProfilerScope profile(ProfilerStage::PlayerUpdate);
   isMoving = movementDir.length() >= L_JOYPAD_DEAD_ZONE;
   if (isMoving) {
     // Vec4 min, max;
@@ -91,13 +91,19 @@ void Player::update(const float& deltaTime, const Vec4& movementDir,
     // if (min.x < MAX_WORLD_POS.x && max.x > MIN_WORLD_POS.x &&
     //     min.y < MAX_WORLD_POS.y && max.y > MIN_WORLD_POS.y &&
     //     min.z < MAX_WORLD_POS.z && max.z > MIN_WORLD_POS.z) {
-    if (nextPlayerPos.collidesBox(MIN_WORLD_POS, MAX_WORLD_POS)) {
+    // Only walk over available terrain, infinite worlds end at the resident
+    // regions
+    const int nextOffsetX = floorf(nextPlayerPos.x / DUBLE_BLOCK_SIZE + 0.5F);
+    const int nextOffsetZ = floorf(nextPlayerPos.z / DUBLE_BLOCK_SIZE + 0.5F);
+    if (nextOffsetX >= 0 && nextOffsetZ >= 0 &&
+        BoundCheckMap(terrain, nextOffsetX, 0, nextOffsetZ)) {
       const bool hasChangedPosition =
-          this->updatePosition(loadedChunks, deltaTime, nextPlayerPos);
+          this->updatePosition(terrain, deltaTime, nextPlayerPos);
 
-      if (hasChangedPosition && this->isOnGround && this->currentBlock) {
+      if (hasChangedPosition && this->isOnGround &&
+          this->currentBlock > Blocks::AIR_BLOCK) {
         if (lastTimePlayedWalkSfx > 0.3F) {
-          this->playWalkSfx(this->currentBlock->type);
+          this->playWalkSfx(this->currentBlock);
           setWalkingAnimation();
           lastTimePlayedWalkSfx = 0;
         } else {
@@ -206,125 +212,90 @@ void Player::fly(const float& deltaTime,
   mesh->getPosition()->set(newYPosition);
 }
 
-u8 Player::updatePosition(const std::vector<Chunck*>& loadedChunks,
-                          const float& deltaTime, const Vec4& nextPlayerPos,
-                          u8 isColliding) {
-  Vec4 currentPlayerPos = *this->mesh->getPosition();
+u8 Player::updatePosition(LevelMap* terrain, const float& deltaTime,
+                          const Vec4& nextPlayerPos) {
+  Vec4* currentPlayerPos = this->mesh->getPosition();
   Vec4 playerMin;
   Vec4 playerMax;
-  BBox playerBB = getHitBox();
-  playerBB.getMinMax(&playerMin, &playerMax);
-
-  // Set ray props
-  Vec4 rayOrigin = ((playerMax - playerMin) / 2) + playerMin;
-  Vec4 rayDir = nextPlayerPos - currentPlayerPos;
-  rayDir.normalize();
-  const Ray ray = Ray(rayOrigin, rayDir);
-
-  float finalHitDistance = -1.0f;
-  float tempHitDistance = -1.0f;
-  const float maxCollidableDistance =
-      currentPlayerPos.distanceTo(nextPlayerPos);
-
-  for (size_t chunkIndex = 0; chunkIndex < loadedChunks.size(); chunkIndex++) {
-    for (size_t i = 0; i < loadedChunks[chunkIndex]->blocks.size(); i++) {
-      // Broad phase
-      // is vertically out of range?
-      if (playerBB.getBottomFace().axisPosition >=
-              loadedChunks[chunkIndex]->blocks[i]->maxCorner.y ||
-          playerBB.getTopFace().axisPosition <
-              loadedChunks[chunkIndex]->blocks[i]->minCorner.y ||
-          currentPlayerPos.distanceTo(
-              *loadedChunks[chunkIndex]->blocks[i]->getPosition()) >
-              DUBLE_BLOCK_SIZE * 2) {
-        continue;
-      };
-
-      Vec4 tempInflatedMin;
-      Vec4 tempInflatedMax;
-      Utils::GetMinkowskiSum(playerMin, playerMax,
-                             loadedChunks[chunkIndex]->blocks[i]->minCorner,
-                             loadedChunks[chunkIndex]->blocks[i]->maxCorner,
-                             &tempInflatedMin, &tempInflatedMax);
-
-      if (ray.intersectBox(tempInflatedMin, tempInflatedMax,
-                           &tempHitDistance)) {
-        // Is horizontally collidable?
-        if (tempHitDistance > maxCollidableDistance) continue;
-
-        if (finalHitDistance == -1.0f || tempHitDistance < finalHitDistance) {
-          finalHitDistance = tempHitDistance;
-        }
-      }
-    }
-  }
-
-  // Will collide somewhere;
-  if (finalHitDistance > -1.0f) {
-    const float timeToHit = finalHitDistance / this->speed;
+  getHitBox().getMinMax(&playerMin, &playerMax);
 
-    // Will collide this frame;
-    if (timeToHit < deltaTime ||
-        finalHitDistance <
-            this->mesh->getPosition()->distanceTo(nextPlayerPos)) {
-      if (isColliding) return false;
+  float boxMin[3] = {playerMin.x, playerMin.y, playerMin.z};
+  float boxMax[3] = {playerMax.x, playerMax.y, playerMax.z};
 
-      // Try to move in separated axis;
-      Vec4 moveOnXOnly =
-          Vec4(nextPlayerPos.x, currentPlayerPos.y, currentPlayerPos.z);
-      if (updatePosition(loadedChunks, deltaTime, moveOnXOnly, 1)) return true;
+  // Sweep the hitbox along x and then z, so it slides along the walls
+  const float moveX =
+      SweepBoxInMap(terrain, boxMin, boxMax, 0,
+                    nextPlayerPos.x - currentPlayerPos->x, DUBLE_BLOCK_SIZE,
+                    (u8)Blocks::AIR_BLOCK);
+  boxMin[0] += moveX;
+  boxMax[0] += moveX;
 
-      Vec4 moveOnZOnly =
-          Vec4(currentPlayerPos.x, nextPlayerPos.y, currentPlayerPos.z);
-      if (updatePosition(loadedChunks, deltaTime, moveOnZOnly, 1)) return true;
+  const float moveZ =
+      SweepBoxInMap(terrain, boxMin, boxMax, 2,
+                    nextPlayerPos.z - currentPlayerPos->z, DUBLE_BLOCK_SIZE,
+                    (u8)Blocks::AIR_BLOCK);
 
-      return false;
-    }
-  }
+  if (moveX == 0.0F && moveZ == 0.0F) return false;
 
   // Apply new position;
-  mesh->getPosition()->x = nextPlayerPos.x;
-  mesh->getPosition()->z = nextPlayerPos.z;
+  currentPlayerPos->x += moveX;
+  currentPlayerPos->z += moveZ;
   return true;
 }
 
-TerrainHeightModel Player::getTerrainHeightAtPosition(
-    const std::vector<Chunck*>& loadedChunks) {
+TerrainHeightModel Player::getTerrainHeightAtPosition(LevelMap* terrain) {
   TerrainHeightModel model;
-  BBox playerBB = this->getHitBox();
   Vec4 minPlayer, maxPlayer;
-  playerBB.getMinMax(&minPlayer, &maxPlayer);
-
-  this->currentBlock = nullptr;
-
-  for (size_t chunkIndex = 0; chunkIndex < loadedChunks.size(); chunkIndex++) {
-    for (size_t i = 0; i < loadedChunks[chunkIndex]->blocks.size(); i++) {
-      // Is on block?
-      if (minPlayer.x < loadedChunks[chunkIndex]->blocks[i]->maxCorner.x &&
-          maxPlayer.x > loadedChunks[chunkIndex]->blocks[i]->minCorner.x &&
-          minPlayer.z < loadedChunks[chunkIndex]->blocks[i]->maxCorner.z &&
-          maxPlayer.z > loadedChunks[chunkIndex]->blocks[i]->minCorner.z) {
-        const float underBlockHeight =
-            loadedChunks[chunkIndex]->blocks[i]->maxCorner.y;
-        if (minPlayer.y >= underBlockHeight &&
-            underBlockHeight > model.minHeight) {
-          model.minHeight = underBlockHeight;
-          this->currentBlock = loadedChunks[chunkIndex]->blocks[i];
-        }
+  this->getHitBox().getMinMax(&minPlayer, &maxPlayer);
 
-        const float overBlockHeight =
-            loadedChunks[chunkIndex]->blocks[i]->minCorner.y;
-        if (maxPlayer.y <= overBlockHeight &&
-            overBlockHeight < model.maxHeight) {
-          model.maxHeight = overBlockHeight;
-        }
-      }
-    }
+  this->currentBlock = Blocks::VOID;
+
+  const float boxMin[3] = {minPlayer.x, minPlayer.y, minPlayer.z};
+  const float boxMax[3] = {maxPlayer.x, maxPlayer.y, maxPlayer.z};
+
+  // Sweep the hitbox down to the bottom and up to the top of the world
+  const float worldBottom = OVERWORLD_MIN_HEIGH * DUBLE_BLOCK_SIZE - BLOCK_SIZE;
+  const float worldTop = OVERWORLD_MAX_HEIGH * DUBLE_BLOCK_SIZE - BLOCK_SIZE;
+
+  const float toGround = worldBottom - minPlayer.y;
+  const float down = SweepBoxInMap(terrain, boxMin, boxMax, 1, toGround,
+                                   DUBLE_BLOCK_SIZE, (u8)Blocks::AIR_BLOCK);
+  if (down != toGround) {
+    model.minHeight = minPlayer.y + down;
+    this->currentBlock = getBlockUnderFootprint(terrain, minPlayer, maxPlayer,
+                                                model.minHeight);
   }
 
+  const float toTop = worldTop - maxPlayer.y;
+  const float up = SweepBoxInMap(terrain, boxMin, boxMax, 1, toTop,
+                                 DUBLE_BLOCK_SIZE, (u8)Blocks::AIR_BLOCK);
+  if (up != toTop) model.maxHeight = maxPlayer.y + up;
+
   return model;
 }
 
+Blocks Player::getBlockUnderFootprint(LevelMap* terrain, const Vec4& minPlayer,
+                                      const Vec4& maxPlayer,
+                                      const float& groundHeight) {
+  const int y = Utils::GetBlockOffsetFromPosition(groundHeight - BLOCK_SIZE);
+  const int minX = Utils::GetBlockOffsetFromPosition(minPlayer.x);
+  const int maxX = Utils::GetBlockOffsetFromPosition(maxPlayer.x);
+  const int minZ = Utils::GetBlockOffsetFromPosition(minPlayer.z);
+  const int maxZ = Utils::GetBlockOffsetFromPosition(maxPlayer.z);
+
+  for (int x = minX; x <= maxX; x++) {
+    for (int z = minZ; z <= maxZ; z++) {
+      if (!BoundCheckMap(terrain, x, y, z)) continue;
+
+      const u8 blockType = GetBlockFromMap(terrain, x, y, z);
+      if (blockType > (u8)Blocks::AIR_BLOCK)
+        return static_cast<Blocks>(blockType);
+    }
+  }
+
+  return Blocks::VOID;
+}
+
 /**
  * Inventory controllers
  *
@@ -0,0 +1,107 @@
+#include "managers/autosave_manager.hpp"
+#include "managers/save_manager.hpp"
+#include <stdint.h>
+#include <time.h>
+
+// Bricks written between two checks of the frame budget
+#define AUTOSAVE_BRICKS_PER_STEP 4
+
+AutosaveManager::AutosaveManager() {}
+
+AutosaveManager::~AutosaveManager() {}
+
+void AutosaveManager::update(StateGamePlay* state, const float& deltaTime) {
+  this->elapsedTime += deltaTime;
+  if (this->elapsedTime >= AUTOSAVE_INTERVAL && !this->isSaving()) {
+    TYRA_LOG("Autosaving...");
+    this->start(state, state->getSaveFilePath(), SAVE_FILE_QUICK_CODEC);
+  }
+
+  if (this->isSaving()) this->write(AUTOSAVE_BUDGET_MS);
+}
+
+void AutosaveManager::start(StateGamePlay* state, const std::string& fullPath,
+                            const LevelStreamCodec codec) {
+  this->finish();
+  this->elapsedTime = 0.0F;
+
+  this->t_map = CrossCraft_World_GetMapPtr();
+  this->savePath = fullPath;
+  this->tempPath = fullPath + ".tmp";
+
+  // Infinite worlds keep their blocks in the region files, the pager already
+  // wrote most of them back when evicting
+  if (this->t_map->pager && !FlushMapPager(this->t_map))
+    TYRA_WARN("Failed to write terrain regions");
+
+  this->saveFile = fopen(this->tempPath.c_str(), "wb");
+  if (!this->saveFile) {
+    TYRA_WARN("Failed to open the save file: ", this->tempPath.c_str());
+    return;
+  }
+
+  SaveGameModel model;
+  SaveManager::GetSaveGameModel(state, &model);
+  this->written = SaveManager::WriteSaveHeader(this->saveFile, &model, codec);
+  this->written =
+      OpenLevelStream(&this->blocksStream, this->saveFile, codec, true) &&
+      this->written;
+
+  if (this->written && !this->t_map->pager)
+    this->written = CreateMapSnapshot(this->t_map);
+  if (!this->written || this->t_map->pager) this->close();
+}
+
+void AutosaveManager::finish() {
+  if (this->isSaving()) this->write(0.0F);
+}
+
+// Writes bricks until the save is complete or budgetMs went by, all of them
+// without budget
+void AutosaveManager::write(const float& budgetMs) {
+  const clock_t deadline =
+      clock() + (clock_t)(budgetMs * CLOCKS_PER_SEC / 1000.0F);
+  const uint32_t bricksPerStep =
+      budgetMs > 0.0F ? AUTOSAVE_BRICKS_PER_STEP : UINT32_MAX;
+
+  bool done = false;
+  do {
+    this->written = WriteMapSnapshot(this->t_map, &this->blocksStream,
+                                     bricksPerStep, &done);
+  } while (this->written && !done && clock() < deadline);
+
+  if (!this->written || done) this->close();
+}
+
+// Replaces the save by the temporary file once it is completely written
+void AutosaveManager::close() {
+  FreeMapSnapshot(this->t_map);
+  if (!CloseLevelStream(&this->blocksStream)) this->written = false;
+  if (fclose(this->saveFile) != 0) this->written = false;
+  this->saveFile = nullptr;
+
+  if (!this->written) {
+    TYRA_WARN("Failed to write the save file: ", this->savePath.c_str());
+    remove(this->tempPath.c_str());
+    return;
+  }
+
+  // rename does not replace an existing file on every device, the previous
+  // save is moved aside until the new one is in place
+  const std::string backupPath = this->savePath + ".bak";
+  remove(backupPath.c_str());
+  const bool backedUp =
+      rename(this->savePath.c_str(), backupPath.c_str()) == 0;
+
+  if (rename(this->tempPath.c_str(), this->savePath.c_str()) == 0) {
+    remove(backupPath.c_str());
+    TYRA_LOG("Saved at: ", this->savePath.c_str());
+    return;
+  }
+
+  // The complete save is kept, and the previous one put back
+  if (backedUp) rename(backupPath.c_str(), this->savePath.c_str());
+  this->written = false;
+  TYRA_WARN("Failed to replace the save file, the new save is kept at: ",
+            this->tempPath.c_str());
+}
@@ -2,6 +2,7 @@
 #include "file/file_utils.hpp"
 #include <math/vec4.hpp>
 #include "constants.hpp"
+#include <draw_sampling.h>
 
 using Tyra::FileUtils;
 using Tyra::McpipBlock;
@@ -58,6 +59,29 @@ BlockInfo* BlockManager::getBlockInfoByType(const Blocks& blockType) {
   return this->t_blockTextureRepository->getTextureInfo(blockType);
 }
 
+void BlockManager::useAtlasTile(const u8& col, const u8& row) {
+  const u32 tileWidth = blocksTexAtlas->getWidth() / 16;
+  const u32 tileHeight = blocksTexAtlas->getHeight() / 16;
+
+  // GS region repeat: u = (u & minu) | maxu
+  texwrap_t wrap;
+  wrap.horizontal = WRAP_REGION_REPEAT;
+  wrap.vertical = WRAP_REGION_REPEAT;
+  wrap.minu = tileWidth - 1;
+  wrap.maxu = col * tileWidth;
+  wrap.minv = tileHeight - 1;
+  wrap.maxv = row * tileHeight;
+
+  blocksTexAtlas->setWrapSettings(wrap);
+  isAtlasTiled = true;
+}
+
+void BlockManager::useWholeAtlas() {
+  if (!isAtlasTiled) return;
+  blocksTexAtlas->setDefaultWrapSettings();
+  isAtlasTiled = false;
+}
+
 const u8 BlockManager::isBlockTransparent(const Blocks& blockType) {
   return this->t_blockTextureRepository->isBlockTransparent(blockType);
 }
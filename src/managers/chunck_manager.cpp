@@ -1,4 +1,5 @@
 #include "managers/chunck_manager.hpp"
+#include "managers/profiler_manager.hpp"
 #include "math/plane.hpp"
 
 using Tyra::M4x4;
@@ -16,7 +17,7 @@ ChunckManager::~ChunckManager() {
   chuncks.shrink_to_fit();
 }
 
-void ChunckManager::init() { generateChunks(); }
+void ChunckManager::init(LevelMap* terrain) { this->terrain = terrain; }
 
 void ChunckManager::clearAllChunks() {
   for (u16 i = 0; i < chuncks.size(); i++) chuncks[i]->clear();
@@ -25,6 +26,7 @@ void ChunckManager::clearAllChunks() {
 void ChunckManager::update(const Plane* frustumPlanes,
                            const Vec4& currentPlayerPos,
                            WorldLightModel* worldLightModel) {
+  ProfilerScope profile(ProfilerStage::ChunksUpdate);
   visibleChunks.clear();
   visibleChunks.shrink_to_fit();
   for (u16 i = 0; i < chuncks.size(); i++) {
@@ -41,49 +43,61 @@ void ChunckManager::renderer(Renderer* t_renderer, StaticPipeline* stapip,
       chuncks[i]->renderer(t_renderer, stapip, t_blockManager);
 }
 
-void ChunckManager::generateChunks() {
-  u16 tempId = 1;
-
-  for (size_t x = 0; x < OVERWORLD_MAX_DISTANCE; x += CHUNCK_SIZE) {
-    for (size_t z = 0; z < OVERWORLD_MAX_DISTANCE; z += CHUNCK_SIZE) {
-      for (size_t y = 0; y < OVERWORLD_MAX_HEIGH; y += CHUNCK_SIZE) {
-        Vec4 tempMin = Vec4(x, y, z);
-        Vec4 tempMax = Vec4(x + CHUNCK_SIZE, y + CHUNCK_SIZE, z + CHUNCK_SIZE);
-        Chunck* tempChunck = new Chunck(tempMin, tempMax, tempId);
-        chuncks.push_back(tempChunck);
-        tempId++;
-      }
+Chunck* ChunckManager::getChunckByGridPosition(const int& x, const int& y,
+                                               const int& z) {
+  auto it = chuncksByGridPosition.find(getGridKey(x, y, z));
+  return it != chuncksByGridPosition.end() ? it->second : nullptr;
+}
+
+Chunck* ChunckManager::getOrCreateChunckByGridPosition(const int& x,
+                                                       const int& y,
+                                                       const int& z) {
+  Chunck* chunck = getChunckByGridPosition(x, y, z);
+  if (chunck) return chunck;
+
+  if (x < 0 || y < 0 || z < 0 ||
+      !BoundCheckMap(terrain, x * CHUNCK_SIZE, y * CHUNCK_SIZE,
+                     z * CHUNCK_SIZE))
+    return nullptr;
+
+  Vec4 tempMin = Vec4(x * CHUNCK_SIZE, y * CHUNCK_SIZE, z * CHUNCK_SIZE);
+  Vec4 tempMax = tempMin + Vec4(CHUNCK_SIZE, CHUNCK_SIZE, CHUNCK_SIZE);
+  chunck = new Chunck(tempMin, tempMax, ++lastChunckId);
+
+  chuncks.push_back(chunck);
+  chuncksByGridPosition[getGridKey(x, y, z)] = chunck;
+
+  return chunck;
+}
+
+Chunck* ChunckManager::getOrCreateChunckByPosition(const Vec4& position) {
+  const float chunckWorldSize = CHUNCK_SIZE * DUBLE_BLOCK_SIZE;
+  return getOrCreateChunckByGridPosition(floor(position.x / chunckWorldSize),
+                                         floor(position.y / chunckWorldSize),
+                                         floor(position.z / chunckWorldSize));
+}
+
+void ChunckManager::releaseChunck(Chunck* t_chunck) {
+  chuncksByGridPosition.erase(getGridKey(t_chunck->minOffset->x / CHUNCK_SIZE,
+                                         t_chunck->minOffset->y / CHUNCK_SIZE,
+                                         t_chunck->minOffset->z / CHUNCK_SIZE));
+
+  for (size_t i = 0; i < chuncks.size(); i++) {
+    if (chuncks[i] == t_chunck) {
+      chuncks.erase(chuncks.begin() + i);
+      break;
     }
   }
-};
 
-Chunck* ChunckManager::getChunckByPosition(const Vec4& position) {
-  for (u16 i = 0; i < chuncks.size(); i++)
-    if (position.collidesBox(*chuncks[i]->minOffset * DUBLE_BLOCK_SIZE,
-                             *chuncks[i]->maxOffset * DUBLE_BLOCK_SIZE)) {
-      return chuncks[i];
+  for (size_t i = 0; i < visibleChunks.size(); i++) {
+    if (visibleChunks[i] == t_chunck) {
+      visibleChunks.erase(visibleChunks.begin() + i);
+      break;
     }
-  return nullptr;
-};
-
-Chunck* ChunckManager::getChunckByOffset(const Vec4& offset) {
-  for (size_t i = 0; i < chuncks.size(); i++)
-    if (chuncks[i]->isVisible() && offset.x >= chuncks[i]->minOffset->x &&
-        offset.x < chuncks[i]->maxOffset->x &&
-        offset.y >= chuncks[i]->minOffset->y &&
-        offset.y < chuncks[i]->maxOffset->y &&
-        offset.z >= chuncks[i]->minOffset->z &&
-        offset.z < chuncks[i]->maxOffset->z) {
-      return chuncks[i];
-    }
-  return nullptr;
-};
+  }
 
-Chunck* ChunckManager::getChunckById(const u16& id) {
-  for (u16 i = 0; i < chuncks.size(); i++)
-    if (chuncks[i]->id == id) return chuncks[i];
-  return nullptr;
-};
+  delete t_chunck;
+}
 
 u8 ChunckManager::isChunkVisible(Chunck* chunk) { return chunk->isVisible(); }
 
@@ -0,0 +1,324 @@
+#include "managers/chunck_mesh_builder.hpp"
+#include <algorithm>
+
+ChunckMeshBuilder::ChunckMeshBuilder() { loadFaceTables(); }
+
+ChunckMeshBuilder::~ChunckMeshBuilder() {}
+
+void ChunckMeshBuilder::init(BlockManager* t_blockManager) {
+  for (u8 i = 0; i < (u8)Blocks::TOTAL_OF_BLOCKS; i++) {
+    blocksInfo[i] = nullptr;
+    transparentBlocks[i] = true;
+  }
+
+  for (u8 i = (u8)Blocks::AIR_BLOCK + 1; i < (u8)Blocks::TOTAL_OF_BLOCKS;
+       i++) {
+    blocksInfo[i] = t_blockManager->getBlockInfoByType(static_cast<Blocks>(i));
+    transparentBlocks[i] = blocksInfo[i] && blocksInfo[i]->_isTransparent;
+  }
+}
+
+void ChunckMeshBuilder::loadFaceTables() {
+  const Vec4* rawData = VertexBlockData::getVertexData();
+  for (u8 face = 0; face < FACES_COUNT; face++) {
+    for (u8 i = 0; i < VERTICES_PER_FACE; i++) {
+      const Vec4& corner = rawData[face * VERTICES_PER_FACE + i];
+      faceVertices[face][i] = Vec4(corner.x * BLOCK_SIZE, corner.y * BLOCK_SIZE,
+                                   corner.z * BLOCK_SIZE, 0.0F);
+    }
+  }
+  delete[] rawData;
+
+  const s8 neighbors[FACES_COUNT][3] = {{0, 1, 0},  {0, -1, 0}, {0, 0, -1},
+                                        {0, 0, 1},  {1, 0, 0},  {-1, 0, 0}};
+
+  // Tile corner (col, row) deltas of each face vertex
+  const u8 topUVs[VERTICES_PER_FACE][2] = {{0, 1}, {1, 0}, {1, 1},
+                                           {0, 1}, {0, 0}, {1, 0}};
+  const u8 leftUVs[VERTICES_PER_FACE][2] = {{1, 1}, {0, 0}, {1, 0},
+                                            {1, 1}, {0, 1}, {0, 0}};
+  const u8 rightUVs[VERTICES_PER_FACE][2] = {{0, 0}, {1, 1}, {0, 1},
+                                             {0, 0}, {1, 0}, {1, 1}};
+  const u8(*uvs[FACES_COUNT])[2] = {topUVs,   topUVs,   leftUVs,
+                                    rightUVs, rightUVs, topUVs};
+
+  for (u8 face = 0; face < FACES_COUNT; face++) {
+    for (u8 axis = 0; axis < 3; axis++)
+      faceNeighbors[face][axis] = neighbors[face][axis];
+
+    for (u8 i = 0; i < VERTICES_PER_FACE; i++) {
+      faceUVs[face][i][0] = uvs[face][i][0];
+      faceUVs[face][i][1] = uvs[face][i][1];
+    }
+  }
+
+  const u8 axes[FACES_COUNT][3] = {{1, 0, 2}, {1, 0, 2}, {2, 0, 1},
+                                   {2, 0, 1}, {0, 2, 1}, {0, 2, 1}};
+  for (u8 face = 0; face < FACES_COUNT; face++)
+    for (u8 axis = 0; axis < 3; axis++) faceAxes[face][axis] = axes[face][axis];
+
+  faceMapIndex[Top] = 0;
+  faceMapIndex[Bottom] = 2;
+  faceMapIndex[Left] = 4;
+  faceMapIndex[Right] = 6;
+  faceMapIndex[Back] = 10;
+  faceMapIndex[Front] = 8;
+}
+
+bool ChunckMeshBuilder::isTransparentAt(LevelMap* terrain, const u16& x,
+                                        const u16& y, const u16& z) {
+  if (!BoundCheckMap(terrain, x, y, z)) return false;
+
+  const u8 blockType = GetBlockFromMap(terrain, x, y, z);
+  return blockType <= (u8)Blocks::AIR_BLOCK ||
+         blockType >= (u8)Blocks::TOTAL_OF_BLOCKS ||
+         transparentBlocks[blockType];
+}
+
+u8 ChunckMeshBuilder::getVisibleFaces(LevelMap* terrain, const u16& x,
+                                      const u16& y, const u16& z) {
+  u8 result = 0;
+  for (u8 face = 0; face < FACES_COUNT; face++) {
+    if (isTransparentAt(terrain, x + faceNeighbors[face][0],
+                        y + faceNeighbors[face][1],
+                        z + faceNeighbors[face][2]))
+      result |= 1 << face;
+  }
+  return result;
+}
+
+void ChunckMeshBuilder::build(LevelMap* terrain, const Vec4& minOffset,
+                              const Vec4& maxOffset,
+                              std::vector<Vec4>* vertices,
+                              std::vector<u16>* lights,
+                              std::vector<Vec4>* uvMap,
+                              std::vector<ChunckDrawGroup>* groups) {
+  const u16 minX = minOffset.x, minY = minOffset.y, minZ = minOffset.z;
+  const u16 maxX = maxOffset.x, maxY = maxOffset.y, maxZ = maxOffset.z;
+
+  // First pass: visible faces of each cell, counted to reserve once
+  u32 facesCount = 0;
+  u16 cell = 0;
+  for (u16 y = minY; y < maxY; y++) {
+    for (u16 z = minZ; z < maxZ; z++) {
+      for (u16 x = minX; x < maxX; x++, cell++) {
+        cellFaces[cell] = 0;
+        cellTypes[cell] = (u8)Blocks::VOID;
+
+        if (!BoundCheckMap(terrain, x, y, z)) continue;
+
+        const u8 blockType = GetBlockFromMap(terrain, x, y, z);
+        if (blockType <= (u8)Blocks::AIR_BLOCK ||
+            blockType >= (u8)Blocks::TOTAL_OF_BLOCKS ||
+            blocksInfo[blockType] == nullptr)
+          continue;
+
+        cellTypes[cell] = blockType;
+        cellFaces[cell] = getVisibleFaces(terrain, x, y, z);
+        facesCount += __builtin_popcount(cellFaces[cell]);
+
+        // Visible faces look into cells inside the terrain
+        for (u8 face = 0; face < FACES_COUNT; face++)
+          if (cellFaces[cell] & (1 << face))
+            cellLights[cell][face] = GetDataFromMap(
+                terrain, x + faceNeighbors[face][0],
+                y + faceNeighbors[face][1], z + faceNeighbors[face][2]);
+      }
+    }
+  }
+
+  if (greedyMeshing) {
+    collectGreedyQuads();
+
+    // Only the transparent faces are still emitted one by one
+    facesCount = greedyQuads.size();
+    for (u16 i = 0; i < CHUNCK_LENGTH; i++)
+      if (cellFaces[i] && transparentBlocks[cellTypes[i]])
+        facesCount += __builtin_popcount(cellFaces[i]);
+  }
+
+  const u32 verticesCount = facesCount * VERTICES_PER_FACE;
+  vertices->reserve(verticesCount);
+  lights->reserve(verticesCount);
+  uvMap->reserve(verticesCount);
+
+  if (greedyMeshing) {
+    // One group per tile, quads are sorted by it
+    for (size_t i = 0; i < greedyQuads.size(); i++) {
+      if (i == 0 || greedyQuads[i].tile != greedyQuads[i - 1].tile) {
+        ChunckDrawGroup group;
+        group.first = vertices->size();
+        group.isTiled = true;
+        group.tileCol = (greedyQuads[i].tile - 1) >> 8;
+        group.tileRow = (greedyQuads[i].tile - 1) & 0xFF;
+        groups->push_back(group);
+      }
+
+      emitGreedyQuad(greedyQuads[i], vertices, lights, uvMap);
+      groups->back().count = vertices->size() - groups->back().first;
+    }
+  }
+
+  // Opaque blocks first, then the transparent ones
+  ChunckDrawGroup facesGroup;
+  facesGroup.first = vertices->size();
+
+  for (u8 transparent = greedyMeshing; transparent < 2; transparent++) {
+    cell = 0;
+    for (u16 y = minY; y < maxY; y++) {
+      for (u16 z = minZ; z < maxZ; z++) {
+        for (u16 x = minX; x < maxX; x++, cell++) {
+          if (!cellFaces[cell] ||
+              transparentBlocks[cellTypes[cell]] != transparent)
+            continue;
+
+          const Vec4 localPosition =
+              Vec4((x - minX) * DUBLE_BLOCK_SIZE, (y - minY) * DUBLE_BLOCK_SIZE,
+                   (z - minZ) * DUBLE_BLOCK_SIZE, 1.0F);
+          emitFaces(cellTypes[cell], cellFaces[cell], cellLights[cell],
+                    localPosition, vertices, lights, uvMap);
+        }
+      }
+    }
+  }
+
+  facesGroup.count = vertices->size() - facesGroup.first;
+  if (facesGroup.count > 0) groups->push_back(facesGroup);
+}
+
+u16 ChunckMeshBuilder::getFaceTile(const u8& blockType, const u8& face) {
+  const BlockInfo* blockInfo = blocksInfo[blockType];
+  const u8 mapIndex = blockInfo->_isSingle ? 0 : faceMapIndex[face];
+  return ((blockInfo->_facesMap[mapIndex] << 8) |
+          blockInfo->_facesMap[mapIndex + 1]) +
+         1;
+}
+
+void ChunckMeshBuilder::collectGreedyQuads() {
+  greedyQuads.clear();
+
+  for (u8 face = 0; face < FACES_COUNT; face++)
+    for (u8 slice = 0; slice < CHUNCK_SIZE; slice++) mergeSlice(face, slice);
+
+  std::stable_sort(greedyQuads.begin(), greedyQuads.end(),
+                   [](const GreedyQuad& a, const GreedyQuad& b) {
+                     return a.tile < b.tile;
+                   });
+}
+
+void ChunckMeshBuilder::mergeSlice(const u8& face, const u8& slice) {
+  const u8* axes = faceAxes[face];
+  u8 local[3];
+  local[axes[0]] = slice;
+
+  // Light << 16 | tile of each visible opaque face of the slice, 0 when
+  // there is none
+  for (u8 b = 0; b < CHUNCK_SIZE; b++) {
+    for (u8 a = 0; a < CHUNCK_SIZE; a++) {
+      local[axes[1]] = a;
+      local[axes[2]] = b;
+      const u16 cell =
+          (local[1] * CHUNCK_SIZE + local[2]) * CHUNCK_SIZE + local[0];
+
+      sliceMask[b][a] = 0;
+      if ((cellFaces[cell] & (1 << face)) &&
+          !transparentBlocks[cellTypes[cell]])
+        sliceMask[b][a] = (cellLights[cell][face] << 16) |
+                          getFaceTile(cellTypes[cell], face);
+    }
+  }
+
+  for (u8 b = 0; b < CHUNCK_SIZE; b++) {
+    for (u8 a = 0; a < CHUNCK_SIZE;) {
+      const u32 tile = sliceMask[b][a];
+      if (!tile) {
+        a++;
+        continue;
+      }
+
+      u8 width = 1;
+      while (a + width < CHUNCK_SIZE && sliceMask[b][a + width] == tile)
+        width++;
+
+      u8 height = 1;
+      for (; b + height < CHUNCK_SIZE; height++) {
+        u8 k = 0;
+        while (k < width && sliceMask[b + height][a + k] == tile) k++;
+        if (k < width) break;
+      }
+
+      for (u8 j = 0; j < height; j++)
+        for (u8 k = 0; k < width; k++) sliceMask[b + j][a + k] = 0;
+
+      GreedyQuad quad;
+      quad.face = face;
+      quad.slice = slice;
+      quad.a = a;
+      quad.b = b;
+      quad.width = width;
+      quad.height = height;
+      quad.tile = tile & 0xFFFF;
+      quad.light = tile >> 16;
+      greedyQuads.push_back(quad);
+
+      a += width;
+    }
+  }
+}
+
+void ChunckMeshBuilder::emitGreedyQuad(const GreedyQuad& quad,
+                                       std::vector<Vec4>* vertices,
+                                       std::vector<u16>* lights,
+                                       std::vector<Vec4>* uvMap) {
+  const float scale = 1.0F / 16.0F;
+  const u8* axes = faceAxes[quad.face];
+  const u16 light = (quad.face << 8) | quad.light;
+
+  for (u8 i = 0; i < VERTICES_PER_FACE; i++) {
+    const Vec4& corner = faceVertices[quad.face][i];
+    float position[3] = {corner.x, corner.y, corner.z};
+
+    // Stretch the unit face corners over the merged cells
+    position[axes[0]] += quad.slice * DUBLE_BLOCK_SIZE;
+    position[axes[1]] +=
+        (position[axes[1]] < 0 ? quad.a : quad.a + quad.width - 1) *
+        DUBLE_BLOCK_SIZE;
+    position[axes[2]] +=
+        (position[axes[2]] < 0 ? quad.b : quad.b + quad.height - 1) *
+        DUBLE_BLOCK_SIZE;
+
+    vertices->push_back(Vec4(position[0], position[1], position[2], 1.0F));
+    lights->push_back(light);
+
+    // Repeat the tile once per merged cell, the atlas wrap keeps it inside
+    uvMap->push_back(Vec4(faceUVs[quad.face][i][0] * quad.width * scale,
+                          faceUVs[quad.face][i][1] * quad.height * scale,
+                          1.0F, 0.0F));
+  }
+}
+
+void ChunckMeshBuilder::emitFaces(const u8& blockType, const u8& visibleFaces,
+                                  const u8* faceLights,
+                                  const Vec4& localPosition,
+                                  std::vector<Vec4>* vertices,
+                                  std::vector<u16>* lights,
+                                  std::vector<Vec4>* uvMap) {
+  const float scale = 1.0F / 16.0F;
+  const BlockInfo* blockInfo = blocksInfo[blockType];
+
+  for (u8 face = 0; face < FACES_COUNT; face++) {
+    if (!(visibleFaces & (1 << face))) continue;
+
+    const u8 mapIndex = blockInfo->_isSingle ? 0 : faceMapIndex[face];
+    const float X = blockInfo->_facesMap[mapIndex];
+    const float Y = blockInfo->_facesMap[mapIndex + 1];
+    const u16 light = (face << 8) | faceLights[face];
+
+    for (u8 i = 0; i < VERTICES_PER_FACE; i++) {
+      vertices->push_back(localPosition + faceVertices[face][i]);
+      lights->push_back(light);
+      uvMap->push_back(Vec4((X + faceUVs[face][i][0]) * scale,
+                            (Y + faceUVs[face][i][1]) * scale, 1.0F, 0.0F));
+    }
+  }
+}
@@ -1,9 +1,182 @@
 #define FNL_IMPL
 #include <managers/cross_craft_world_generator.hpp>
+#include <thread>
+#include <string.h>
+#include <vector>
 #define _USE_MATH_DEFINES
 
+// Only read while generating, so the workers can share it
 static fnl_state state;
 static int32_t worldgen_seed;
+static uint8_t worldgen_workers = WORLDGEN_DEFAULT_WORKERS;
+
+// Map cell of the window origin, when generating a region of a paged world
+static int worldgen_origin_x = 0;
+static int worldgen_origin_z = 0;
+static bool worldgen_windowed = false;
+
+#define WORLDGEN_RAND_MAX 0x7FFFFFFF
+
+// Keys of the random streams, features of the second woods plants pass are
+// keyed by the stage | 1 << 8
+enum {
+  STAGE_BEDROCK = 1,
+  STAGE_CAVES,
+  STAGE_COAL,
+  STAGE_IRON,
+  STAGE_GOLD,
+  STAGE_WATER,
+  STAGE_LAVA,
+  STAGE_FLOWERS,
+  STAGE_SHROOMS,
+  STAGE_TREES,
+  STAGE_LEAVES,
+};
+
+// Counter based random numbers: the nth number of a stream is a hash of the
+// stream key and n, so no stream depends on what was drawn before it
+typedef struct {
+  uint32_t key;
+  uint32_t counter;
+} worldgen_random;
+
+static inline uint32_t worldgen_mix(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85EBCA6B;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35;
+  h ^= h >> 16;
+  return h;
+}
+
+static inline uint32_t worldgen_hash(uint32_t key, uint32_t value) {
+  return worldgen_mix(key ^ worldgen_mix(value + 0x9E3779B9));
+}
+
+// Gets the stream of the stage at x, z, world cells for cell streams and the
+// window origin for feature streams
+static worldgen_random worldgen_stream(uint32_t stage, int32_t x, int32_t z,
+                                       uint32_t index) {
+  worldgen_random random;
+  random.key = worldgen_hash(worldgen_seed, stage);
+  random.key = worldgen_hash(random.key, x);
+  random.key = worldgen_hash(random.key, z);
+  random.key = worldgen_hash(random.key, index);
+  random.counter = 0;
+  return random;
+}
+
+// Gets the stream of the index feature of the stage in the current window
+static worldgen_random feature_stream(uint32_t stage, uint32_t index) {
+  return worldgen_stream(stage, worldgen_origin_x, worldgen_origin_z, index);
+}
+
+static inline int worldgen_rand(worldgen_random* random) {
+  return worldgen_hash(random->key, random->counter++) & WORLDGEN_RAND_MAX;
+}
+
+static inline float worldgen_randf(worldgen_random* random) {
+  return worldgen_rand(random) / (float)WORLDGEN_RAND_MAX;
+}
+
+// Features per window, rounding the remainder randomly so small windows still
+// get features on average
+static int feature_count(uint32_t stage, float count) {
+  int result = (int)count;
+  worldgen_random random = feature_stream(stage, 0xFFFFFFFF);
+  if (worldgen_windowed && worldgen_randf(&random) < count - result) result++;
+  return result;
+}
+
+// Noise fields of the map columns, length (X) by width (Z) like the
+// heightmap. Evaluated once by create_noise_grids, NULL fields are skipped
+typedef struct {
+  // noise1 and noise2 at 1.3 scale, and noise3, for the heightmap
+  float* heightLow;
+  float* heightHigh;
+  float* heightSelect;
+  // noise1 and noise2 at 2 scale, for the erosion
+  float* erosion;
+  float* erosionParity;
+  // 8 octaves of the noise3 field, for the strata
+  float* dirtThickness;
+  // noise1 and noise2, for the surface
+  float* sand;
+  float* gravel;
+} worldgen_grids;
+
+// Spheroid of a cave or an ore vein, filled where it crosses the columns
+// being generated
+typedef struct {
+  int16_t x;
+  int16_t y;
+  int16_t z;
+  int16_t radius;
+} worldgen_spheroid;
+
+// Tree attempt, the space for it is checked when its columns are generated
+typedef struct {
+  uint16_t x;
+  uint16_t z;
+  uint8_t height;
+  uint8_t pass;
+  // Attempt of its pass, keys the stream of its leaves
+  uint32_t index;
+} worldgen_tree;
+
+// Features crossing columns, staged from their streams before any column is
+// generated, so each column reads the same features whatever the order
+typedef struct {
+  std::vector<worldgen_spheroid> caves;
+  std::vector<worldgen_spheroid> coal;
+  std::vector<worldgen_spheroid> iron;
+  std::vector<worldgen_spheroid> gold;
+  std::vector<worldgen_tree> trees;
+  // Plants stand plantsOffset cells above the cell over the heightmap
+  int plantsOffset;
+} worldgen_features;
+
+// Columns [minX, maxX) x [minZ, maxZ) of the map generated by one worker
+typedef struct {
+  LevelMap* map;
+  int16_t* heightmap;
+  // Bottom of the floating islands
+  int16_t* heightmap2;
+  worldgen_grids* grids;
+  const worldgen_features* features;
+  uint16_t minX;
+  uint16_t maxX;
+  uint16_t minZ;
+  uint16_t maxZ;
+} worldgen_slab;
+
+typedef void (*worldgen_pass)(const worldgen_slab* slab);
+
+// Runs the pass over one x slab of the whole slab per worker, the calling
+// thread taking the first one. Slabs are whole bricks, so workers never write
+// the same section, and passes only write cells of their slab, whatever they
+// read.
+static void run_pass(const worldgen_slab* whole, worldgen_pass pass) {
+  const uint16_t bricks = (whole->maxX - whole->minX) >> LEVEL_MAP_BRICK_SHIFT;
+  uint16_t workers = worldgen_workers < bricks ? worldgen_workers : bricks;
+  if (workers == 0) workers = 1;
+
+  worldgen_slab slabs[WORLDGEN_MAX_WORKERS];
+  for (uint16_t i = 0; i < workers; i++) {
+    slabs[i] = *whole;
+    slabs[i].minX =
+        whole->minX + ((bricks * i / workers) << LEVEL_MAP_BRICK_SHIFT);
+    slabs[i].maxX =
+        whole->minX + ((bricks * (i + 1) / workers) << LEVEL_MAP_BRICK_SHIFT);
+  }
+  slabs[workers - 1].maxX = whole->maxX;
+
+  std::thread threads[WORLDGEN_MAX_WORKERS];
+  for (uint16_t i = 1; i < workers; i++)
+    threads[i] = std::thread(pass, &slabs[i]);
+  pass(&slabs[0]);
+  for (uint16_t i = 1; i < workers; i++) threads[i].join();
+}
 
 void CrossCraft_WorldGenerator_Init(int32_t seed) {
   state = fnlCreateState();
@@ -13,6 +186,12 @@ void CrossCraft_WorldGenerator_Init(int32_t seed) {
   worldgen_seed = seed;
 }
 
+void CrossCraft_WorldGenerator_SetWorkers(uint8_t workers) {
+  if (workers < 1) workers = 1;
+  if (workers > WORLDGEN_MAX_WORKERS) workers = WORLDGEN_MAX_WORKERS;
+  worldgen_workers = workers;
+}
+
 float noise3d(float x, float y, float z) {
   float freq = 0.05f;
   return fnlGetNoise3D(&state, x * freq, y * freq, z * freq);
@@ -20,20 +199,20 @@ float noise3d(float x, float y, float z) {
 
 // AMPLIFIED: amp = 2
 float octave_noise(uint8_t octaves, float x, float y, uint16_t seed_modifier) {
+  // Octaves reseed a copy, the shared state is never written
+  fnl_state octave = state;
   float sum = 0;
   float amp = 1.5f;
   float freq = 1;
 
   for (uint8_t i = 0; i < octaves; i++) {
-    state.seed += seed_modifier;
-    sum += fnlGetNoise2D(&state, x * freq, y * freq) * amp;
+    octave.seed += seed_modifier;
+    sum += fnlGetNoise2D(&octave, x * freq, y * freq) * amp;
 
     amp *= 2;
     freq /= 2;
   }
 
-  state.seed = worldgen_seed;
-
   return sum;
 }
 
@@ -49,27 +228,174 @@ float noise2(float x, float y) { return combined_noise(8, x, y, 2); }
 
 float noise3(float x, float y) { return octave_noise(6, x, y, 0); }
 
+// Points of the noise rows evaluated per batch
+#define WORLDGEN_ROW_BATCH 64
+
+// Adds the octaves [first, last) of octave_noise at count points to sums.
+// Points are batched per octave through fnlGetNoise2DRow, and each sum adds
+// its octaves in the octave_noise order.
+static void octave_noise_row(uint8_t first, uint8_t last, const float* xs,
+                             const float* ys, uint16_t count,
+                             uint16_t seed_modifier, float* sums) {
+  fnl_state octave = state;
+  float amp = 1.5f;
+  float freq = 1;
+
+  float batchX[WORLDGEN_ROW_BATCH];
+  float batchY[WORLDGEN_ROW_BATCH];
+  float noise[WORLDGEN_ROW_BATCH];
+
+  for (uint8_t i = 0; i < last; i++) {
+    octave.seed += seed_modifier;
+
+    for (uint16_t start = 0; i >= first && start < count;
+         start += WORLDGEN_ROW_BATCH) {
+      const uint16_t batch = count - start < WORLDGEN_ROW_BATCH
+                                 ? count - start
+                                 : WORLDGEN_ROW_BATCH;
+      for (uint16_t j = 0; j < batch; j++) {
+        batchX[j] = xs[start + j] * freq;
+        batchY[j] = ys[start + j] * freq;
+      }
+
+      fnlGetNoise2DRow(&octave, batchX, batchY, batch, noise);
+      for (uint16_t j = 0; j < batch; j++) sums[start + j] += noise[j] * amp;
+    }
+
+    amp *= 2;
+    freq /= 2;
+  }
+}
+
+// Writes combined_noise at count points to result, warped is scratch space
+static void combined_noise_row(uint8_t octaves, const float* xs,
+                               const float* ys, uint16_t count,
+                               uint16_t seed_modifier, float* warped,
+                               float* result) {
+  memset(warped, 0, count * sizeof(float));
+  octave_noise_row(0, octaves, xs, ys, count, seed_modifier, warped);
+  for (uint16_t j = 0; j < count; j++) warped[j] += xs[j];
+
+  memset(result, 0, count * sizeof(float));
+  octave_noise_row(0, octaves, warped, ys, count, seed_modifier, result);
+}
+
 // Height of water
 const int waterLevel = 32;
 
+// Fills the slab columns of one grid with combined_noise at the given scale,
+// one z row per x
+static void fill_combined_grid(const worldgen_slab* slab, float scale,
+                               uint16_t seed_modifier, float* grid,
+                               float* row) {
+  const uint16_t length = slab->map->length;
+  const uint16_t count = slab->maxZ - slab->minZ;
+  float* xs = row;
+  float* zs = row + count;
+  float* warped = row + 2 * count;
+  float* result = row + 3 * count;
+
+  for (int x = slab->minX; x < slab->maxX; x++) {
+    for (int i = 0; i < count; i++) {
+      xs[i] = (float)(x + worldgen_origin_x) * scale;
+      zs[i] = (float)(slab->minZ + i + worldgen_origin_z) * scale;
+    }
+
+    combined_noise_row(8, xs, zs, count, seed_modifier, warped, result);
+    for (int i = 0; i < count; i++)
+      grid[x + (slab->minZ + i) * length] = result[i];
+  }
+}
+
+// Noise grid stage, evaluating each field of the slab columns once for the
+// heightmap, erosion, strata and surface passes to read
+void create_noise_grids(const worldgen_slab* slab) {
+  const uint16_t length = slab->map->length;
+  const uint16_t count = slab->maxZ - slab->minZ;
+  worldgen_grids* grids = slab->grids;
+  float* row = new float[4 * count];
+
+  if (grids->heightLow)
+    fill_combined_grid(slab, 1.3f, 1, grids->heightLow, row);
+  if (grids->heightHigh)
+    fill_combined_grid(slab, 1.3f, 2, grids->heightHigh, row);
+  if (grids->erosion) fill_combined_grid(slab, 2, 1, grids->erosion, row);
+  if (grids->erosionParity)
+    fill_combined_grid(slab, 2, 2, grids->erosionParity, row);
+  if (grids->sand) fill_combined_grid(slab, 1, 1, grids->sand, row);
+  if (grids->gravel) fill_combined_grid(slab, 1, 2, grids->gravel, row);
+
+  // noise3 is the first 6 octaves of the dirt thickness noise
+  float* xs = row;
+  float* zs = row + count;
+  float* select = row + 2 * count;
+  float* dirt = row + 3 * count;
+  for (int x = slab->minX; x < slab->maxX; x++) {
+    for (int i = 0; i < count; i++) {
+      xs[i] = (float)(x + worldgen_origin_x);
+      zs[i] = (float)(slab->minZ + i + worldgen_origin_z);
+    }
+
+    memset(select, 0, count * sizeof(float));
+    octave_noise_row(0, 6, xs, zs, count, 0, select);
+    memcpy(dirt, select, count * sizeof(float));
+    if (grids->dirtThickness)
+      octave_noise_row(6, 8, xs, zs, count, 0, dirt);
+
+    for (int i = 0; i < count; i++) {
+      const uint32_t index = x + (slab->minZ + i) * length;
+      if (grids->heightSelect) grids->heightSelect[index] = select[i];
+      if (grids->dirtThickness) grids->dirtThickness[index] = dirt[i];
+    }
+  }
+
+  delete[] row;
+}
+
+// Allocates the grids of the generator passes, heights for the heightmap
+// and erosion fields
+static void create_grids(worldgen_grids* grids, LevelMap* map, bool heights) {
+  const uint32_t cells = map->length * map->width;
+  memset(grids, 0, sizeof(worldgen_grids));
+  if (heights) {
+    grids->heightLow = new float[cells];
+    grids->heightHigh = new float[cells];
+    grids->heightSelect = new float[cells];
+    grids->erosion = new float[cells];
+    grids->erosionParity = new float[cells];
+  }
+  grids->dirtThickness = new float[cells];
+  grids->sand = new float[cells];
+  grids->gravel = new float[cells];
+}
+
+static void free_grids(worldgen_grids* grids) {
+  delete[] grids->heightLow;
+  delete[] grids->heightHigh;
+  delete[] grids->heightSelect;
+  delete[] grids->erosion;
+  delete[] grids->erosionParity;
+  delete[] grids->dirtThickness;
+  delete[] grids->sand;
+  delete[] grids->gravel;
+}
+
 /**
- * Generates a heightmap
- * @param heightmap Map to generate
- * @param length Length of map (X)
- * @param width Width of map (Z)
+ * Generates the heightmap of the slab columns from the noise grids
+ * @param slab Columns to generate, the heightmap is length (X) by width (Z)
  */
-void create_heightmap(int16_t* heightmap, uint16_t length, uint16_t width) {
-  for (int x = 0; x < length; x++) {
-    for (int z = 0; z < width; z++) {
-      float xf = (float)x;
-      float zf = (float)z;
-
-      float heightLow = noise1(xf * 1.3f, zf * 1.3f) / 6 - 4;
-      float heightHigh = noise2(xf * 1.3f, zf * 1.3f) / 5 + 6;
+void create_heightmap(const worldgen_slab* slab) {
+  const uint16_t length = slab->map->length;
+  const worldgen_grids* grids = slab->grids;
+  for (int x = slab->minX; x < slab->maxX; x++) {
+    for (int z = slab->minZ; z < slab->maxZ; z++) {
+      const uint32_t index = x + z * length;
+      float heightLow = grids->heightLow[index] / 6 - 4;
+      float heightHigh = grids->heightHigh[index] / 5 + 6;
 
       float hResult = 0.0f;
 
-      if (noise3(xf, zf) / 8 > 0) {
+      if (grids->heightSelect[index] / 8 > 0) {
         hResult = heightLow;
       } else {
         if (heightHigh > heightLow)
@@ -82,22 +408,22 @@ void create_heightmap(int16_t* heightmap, uint16_t length, uint16_t width) {
 
       if (hResult < 0) hResult *= 0.8f;
 
-      heightmap[x + z * length] = (int16_t)(hResult + (float)waterLevel);
+      slab->heightmap[x + z * length] = (int16_t)(hResult + (float)waterLevel);
     }
   }
 }
 
 /**
- * Smooths out the heightmap
- * @param heightmap Map to smooth
- * @param length Length of map (X)
- * @param width Length of map (Z)
+ * Smooths out the heightmap of the slab columns from the noise grids
+ * @param slab Columns to smooth
  */
-void smooth_heightmap(int16_t* heightmap, uint16_t length, uint16_t width) {
-  for (int x = 0; x < length; x++) {
-    for (int z = 0; z < width; z++) {
-      float a = noise1((float)x * 2, (float)z * 2) / 8.0f;
-      float b = (noise2((float)x * 2, (float)z * 2) > 0) ? 1 : 0;
+void smooth_heightmap(const worldgen_slab* slab) {
+  const uint16_t length = slab->map->length;
+  int16_t* heightmap = slab->heightmap;
+  for (int x = slab->minX; x < slab->maxX; x++) {
+    for (int z = slab->minZ; z < slab->maxZ; z++) {
+      float a = slab->grids->erosion[x + z * length] / 8.0f;
+      float b = (slab->grids->erosionParity[x + z * length] > 0) ? 1 : 0;
 
       if (a > 2) {
         float c = ((float)heightmap[x + z * length] - b) / 2;
@@ -109,30 +435,43 @@ void smooth_heightmap(int16_t* heightmap, uint16_t length, uint16_t width) {
   }
 }
 
-void smooth_distance(int16_t* heightmap, uint16_t length, uint16_t width) {
+void smooth_distance(const worldgen_slab* slab) {
+  const uint16_t length = slab->map->length;
+  const uint16_t width = slab->map->width;
   int midl = length / 2;
   int midw = width / 2;
 
   float maxDist = sqrtf(length * length + width * width) / 2;
 
-  for (int x = 0; x < length; x++) {
-    for (int z = 0; z < width; z++) {
+  for (int x = slab->minX; x < slab->maxX; x++) {
+    for (int z = slab->minZ; z < slab->maxZ; z++) {
       int diffX = midl - x;
       int diffZ = midw - z;
 
       float dist = sqrtf(diffX * diffX + diffZ * diffZ) / maxDist;
 
-      heightmap[x + z * length] =
-          ((1 - dist) + 0.2f) * (float)heightmap[x + z * length];
+      slab->heightmap[x + z * length] =
+          ((1 - dist) + 0.2f) * (float)slab->heightmap[x + z * length];
     }
   }
 }
 
-void create_strata(LevelMap* map, const int16_t* heightmap) {
-  for (uint16_t x = 0; x < map->length; x++) {
-    for (uint16_t z = 0; z < map->width; z++) {
-      float dirt_thickness = octave_noise(8, x, z, 0) / 24.0f - 4.0f;
-      int dirt_transition = heightmap[x + z * map->length];
+// Bedrock or stone, the same for a world cell whatever generates it
+static uint8_t bedrock_or_stone(int x, int z) {
+  worldgen_random random = worldgen_stream(
+      STAGE_BEDROCK, x + worldgen_origin_x, z + worldgen_origin_z, 0);
+  return worldgen_rand(&random) % 2 == 0
+             ? static_cast<uint8_t>(Blocks::BEDROCK_BLOCK)
+             : static_cast<uint8_t>(Blocks::STONE_BLOCK);
+}
+
+void create_strata(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+  for (uint16_t x = slab->minX; x < slab->maxX; x++) {
+    for (uint16_t z = slab->minZ; z < slab->maxZ; z++) {
+      float dirt_thickness =
+          slab->grids->dirtThickness[x + z * map->length] / 24.0f - 4.0f;
+      int dirt_transition = slab->heightmap[x + z * map->length];
       int stone_transition = dirt_transition + dirt_thickness;
 
       for (int y = 0; y < 64; y++) {
@@ -141,9 +480,7 @@ void create_strata(LevelMap* map, const int16_t* heightmap) {
         if (y == 0) {
           block_type = static_cast<uint8_t>(Blocks::BEDROCK_BLOCK);
         } else if (y == 1) {
-          block_type = rand() % 2 == 0
-                           ? static_cast<uint8_t>(Blocks::BEDROCK_BLOCK)
-                           : static_cast<uint8_t>(Blocks::STONE_BLOCK);
+          block_type = bedrock_or_stone(x, z);
         } else if (y <= stone_transition) {
           block_type = static_cast<uint8_t>(Blocks::STONE_BLOCK);
         } else if (y <= dirt_transition) {
@@ -156,17 +493,18 @@ void create_strata(LevelMap* map, const int16_t* heightmap) {
   }
 }
 
-void create_strata2(LevelMap* map, const int16_t* heightmap,
-                    const int16_t* heightmap2) {
-  for (uint16_t x = 0; x < map->length; x++) {
-    for (uint16_t z = 0; z < map->width; z++) {
-      float dirt_thickness = octave_noise(8, x, z, 0) / 24.0f - 4.0f;
-      int dirt_transition = heightmap[x + z * map->length];
+void create_strata2(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+  for (uint16_t x = slab->minX; x < slab->maxX; x++) {
+    for (uint16_t z = slab->minZ; z < slab->maxZ; z++) {
+      float dirt_thickness =
+          slab->grids->dirtThickness[x + z * map->length] / 24.0f - 4.0f;
+      int dirt_transition = slab->heightmap[x + z * map->length];
       if (dirt_transition >= 63 || dirt_transition <= 0) continue;
 
       int stone_transition = dirt_transition + dirt_thickness;
 
-      int start = heightmap2[x + z * map->length];
+      int start = slab->heightmap2[x + z * map->length];
 
       for (int y = dirt_transition; y >= start; y--) {
         int block_type = static_cast<uint8_t>(Blocks::AIR_BLOCK);
@@ -187,19 +525,30 @@ void create_strata2(LevelMap* map, const int16_t* heightmap,
   }
 }
 
-// The fillOblateSpheroid function takes in a pointer to a LevelMap structure,
+// The fillOblateSpheroid function takes in a pointer to a slab of a LevelMap,
 // the center coordinates (center_x, center_y, center_z) of an oblate spheroid,
 // the radius of the spheroid, and a block type represented as a uint8_t value.
 // It then iterates over all points within the given radius of the center and
 // checks if the point is within the spheroid and has a block type of 1.
 // If so, it sets the block at that point to the given block type.
+// Points outside the slab are skipped, they are filled by its worker or when
+// their columns are generated.
 // This function is useful for filling an oblate spheroid with a specific block
 // type in a level map.
-void fillOblateSpheroid(LevelMap* map, int center_x, int center_y, int center_z,
-                        int radius, uint8_t blk) {
-  for (int x = center_x - radius; x <= center_x + radius; x++) {
+void fillOblateSpheroid(const worldgen_slab* slab, int center_x, int center_y,
+                        int center_z, int radius, uint8_t blk) {
+  LevelMap* map = slab->map;
+  const int min_x = center_x - radius > slab->minX ? center_x - radius
+                                                   : slab->minX;
+  const int max_x = center_x + radius < slab->maxX - 1 ? center_x + radius
+                                                       : slab->maxX - 1;
+  const int min_z = center_z - radius > slab->minZ ? center_z - radius
+                                                   : slab->minZ;
+  const int max_z = center_z + radius < slab->maxZ - 1 ? center_z + radius
+                                                       : slab->maxZ - 1;
+  for (int x = min_x; x <= max_x; x++) {
     for (int y = center_y - radius; y <= center_y + radius; y++) {
-      for (int z = center_z - radius; z <= center_z + radius; z++) {
+      for (int z = min_z; z <= max_z; z++) {
         // Check if point is within bounds of map and has block type of 1
         if (BoundCheckMap(map, x, y, z) &&
             GetBlockFromMap(map, x, y, z) ==
@@ -212,25 +561,38 @@ void fillOblateSpheroid(LevelMap* map, int center_x, int center_y, int center_z,
   }
 }
 
-void create_caves(LevelMap* map) {
-  int num_caves = (map->length * map->height * map->width) / 8192;
+static void fill_spheroids(const worldgen_slab* slab,
+                           const std::vector<worldgen_spheroid>& spheroids,
+                           uint8_t blk) {
+  for (const worldgen_spheroid& spheroid : spheroids)
+    fillOblateSpheroid(slab, spheroid.x, spheroid.y, spheroid.z,
+                       spheroid.radius, blk);
+}
+
+// Walks every cave of the map once, staging the spheroids carving it. Caves
+// only turn stone into void, so the carved map does not depend on the order
+// columns are carved.
+static void stage_caves(LevelMap* map, worldgen_features* features) {
+  int num_caves = feature_count(
+      STAGE_CAVES, (map->length * map->height * map->width) / 8192.0f);
   for (int i = 0; i < num_caves; i++) {
-    int cave_x = rand() % map->length;
-    int cave_y = rand() % map->height;
-    int cave_z = rand() % map->width;
+    worldgen_random random = feature_stream(STAGE_CAVES, i);
+    int cave_x = worldgen_rand(&random) % map->length;
+    int cave_y = worldgen_rand(&random) % map->height;
+    int cave_z = worldgen_rand(&random) % map->width;
 
     // Generate a random cave length
     int cave_length =
-        (int)((rand() / (float)RAND_MAX + rand() / (float)RAND_MAX) * 200.0f);
+        (int)((worldgen_randf(&random) + worldgen_randf(&random)) * 200.0f);
 
     // Generate random initial angles and rate of change
-    float theta = rand() / (float)RAND_MAX * M_PI * 2.0f;
+    float theta = worldgen_randf(&random) * M_PI * 2.0f;
     float delta_theta = 0.0f;
-    float phi = rand() / (float)RAND_MAX * M_PI * 2.0f;
+    float phi = worldgen_randf(&random) * M_PI * 2.0f;
     float delta_phi = 0.0f;
 
     // Generate a random cave radius
-    float cave_radius = rand() / (float)RAND_MAX * rand() / (float)RAND_MAX;
+    float cave_radius = worldgen_randf(&random) * worldgen_randf(&random);
 
     for (int len = 0; len < cave_length; len++) {
       // Update cave position using the given angles
@@ -241,43 +603,53 @@ void create_caves(LevelMap* map) {
       // Update angles and rate of change
       theta += delta_theta * 0.2f;
       delta_theta = (delta_theta * 0.9f) +
-                    (rand() / (float)RAND_MAX - rand() / (float)RAND_MAX);
+                    (worldgen_randf(&random) - worldgen_randf(&random));
       phi += delta_phi / 4.0f;
       delta_phi = (delta_phi * 0.75f) +
-                  (rand() / (float)RAND_MAX - rand() / (float)RAND_MAX);
+                  (worldgen_randf(&random) - worldgen_randf(&random));
 
-      if (rand() / (float)RAND_MAX >= 0.25f) {
+      if (worldgen_randf(&random) >= 0.25f) {
         // Generate a random center position
-        int center_x = cave_x + (rand() % 4 - 2) * 0.2f;
-        int center_y = cave_y + (rand() % 4 - 2) * 0.2f;
-        int center_z = cave_z + (rand() % 4 - 2) * 0.2f;
+        int center_x = cave_x + (worldgen_rand(&random) % 4 - 2) * 0.2f;
+        int center_y = cave_y + (worldgen_rand(&random) % 4 - 2) * 0.2f;
+        int center_z = cave_z + (worldgen_rand(&random) % 4 - 2) * 0.2f;
 
         // Compute the radius based on the height
         float radius = (map->height - center_y) / (float)map->height;
         radius = 1.2f + (radius * 3.5f + 1) * cave_radius;
         radius = radius * sinf(len * M_PI / cave_length);
 
-        fillOblateSpheroid(map, center_x, center_y, center_z, radius, 0);
+        features->caves.push_back({(int16_t)center_x, (int16_t)center_y,
+                                   (int16_t)center_z, (int16_t)radius});
       }
     }
   }
 }
 
-void create_vein(LevelMap* map, float abundance, uint8_t type) {
-  int num_veins = (map->length * map->height * map->width * abundance) / 16384;
+void create_caves(const worldgen_slab* slab) {
+  fill_spheroids(slab, slab->features->caves, 0);
+}
+
+// Veins of one ore only turn stone into that ore, so like caves they can be
+// staged once and filled column by column
+static void stage_veins(LevelMap* map, uint32_t stage, float abundance,
+                        std::vector<worldgen_spheroid>* veins) {
+  int num_veins = feature_count(
+      stage, (map->length * map->height * map->width * abundance) / 16384.0f);
   for (int i = 0; i < num_veins; i++) {
-    int vein_x = rand() % map->length;
-    int vein_y = rand() % map->height;
-    int vein_z = rand() % map->width;
+    worldgen_random random = feature_stream(stage, i);
+    int vein_x = worldgen_rand(&random) % map->length;
+    int vein_y = worldgen_rand(&random) % map->height;
+    int vein_z = worldgen_rand(&random) % map->width;
 
     // Generate a random cave length
-    int veinLength = (rand() / (float)RAND_MAX) * (rand() / (float)RAND_MAX) *
-                     75 * abundance;
+    int veinLength =
+        worldgen_randf(&random) * worldgen_randf(&random) * 75 * abundance;
 
     // Generate random initial angles and rate of change
-    float theta = (rand() / (float)RAND_MAX) * M_PI * 2;
+    float theta = worldgen_randf(&random) * M_PI * 2;
     float delta_theta = 0;
-    float phi = (rand() / (float)RAND_MAX) * M_PI * 2;
+    float phi = worldgen_randf(&random) * M_PI * 2;
     float delta_phi = 0;
 
     for (int len = 0; len < veinLength; len++) {
@@ -289,28 +661,47 @@ void create_vein(LevelMap* map, float abundance, uint8_t type) {
       // Update angles and rate of change
       theta += delta_theta * 0.2f;
       delta_theta = (delta_theta * 0.9f) +
-                    (rand() / (float)RAND_MAX - rand() / (float)RAND_MAX);
+                    (worldgen_randf(&random) - worldgen_randf(&random));
       phi += delta_phi / 4.0f;
       delta_phi = (delta_phi * 0.9f) +
-                  (rand() / (float)RAND_MAX - rand() / (float)RAND_MAX);
+                  (worldgen_randf(&random) - worldgen_randf(&random));
 
       float radius = abundance * sinf(len * M_PI / veinLength) + 1;
 
-      fillOblateSpheroid(map, vein_x, vein_y, vein_z, radius, type);
+      veins->push_back({(int16_t)vein_x, (int16_t)vein_y, (int16_t)vein_z,
+                        (int16_t)radius});
     }
   }
 }
 
-void create_ores(LevelMap* map) {
-  create_vein(map, 0.9f, static_cast<uint8_t>(Blocks::COAL_ORE_BLOCK));
-  create_vein(map, 0.7f, static_cast<uint8_t>(Blocks::IRON_ORE_BLOCK));
-  create_vein(map, 0.5f, static_cast<uint8_t>(Blocks::GOLD_ORE_BLOCK));
+// Ores take turns, the first vein through a cell keeps it
+void create_coal(const worldgen_slab* slab) {
+  fill_spheroids(slab, slab->features->coal,
+                 static_cast<uint8_t>(Blocks::COAL_ORE_BLOCK));
 }
 
-void flood_fill_water(LevelMap* map) {
+void create_iron(const worldgen_slab* slab) {
+  fill_spheroids(slab, slab->features->iron,
+                 static_cast<uint8_t>(Blocks::IRON_ORE_BLOCK));
+}
+
+void create_gold(const worldgen_slab* slab) {
+  fill_spheroids(slab, slab->features->gold,
+                 static_cast<uint8_t>(Blocks::GOLD_ORE_BLOCK));
+}
+
+// Is the column x, z in the slab
+static inline bool in_slab(const worldgen_slab* slab, int x, int z) {
+  return x >= slab->minX && x < slab->maxX && z >= slab->minZ &&
+         z < slab->maxZ;
+}
+
+void flood_fill_water(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+
   // Flood-fill water into the map
-  for (int x = 0; x < map->length; x++) {
-    for (int z = 0; z < map->width; z++) {
+  for (int x = slab->minX; x < slab->maxX; x++) {
+    for (int z = slab->minZ; z < slab->maxZ; z++) {
       int y = waterLevel - 1;
 
       for (; y >= 0; y--) {
@@ -325,31 +716,39 @@ void flood_fill_water(LevelMap* map) {
   }
 
   // Add underground water sources
-  int numWaterSources = map->length * map->width / 8000;
+  int numWaterSources =
+      feature_count(STAGE_WATER, map->length * map->width / 8000.0f);
   for (int i = 0; i < numWaterSources; i++) {
+    worldgen_random random = feature_stream(STAGE_WATER, i);
+
     // Choose random x and z coordinates
-    int x = rand() % map->length;
-    int z = rand() % map->width;
+    int x = worldgen_rand(&random) % map->length;
+    int z = worldgen_rand(&random) % map->width;
 
-    int y = waterLevel - (rand() % 24);
+    int y = waterLevel - (worldgen_rand(&random) % 24);
 
-    if (GetBlockFromMap(map, x, y, z) ==
-        static_cast<uint8_t>(Blocks::AIR_BLOCK)) {
+    if (in_slab(slab, x, z) && GetBlockFromMap(map, x, y, z) ==
+                                static_cast<uint8_t>(Blocks::AIR_BLOCK)) {
       SetBlockInMap(map, x, y, z, static_cast<uint8_t>(Blocks::WATER_BLOCK));
     }
   }
 }
 
-void flood_fill_lava(LevelMap* map) {
+void flood_fill_lava(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+
   // Add underground lava sources
-  int numLavaSources = map->length * map->width * map->height / 20000;
+  int numLavaSources = feature_count(
+      STAGE_LAVA, map->length * map->width * map->height / 20000.0f);
   for (int i = 0; i < numLavaSources; i++) {
+    worldgen_random random = feature_stream(STAGE_LAVA, i);
+
     // Choose random x and z coordinates
-    int x = rand() % map->length;
-    int y = rand() % map->height - waterLevel;
-    int z = rand() % map->width;
+    int x = worldgen_rand(&random) % map->length;
+    int y = worldgen_rand(&random) % map->height - waterLevel;
+    int z = worldgen_rand(&random) % map->width;
 
-    if (y <= 0) continue;
+    if (y <= 0 || !in_slab(slab, x, z)) continue;
 
     if (GetBlockFromMap(map, x, y, z) ==
         static_cast<uint8_t>(Blocks::AIR_BLOCK)) {
@@ -359,13 +758,14 @@ void flood_fill_lava(LevelMap* map) {
   }
 }
 
-void create_surface(LevelMap* map, int16_t* heightmap) {
-  for (int x = 0; x < map->length; x++) {
-    for (int z = 0; z < map->width; z++) {
-      bool sandChance = (noise1(x, z) > 8);
-      bool gravelChance = (noise2(x, z) > 12);
+void create_surface(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+  for (int x = slab->minX; x < slab->maxX; x++) {
+    for (int z = slab->minZ; z < slab->maxZ; z++) {
+      bool sandChance = (slab->grids->sand[x + z * map->length] > 8);
+      bool gravelChance = (slab->grids->gravel[x + z * map->length] > 12);
 
-      int y = heightmap[x + z * map->length];
+      int y = slab->heightmap[x + z * map->length];
       if (y >= 63 || y <= 0) continue;
 
       uint8_t blockAbove = GetBlockFromMap(map, x, y + 1, z);
@@ -402,24 +802,42 @@ void create_surface(LevelMap* map, int16_t* heightmap) {
   }
 }
 
-void create_flowers(LevelMap* map, int16_t* heightmap, int off) {
-  int numPatches = map->width * map->length / 3000;
+// Plant patches reach 25 cells from their center, five steps of up to 5
+#define WORLDGEN_PATCH_REACH 25
+
+static inline bool patch_reaches_slab(const worldgen_slab* slab, int x,
+                                      int z) {
+  return x + WORLDGEN_PATCH_REACH >= slab->minX &&
+         x - WORLDGEN_PATCH_REACH < slab->maxX &&
+         z + WORLDGEN_PATCH_REACH >= slab->minZ &&
+         z - WORLDGEN_PATCH_REACH < slab->maxZ;
+}
+
+// Plants are grown by the calling thread only, they read the cells around the
+// ones they write
+void create_flowers(const worldgen_slab* slab, uint32_t stage) {
+  LevelMap* map = slab->map;
+  int off = slab->features->plantsOffset;
+  int numPatches = feature_count(stage, map->width * map->length / 3000.0f);
 
   for (int i = 0; i < numPatches; i++) {
-    // uint8_t flowerType = (rand() % 2 == 0) ? 37 : 38;
-    uint16_t x = rand() % map->length;
-    uint16_t z = rand() % map->width;
+    worldgen_random random = feature_stream(stage, i);
+
+    // uint8_t flowerType = (worldgen_rand(&random) % 2 == 0) ? 37 : 38;
+    uint16_t x = worldgen_rand(&random) % map->length;
+    uint16_t z = worldgen_rand(&random) % map->width;
+    if (!patch_reaches_slab(slab, x, z)) continue;
 
     for (int j = 0; j < 10; j++) {
       uint16_t fx = x;
       uint16_t fz = z;
 
       for (int k = 0; k < 5; k++) {
-        fx += (rand() % 6) - (rand() % 6);
-        fz += (rand() % 6) - (rand() % 6);
+        fx += (worldgen_rand(&random) % 6) - (worldgen_rand(&random) % 6);
+        fz += (worldgen_rand(&random) % 6) - (worldgen_rand(&random) % 6);
 
-        if (BoundCheckMap(map, fx, 0, fz)) {
-          uint16_t fy = heightmap[fx + fz * map->length] + 1 + off;
+        if (in_slab(slab, fx, fz) && BoundCheckMap(map, fx, 0, fz)) {
+          uint16_t fy = slab->heightmap[fx + fz * map->length] + 1 + off;
 
           if (!BoundCheckMap(map, fx, fy, fz)) continue;
 
@@ -439,14 +857,19 @@ void create_flowers(LevelMap* map, int16_t* heightmap, int off) {
   }
 }
 
-void create_shrooms(LevelMap* map, int16_t* heightmap) {
-  int numPatches = map->width * map->length * map->height / 2000;
+void create_shrooms(const worldgen_slab* slab, uint32_t stage) {
+  LevelMap* map = slab->map;
+  int numPatches =
+      feature_count(stage, map->width * map->length * map->height / 2000.0f);
 
   for (int i = 0; i < numPatches; i++) {
-    // uint8_t mushType = (rand() % 2 == 0) ? 39 : 40;
-    uint16_t x = rand() % map->length;
-    uint16_t y = rand() % map->height;
-    uint16_t z = rand() % map->width;
+    worldgen_random random = feature_stream(stage, i);
+
+    // uint8_t mushType = (worldgen_rand(&random) % 2 == 0) ? 39 : 40;
+    uint16_t x = worldgen_rand(&random) % map->length;
+    uint16_t y = worldgen_rand(&random) % map->height;
+    uint16_t z = worldgen_rand(&random) % map->width;
+    if (!patch_reaches_slab(slab, x, z)) continue;
 
     for (int j = 0; j < 20; j++) {
       uint16_t fx = x;
@@ -454,13 +877,13 @@ void create_shrooms(LevelMap* map, int16_t* heightmap) {
       uint16_t fz = z;
 
       for (int k = 0; k < 5; k++) {
-        fx += (rand() % 6) - (rand() % 6);
-        fy += (rand() % 2) - (rand() % 2);
-        fz += (rand() % 6) - (rand() % 6);
+        fx += (worldgen_rand(&random) % 6) - (worldgen_rand(&random) % 6);
+        fy += (worldgen_rand(&random) % 2) - (worldgen_rand(&random) % 2);
+        fz += (worldgen_rand(&random) % 6) - (worldgen_rand(&random) % 6);
 
-        if (BoundCheckMap(map, fx, fy, fz) &&
+        if (in_slab(slab, fx, fz) && BoundCheckMap(map, fx, fy, fz) &&
             BoundCheckMap(map, fx, fy - 1, fz) &&
-            fy < heightmap[fx + fz * map->length] - 1) {
+            fy < slab->heightmap[fx + fz * map->length] - 1) {
           uint8_t blockBelow = GetBlockFromMap(map, fx, fy - 1, fz);
 
           if (GetBlockFromMap(map, fx, fy, fz) ==
@@ -477,7 +900,16 @@ void create_shrooms(LevelMap* map, int16_t* heightmap) {
   }
 }
 
-#include <stdio.h>
+// Trees only grow into air, so a cell holding a tree block was air before
+// any tree. Checking the space against that keeps trees from depending on the
+// trees grown before them
+static inline bool isAirBeforeTrees(LevelMap* map, int x, int y, int z) {
+  const uint8_t blk = GetBlockFromMap(map, x, y, z);
+  return blk == static_cast<uint8_t>(Blocks::AIR_BLOCK) ||
+         blk == static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK) ||
+         blk == static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK);
+}
+
 bool isSpaceForTree(LevelMap* map, int x, int y, int z, int treeHeight) {
   // Check if the block below is grass
   if (!BoundCheckMap(map, x, y - 1, z) ||
@@ -489,8 +921,7 @@ bool isSpaceForTree(LevelMap* map, int x, int y, int z, int treeHeight) {
   // Check if the trunk region is empty
   for (int j = y + 1; j < y + treeHeight; j++) {
     if (!BoundCheckMap(map, x, j, z) ||
-        GetBlockFromMap(map, x, j, z) !=
-            static_cast<uint8_t>(Blocks::AIR_BLOCK)) {
+        !isAirBeforeTrees(map, x, j, z)) {
       return false;
     }
   }
@@ -500,8 +931,7 @@ bool isSpaceForTree(LevelMap* map, int x, int y, int z, int treeHeight) {
     for (int j = y + treeHeight; j < y + treeHeight + 3; j++) {
       for (int k = z - 2; k <= z + 2; k++) {
         if (!BoundCheckMap(map, i, j, k) ||
-            GetBlockFromMap(map, i, j, k) !=
-                static_cast<uint8_t>(Blocks::AIR_BLOCK)) {
+            !isAirBeforeTrees(map, i, j, k)) {
           return false;
         }
       }
@@ -512,373 +942,725 @@ bool isSpaceForTree(LevelMap* map, int x, int y, int z, int treeHeight) {
   return true;
 }
 
-void growTree(LevelMap* map, int x, int y, int z, int treeHeight) {
+// Tree blocks only replace air and leaves, so the logs of a tree win over the
+// leaves of any other and overlapping trees grow the same cells in any order
+static void set_tree_block(const worldgen_slab* slab, int x, int y, int z,
+                           uint8_t blk) {
+  if (!in_slab(slab, x, z) || !BoundCheckMap(slab->map, x, y, z)) return;
+
+  const uint8_t current = GetBlockFromMap(slab->map, x, y, z);
+  if (current == static_cast<uint8_t>(Blocks::AIR_BLOCK) ||
+      current == static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK))
+    SetBlockInMap(slab->map, x, y, z, blk);
+}
+
+void growTree(const worldgen_slab* slab, int x, int y, int z, int treeHeight,
+              worldgen_random* random) {
   int max = y + treeHeight;
   int m = max;
 
   for (; m >= y; m--) {
     if (m == max) {
-      SetBlockInMap(map, x - 1, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 1, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z - 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z + 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x - 1, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 1, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z - 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z + 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
     } else if (m == max - 1) {
-      SetBlockInMap(map, x - 1, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 1, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z - 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z + 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x - 1, m, z - 1,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x - 1, m, z + 1,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x + 1, m, z - 1,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x + 1, m, z + 1,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      SetBlockInMap(map, x, m, z, static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK));
+      set_tree_block(slab, x - 1, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 1, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z - 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z + 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x - 1, m, z - 1,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x - 1, m, z + 1,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x + 1, m, z - 1,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x + 1, m, z + 1,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      set_tree_block(slab, x, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK));
     } else if (m == max - 2 || m == max - 3) {
-      SetBlockInMap(map, x - 1, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 1, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z - 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z + 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      SetBlockInMap(map, x - 1, m, z - 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x - 1, m, z + 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 1, m, z - 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 1, m, z + 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      SetBlockInMap(map, x - 2, m, z - 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x - 2, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x - 2, m, z + 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      SetBlockInMap(map, x + 2, m, z - 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 2, m, z,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 2, m, z + 1,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      SetBlockInMap(map, x - 1, m, z - 2,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z - 2,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 1, m, z - 2,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      SetBlockInMap(map, x - 1, m, z + 2,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x, m, z + 2,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-      SetBlockInMap(map, x + 1, m, z + 2,
-                    static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x - 2, m, z - 2,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x + 2, m, z - 2,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x - 2, m, z + 2,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      if (rand() % 2 == 0)
-        SetBlockInMap(map, x + 2, m, z + 2,
-                      static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
-
-      SetBlockInMap(map, x, m, z, static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK));
+      set_tree_block(slab, x - 1, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 1, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z - 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z + 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      set_tree_block(slab, x - 1, m, z - 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x - 1, m, z + 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 1, m, z - 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 1, m, z + 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      set_tree_block(slab, x - 2, m, z - 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x - 2, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x - 2, m, z + 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      set_tree_block(slab, x + 2, m, z - 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 2, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 2, m, z + 1,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      set_tree_block(slab, x - 1, m, z - 2,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z - 2,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 1, m, z - 2,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      set_tree_block(slab, x - 1, m, z + 2,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x, m, z + 2,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+      set_tree_block(slab, x + 1, m, z + 2,
+                     static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x - 2, m, z - 2,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x + 2, m, z - 2,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x - 2, m, z + 2,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      if (worldgen_rand(random) % 2 == 0)
+        set_tree_block(slab, x + 2, m, z + 2,
+                       static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK));
+
+      set_tree_block(slab, x, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK));
     } else {
-      SetBlockInMap(map, x, m, z, static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK));
+      set_tree_block(slab, x, m, z,
+                     static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK));
     }
   }
 }
 
-void create_trees(LevelMap* map, int16_t* heightmap, int off) {
-  int numPatches = (map->width * map->length) / 4000;
+// Draws the tree attempts of a plants pass. Their trunks are placed before
+// any terrain exists, the space for them is checked by create_trees
+static void stage_trees(LevelMap* map, uint32_t pass,
+                        worldgen_features* features) {
+  const uint32_t stage = STAGE_TREES | (pass << 8);
+  int numPatches = feature_count(stage, (map->width * map->length) / 4000.0f);
+  uint32_t attempts = 0;
 
   for (int i = 0; i < numPatches; i++) {
-    uint16_t x = rand() % map->length;
-    uint16_t z = rand() % map->width;
+    worldgen_random random = feature_stream(stage, i);
+    uint16_t x = worldgen_rand(&random) % map->length;
+    uint16_t z = worldgen_rand(&random) % map->width;
 
     for (int j = 0; j < 10; j++) {
       uint16_t fx = x;
       uint16_t fz = z;
 
       for (int k = 0; k < 20; k++) {
-        fx += (rand() % 6) - (rand() % 6);
-        fz += (rand() % 6) - (rand() % 6);
+        fx += (worldgen_rand(&random) % 6) - (worldgen_rand(&random) % 6);
+        fz += (worldgen_rand(&random) % 6) - (worldgen_rand(&random) % 6);
 
         if (BoundCheckMap(map, fx, 1, fz)) {
-          uint16_t fy = heightmap[fx + fz * map->length] + 1 + off;
-          uint16_t th = rand() % 3 + 4;
-
-          if (isSpaceForTree(map, fx, fy, fz, th)) {
-            growTree(map, fx, fy, fz, th);
-          }
+          uint8_t th = worldgen_rand(&random) % 3 + 4;
+          features->trees.push_back({fx, fz, th, (uint8_t)pass, attempts++});
         }
       }
     }
   }
 }
 
-void create_plants(LevelMap* map, int16_t* heightmap, int off) {
-  TYRA_LOG("Creating flowers...");
-  create_flowers(map, heightmap, off);
-  TYRA_LOG("Creating shrooms...");
-  create_shrooms(map, heightmap);
-  TYRA_LOG("Creating trees...");
-  create_trees(map, heightmap, off);
-}
-
-/**
- * Generate a map
- * https://github.com/UnknownShadow200/ClassiCube/wiki/Minecraft-Classic-map-generation-algorithm
- * @param map
- */
-void CrossCraft_WorldGenerator_Generate_Original(LevelMap* map) {
-  int16_t* heightMap = new int16_t[map->length * map->width];
-
-  // Generate a heightmap
-  TYRA_LOG("Raising...");
-  create_heightmap(heightMap, map->length, map->width);
-
-  // Smooth heightmap
-  TYRA_LOG("Eroding...");
-  smooth_heightmap(heightMap, map->length, map->width);
-
-  // Create Strata
-  TYRA_LOG("Soiling...");
-  create_strata(map, heightMap);
-
-  // Create Caves
-  TYRA_LOG("Carving...");
-  create_caves(map);
-  create_ores(map);
-
-  // Watering
-  TYRA_LOG("Watering...");
-  flood_fill_water(map);
-
-  // Melting
-  TYRA_LOG("Melting...");
-  flood_fill_lava(map);
-
-  // Growing Surface Layer
-  TYRA_LOG("Growing...");
-  create_surface(map, heightMap);
-
-  // Planting Flora
-  TYRA_LOG("Planting...");
-  create_plants(map, heightMap, 1);
-
-  delete[] heightMap;
+// Grows the slab cells of the staged trees. A tree checks and grows cells up
+// to 2 columns from its trunk, the terrain of those must be generated
+void create_trees(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+  for (const worldgen_tree& tree : slab->features->trees) {
+    if (tree.x + 2 < slab->minX || tree.x - 2 >= slab->maxX ||
+        tree.z + 2 < slab->minZ || tree.z - 2 >= slab->maxZ)
+      continue;
+
+    uint16_t fy = slab->heightmap[tree.x + tree.z * map->length] + 1 +
+                  slab->features->plantsOffset;
+
+    if (isSpaceForTree(map, tree.x, fy, tree.z, tree.height)) {
+      worldgen_random random =
+          feature_stream(STAGE_LEAVES | (tree.pass << 8), tree.index);
+      growTree(slab, tree.x, fy, tree.z, tree.height, &random);
+    }
+  }
 }
 
-void CrossCraft_WorldGenerator_Generate_Island(LevelMap* map) {
-  int16_t* heightMap = new int16_t[map->length * map->width];
-
-  // Generate a heightmap
-  TYRA_LOG("Raising...");
-  create_heightmap(heightMap, map->length, map->width);
-
-  // Smooth heightmap
-  TYRA_LOG("Eroding...");
-  smooth_heightmap(heightMap, map->length, map->width);
-
-  // Smooth to make an island
-  smooth_distance(heightMap, map->length, map->width);
-
-  // Create Strata
-  TYRA_LOG("Soiling...");
-  create_strata(map, heightMap);
-
-  // Create Caves
-  TYRA_LOG("Carving...");
-  create_caves(map);
-  create_ores(map);
+// Stone where the noise3d density is high, one batched row of x per y, z
+void create_floating_stone(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+  const float freq = 0.05f;
 
-  // Watering
-  TYRA_LOG("Watering...");
-  flood_fill_water(map);
-
-  // Melting
-  TYRA_LOG("Melting...");
-  flood_fill_lava(map);
-
-  // Growing Surface Layer
-  TYRA_LOG("Growing...");
-  create_surface(map, heightMap);
-
-  // Planting Flora
-  TYRA_LOG("Planting...");
-  create_plants(map, heightMap, 1);
-
-  delete[] heightMap;
-}
-
-void CrossCraft_WorldGenerator_Generate_Floating(LevelMap* map) {
-  float* densityMap = new float[map->length * map->width * map->height];
-  int16_t* heightMap = new int16_t[map->length * map->width];
-  int16_t* heightMap2 = new int16_t[map->length * map->width];
+  float rowX[WORLDGEN_ROW_BATCH];
+  float rowY[WORLDGEN_ROW_BATCH];
+  float rowZ[WORLDGEN_ROW_BATCH];
+  float noise[WORLDGEN_ROW_BATCH];
 
   for (int y = 0; y < map->height; y++) {
-    for (int z = 0; z < map->width; z++) {
-      for (int x = 0; x < map->length; x++) {
-        uint32_t index = (y * map->length * map->width) + (z * map->width) + x;
+    for (int z = slab->minZ; z < slab->maxZ; z++) {
+      for (int start = slab->minX; start < slab->maxX;
+           start += WORLDGEN_ROW_BATCH) {
+        const int batch = slab->maxX - start < WORLDGEN_ROW_BATCH
+                              ? slab->maxX - start
+                              : WORLDGEN_ROW_BATCH;
+        for (int j = 0; j < batch; j++) {
+          rowX[j] = (float)(start + j + worldgen_origin_x) * freq;
+          rowY[j] = (float)y * freq;
+          rowZ[j] = (float)(z + worldgen_origin_z) * freq;
+        }
 
-        densityMap[index] = (noise3d(x, y, z) + 1.0f) / 2.0f;
+        fnlGetNoise3DRow(&state, rowX, rowY, rowZ, batch, noise);
 
-        if (densityMap[index] > 0.67f) {
-          SetBlockInMap(map, x, y, z,
-                        static_cast<uint8_t>(Blocks::STONE_BLOCK));
+        for (int j = 0; j < batch; j++) {
+          float density = (noise[j] + 1.0f) / 2.0f;
+
+          if (density > 0.67f) {
+            SetBlockInMap(map, start + j, y, z,
+                          static_cast<uint8_t>(Blocks::STONE_BLOCK));
+          }
         }
       }
     }
   }
+}
 
-  for (int z = 0; z < map->width; z++) {
-    for (int x = 0; x < map->length; x++) {
+// Top and bottom of the floating islands, columns without any stay at 0
+void find_floating_heights(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+  for (int z = slab->minZ; z < slab->maxZ; z++) {
+    for (int x = slab->minX; x < slab->maxX; x++) {
       for (int y = map->height - 1; y >= 0; y--) {
         uint8_t blk = GetBlockFromMap(map, x, y, z);
 
         if (blk != static_cast<uint8_t>(Blocks::AIR_BLOCK)) {
-          heightMap[x + z * map->length] = y;
+          slab->heightmap[x + z * map->length] = y;
           break;
         }
       }
     }
   }
 
-  for (int z = 0; z < map->width; z++) {
-    for (int x = 0; x < map->length; x++) {
+  for (int z = slab->minZ; z < slab->maxZ; z++) {
+    for (int x = slab->minX; x < slab->maxX; x++) {
       for (int y = 0; y < map->height; y++) {
         uint8_t blk = GetBlockFromMap(map, x, y, z);
 
         if (blk != static_cast<uint8_t>(Blocks::AIR_BLOCK)) {
-          heightMap2[x + z * map->length] = y;
+          slab->heightmap2[x + z * map->length] = y;
           break;
         }
       }
     }
   }
-  create_strata2(map, heightMap, heightMap2);
-  create_surface(map, heightMap);
+}
 
-  create_ores(map);
+void create_flat_strata(const worldgen_slab* slab) {
+  LevelMap* map = slab->map;
+  for (uint16_t x = slab->minX; x < slab->maxX; x++) {
+    for (uint16_t z = slab->minZ; z < slab->maxZ; z++) {
+      for (int y = 0; y < 64; y++) {
+        int block_type = static_cast<uint8_t>(Blocks::AIR_BLOCK);
 
-  create_plants(map, heightMap, 1);
+        if (y == 0) {
+          block_type = static_cast<uint8_t>(Blocks::BEDROCK_BLOCK);
+        } else if (y == 1) {
+          block_type = bedrock_or_stone(x, z);
+        } else if (y <= 28) {
+          block_type = static_cast<uint8_t>(Blocks::STONE_BLOCK);
+        } else if (y <= 31) {
+          block_type = static_cast<uint8_t>(Blocks::DIRTY_BLOCK);
+        } else if (y <= 32) {
+          block_type = static_cast<uint8_t>(Blocks::GRASS_BLOCK);
+        }
 
-  SetBlockInMap(map, map->spawnX, map->spawnY, map->spawnZ,
-                static_cast<uint8_t>(Blocks::BEDROCK_BLOCK));
+        SetBlockInMap(map, x, y, z, block_type);
+      }
 
-  delete[] heightMap;
-  delete[] heightMap2;
-  delete[] densityMap;
+      slab->heightmap[x + z * map->length] = 32;
+    }
+  }
 }
 
-void CrossCraft_WorldGenerator_Generate_Woods(LevelMap* map) {
-  int16_t* heightMap = new int16_t[map->length * map->width];
+// A named step of the terrain, its passes run in order over the columns. The
+// terrain of a column is its phases one after another, whatever columns each
+// of them run over, so they can be spread over frames
+#define WORLDGEN_PHASE_PASSES 4
+
+typedef struct {
+  const char* name;
+  worldgen_pass passes[WORLDGEN_PHASE_PASSES];
+} worldgen_phase;
+
+// https://github.com/UnknownShadow200/ClassiCube/wiki/Minecraft-Classic-map-generation-algorithm
+static const worldgen_phase original_phases[] = {
+    {"Sampling", {create_noise_grids}},
+    {"Raising", {create_heightmap}},
+    {"Eroding", {smooth_heightmap}},
+    {"Soiling", {create_strata}},
+    {"Carving", {create_caves, create_coal, create_iron, create_gold}},
+    {"Watering", {flood_fill_water}},
+    {"Melting", {flood_fill_lava}},
+    {"Growing", {create_surface}},
+    {NULL, {}}};
+
+// The original phases, smoothed to make an island
+static const worldgen_phase island_phases[] = {
+    {"Sampling", {create_noise_grids}},
+    {"Raising", {create_heightmap}},
+    {"Eroding", {smooth_heightmap, smooth_distance}},
+    {"Soiling", {create_strata}},
+    {"Carving", {create_caves, create_coal, create_iron, create_gold}},
+    {"Watering", {flood_fill_water}},
+    {"Melting", {flood_fill_lava}},
+    {"Growing", {create_surface}},
+    {NULL, {}}};
+
+static const worldgen_phase floating_phases[] = {
+    {"Sampling", {create_noise_grids}},
+    {"Raising", {create_floating_stone}},
+    {"Soiling", {find_floating_heights, create_strata2}},
+    {"Growing", {create_surface}},
+    {"Carving", {create_coal, create_iron, create_gold}},
+    {NULL, {}}};
+
+static const worldgen_phase flat_phases[] = {{"Soiling", {create_flat_strata}},
+                                             {NULL, {}}};
+
+static const char* planting_phase = "Planting";
+
+static const worldgen_phase* get_phases(WorldType worldType) {
+  switch (worldType) {
+    case WORLD_TYPE_FLAT:
+      return flat_phases;
+    case WORLD_TYPE_FLOATING:
+      return floating_phases;
+    case WORLD_TYPE_ISLAND:
+      return island_phases;
+    default:
+      return original_phases;
+  }
+}
 
-  // Generate a heightmap
-  TYRA_LOG("Raising...");
-  create_heightmap(heightMap, map->length, map->width);
+struct WorldgenMap {
+  LevelMap* map;
+  WorldType worldType;
+  int originX;
+  int originZ;
+  bool windowed;
+  // Spawn when the generation started, floating worlds put bedrock under it
+  uint16_t spawnX, spawnY, spawnZ;
+
+  int16_t* heightMap;
+  int16_t* heightMap2;
+  worldgen_grids grids;
+  worldgen_features features;
+
+  // Steps done per column of LEVEL_MAP_BRICK_SIZE cells, x + z * columnsX. A
+  // column has its terrain after the terrain phases, and is complete after
+  // the planting step that follows them. A column gets its plants once the
+  // columns around it have their terrain
+  const worldgen_phase* phases;
+  uint8_t terrainSteps;
+  uint8_t* columns;
+  uint16_t columnsX;
+  uint16_t columnsZ;
+  uint32_t pendingColumns;
+
+  // Edited bricks of the map, put back when the generator is released
+  uint8_t* edits;
+};
+
+// Points the streams at the generator window, feature streams are keyed by
+// its origin. Generated cells are no edits, the map stops tracking them
+// until the generator is released
+static void use_generator(WorldgenMap* generator) {
+  worldgen_origin_x = generator->originX;
+  worldgen_origin_z = generator->originZ;
+  worldgen_windowed = generator->windowed;
+  generator->edits = generator->map->edits;
+  generator->map->edits = NULL;
+}
 
-  // Smooth heightmap
-  TYRA_LOG("Eroding...");
-  smooth_heightmap(heightMap, map->length, map->width);
+static void release_generator(WorldgenMap* generator) {
+  worldgen_origin_x = 0;
+  worldgen_origin_z = 0;
+  worldgen_windowed = false;
+  generator->map->edits = generator->edits;
+}
 
-  // Create Strata
-  TYRA_LOG("Soiling...");
-  create_strata(map, heightMap);
+static WorldgenMap* begin_generator(LevelMap* map, WorldType worldType,
+                                    int originX, int originZ, bool windowed) {
+  WorldgenMap* generator = new WorldgenMap();
+  generator->map = map;
+  generator->worldType = worldType;
+  generator->originX = originX;
+  generator->originZ = originZ;
+  generator->windowed = windowed;
+  generator->spawnX = map->spawnX;
+  generator->spawnY = map->spawnY;
+  generator->spawnZ = map->spawnZ;
+
+  const uint32_t cells = map->length * map->width;
+  generator->heightMap = new int16_t[cells]();
+  if (worldType == WORLD_TYPE_FLOATING) {
+    generator->heightMap2 = new int16_t[cells]();
+    create_grids(&generator->grids, map, false);
+  } else if (worldType != WORLD_TYPE_FLAT) {
+    create_grids(&generator->grids, map, true);
+  }
 
-  // Create Caves
-  TYRA_LOG("Carving...");
-  create_caves(map);
-  create_ores(map);
+  generator->phases = get_phases(worldType);
+  generator->terrainSteps = 0;
+  while (generator->phases[generator->terrainSteps].name)
+    generator->terrainSteps++;
+
+  generator->columnsX = map->length >> LEVEL_MAP_BRICK_SHIFT;
+  generator->columnsZ = map->width >> LEVEL_MAP_BRICK_SHIFT;
+  generator->pendingColumns = generator->columnsX * generator->columnsZ;
+  generator->columns = new uint8_t[generator->pendingColumns]();
+
+  use_generator(generator);
+  worldgen_features* features = &generator->features;
+  features->plantsOffset = worldType == WORLD_TYPE_FLAT ? 0 : 1;
+  if (worldType != WORLD_TYPE_FLAT && worldType != WORLD_TYPE_FLOATING)
+    stage_caves(map, features);
+  if (worldType != WORLD_TYPE_FLAT) {
+    stage_veins(map, STAGE_COAL, 0.9f, &features->coal);
+    stage_veins(map, STAGE_IRON, 0.7f, &features->iron);
+    stage_veins(map, STAGE_GOLD, 0.5f, &features->gold);
+  }
+  stage_trees(map, 0, features);
+  if (worldType == WORLD_TYPE_WOODS) stage_trees(map, 1, features);
+  release_generator(generator);
 
-  // Watering
-  TYRA_LOG("Watering...");
-  flood_fill_water(map);
+  return generator;
+}
 
-  // Melting
-  TYRA_LOG("Melting...");
-  flood_fill_lava(map);
+// Planting Flora
+static void create_plants(const WorldgenMap* generator,
+                          const worldgen_slab* whole) {
+  const uint32_t passes = generator->worldType == WORLD_TYPE_WOODS ? 2 : 1;
+  for (uint32_t pass = 0; pass < passes; pass++) {
+    create_flowers(whole, STAGE_FLOWERS | (pass << 8));
+    create_shrooms(whole, STAGE_SHROOMS | (pass << 8));
+  }
+  create_trees(whole);
+
+  // Regions of paged worlds without the spawn
+  LevelMap* map = generator->map;
+  if (generator->worldType == WORLD_TYPE_FLOATING &&
+      BoundCheckMap(map, generator->spawnX, generator->spawnY,
+                    generator->spawnZ) &&
+      in_slab(whole, generator->spawnX, generator->spawnZ))
+    SetBlockInMap(map, generator->spawnX, generator->spawnY,
+                  generator->spawnZ,
+                  static_cast<uint8_t>(Blocks::BEDROCK_BLOCK));
+}
 
-  // Growing Surface Layer
-  TYRA_LOG("Growing...");
-  create_surface(map, heightMap);
+// Runs the steps [from, to) over the columns [minX, maxX) x [minZ, maxZ), all
+// of them having done the steps before from
+static void run_steps(WorldgenMap* generator, uint16_t minX, uint16_t minZ,
+                      uint16_t maxX, uint16_t maxZ, uint8_t from, uint8_t to) {
+  const worldgen_slab slab = {generator->map,
+                              generator->heightMap,
+                              generator->heightMap2,
+                              &generator->grids,
+                              &generator->features,
+                              (uint16_t)(minX << LEVEL_MAP_BRICK_SHIFT),
+                              (uint16_t)(maxX << LEVEL_MAP_BRICK_SHIFT),
+                              (uint16_t)(minZ << LEVEL_MAP_BRICK_SHIFT),
+                              (uint16_t)(maxZ << LEVEL_MAP_BRICK_SHIFT)};
+
+  for (uint8_t step = from; step < to; step++) {
+    if (step == generator->terrainSteps) {
+      create_plants(generator, &slab);
+      generator->pendingColumns -= (maxX - minX) * (maxZ - minZ);
+      continue;
+    }
 
-  // Planting Flora
-  TYRA_LOG("Planting...");
-  create_plants(map, heightMap, 1);
-  srand(state.seed + 1);
-  create_plants(map, heightMap, 1);
+    const worldgen_phase* phase = &generator->phases[step];
+    for (uint8_t i = 0; i < WORLDGEN_PHASE_PASSES && phase->passes[i]; i++)
+      run_pass(&slab, phase->passes[i]);
+  }
 
-  delete[] heightMap;
+  for (uint16_t z = minZ; z < maxZ; z++)
+    for (uint16_t x = minX; x < maxX; x++)
+      generator->columns[x + z * generator->columnsX] = to;
 }
 
-void CrossCraft_WorldGenerator_Generate_Flat(LevelMap* map) {
-  for (uint16_t x = 0; x < map->length; x++) {
-    for (uint16_t z = 0; z < map->width; z++) {
-      for (int y = 0; y < 64; y++) {
-        int block_type = static_cast<uint8_t>(Blocks::AIR_BLOCK);
+// Moves the columns [minX, maxX) x [minZ, maxZ) below the step to it. When
+// all of them are at the same step, they are generated as one rectangle,
+// split between the workers, otherwise column by column
+static void generate_stage(WorldgenMap* generator, uint16_t minX,
+                           uint16_t minZ, uint16_t maxX, uint16_t maxZ,
+                           uint8_t step) {
+  const uint8_t first = generator->columns[minX + minZ * generator->columnsX];
+  bool whole = first < step;
+  bool any = false;
+  for (uint16_t z = minZ; z < maxZ; z++)
+    for (uint16_t x = minX; x < maxX; x++) {
+      const uint8_t done = generator->columns[x + z * generator->columnsX];
+      whole = whole && done == first;
+      any = any || done < step;
+    }
+  if (!any) return;
 
-        if (y == 0) {
-          block_type = static_cast<uint8_t>(Blocks::BEDROCK_BLOCK);
-        } else if (y == 1) {
-          block_type = rand() % 2 == 0
-                           ? static_cast<uint8_t>(Blocks::BEDROCK_BLOCK)
-                           : static_cast<uint8_t>(Blocks::STONE_BLOCK);
-        } else if (y <= 28) {
-          block_type = static_cast<uint8_t>(Blocks::STONE_BLOCK);
-        } else if (y <= 31) {
-          block_type = static_cast<uint8_t>(Blocks::DIRTY_BLOCK);
-        } else if (y <= 32) {
-          block_type = static_cast<uint8_t>(Blocks::GRASS_BLOCK);
-        }
+  if (whole) {
+    run_steps(generator, minX, minZ, maxX, maxZ, first, step);
+    return;
+  }
 
-        SetBlockInMap(map, x, y, z, block_type);
-      }
+  for (uint16_t z = minZ; z < maxZ; z++)
+    for (uint16_t x = minX; x < maxX; x++) {
+      const uint8_t done = generator->columns[x + z * generator->columnsX];
+      if (done < step) run_steps(generator, x, z, x + 1, z + 1, done, step);
     }
+}
+
+WorldgenMap* CrossCraft_WorldGenerator_Begin(LevelMap* map,
+                                             WorldType worldType) {
+  return begin_generator(map, worldType, 0, 0, false);
+}
+
+// Columns whose terrain the columns [minX, maxX) x [minZ, maxZ) need, trees
+// reach into the columns around theirs
+static void get_ring(const WorldgenMap* generator, uint16_t* minX,
+                     uint16_t* minZ, uint16_t* maxX, uint16_t* maxZ) {
+  if (*minX > 0) (*minX)--;
+  if (*minZ > 0) (*minZ)--;
+  if (*maxX < generator->columnsX) (*maxX)++;
+  if (*maxZ < generator->columnsZ) (*maxZ)++;
+}
+
+void CrossCraft_WorldGenerator_Generate_Columns(WorldgenMap* generator,
+                                                uint16_t minX, uint16_t minZ,
+                                                uint16_t maxX, uint16_t maxZ) {
+  if (maxX > generator->columnsX) maxX = generator->columnsX;
+  if (maxZ > generator->columnsZ) maxZ = generator->columnsZ;
+  if (minX >= maxX || minZ >= maxZ) return;
+
+  uint16_t ringMinX = minX, ringMinZ = minZ, ringMaxX = maxX, ringMaxZ = maxZ;
+  get_ring(generator, &ringMinX, &ringMinZ, &ringMaxX, &ringMaxZ);
+
+  use_generator(generator);
+  generate_stage(generator, ringMinX, ringMinZ, ringMaxX, ringMaxZ,
+                 generator->terrainSteps);
+  generate_stage(generator, minX, minZ, maxX, maxZ,
+                 generator->terrainSteps + 1);
+  release_generator(generator);
+}
+
+void CrossCraft_WorldGenerator_Load_Edited_Brick(LevelMap* map, uint32_t brick,
+                                                 void* generator) {
+  // Bricks go x, then z, then y, see WriteMapEdits
+  const uint16_t bricksX = map->width >> LEVEL_MAP_BRICK_SHIFT;
+  const uint16_t bricksZ = map->length >> LEVEL_MAP_BRICK_SHIFT;
+  const uint16_t x = brick % bricksX;
+  const uint16_t z = (brick / bricksX) % bricksZ;
+  CrossCraft_WorldGenerator_Generate_Columns(
+      (WorldgenMap*)generator, x > 0 ? x - 1 : 0, z > 0 ? z - 1 : 0, x + 2,
+      z + 2);
+}
+
+bool CrossCraft_WorldGenerator_Is_Column_Generated(
+    const WorldgenMap* generator, uint16_t x, uint16_t z) {
+  return generator->columns[x + z * generator->columnsX] >
+         generator->terrainSteps;
+}
+
+uint32_t CrossCraft_WorldGenerator_Get_Pending_Columns(
+    const WorldgenMap* generator) {
+  return generator->pendingColumns;
+}
+
+struct WorldgenJob {
+  WorldgenMap* generator;
+  // Columns to complete, and the ring of them to give a terrain first
+  uint16_t minX, minZ, maxX, maxZ;
+  uint16_t ringMinX, ringMinZ, ringMaxX, ringMaxZ;
+
+  // Step running, one unit is the step over one column of its rectangle
+  uint8_t step;
+  uint32_t column;
+  uint32_t unitsDone;
+  uint32_t units;
+};
+
+WorldgenJob* CrossCraft_WorldGenerator_Begin_Job(WorldgenMap* generator,
+                                                 uint16_t minX, uint16_t minZ,
+                                                 uint16_t maxX, uint16_t maxZ) {
+  if (maxX > generator->columnsX) maxX = generator->columnsX;
+  if (maxZ > generator->columnsZ) maxZ = generator->columnsZ;
+  if (minX > maxX) minX = maxX;
+  if (minZ > maxZ) minZ = maxZ;
+
+  WorldgenJob* job = new WorldgenJob();
+  job->generator = generator;
+  job->minX = job->ringMinX = minX;
+  job->minZ = job->ringMinZ = minZ;
+  job->maxX = job->ringMaxX = maxX;
+  job->maxZ = job->ringMaxZ = maxZ;
+  if (minX < maxX && minZ < maxZ)
+    get_ring(generator, &job->ringMinX, &job->ringMinZ, &job->ringMaxX,
+             &job->ringMaxZ);
+
+  const uint32_t ring =
+      (job->ringMaxX - job->ringMinX) * (job->ringMaxZ - job->ringMinZ);
+  const uint32_t columns = (maxX - minX) * (maxZ - minZ);
+  job->units = columns ? ring * generator->terrainSteps + columns : 0;
+  if (!columns) job->step = generator->terrainSteps + 1;
+  return job;
+}
+
+static bool is_job_done(const WorldgenJob* job) {
+  return job->step > job->generator->terrainSteps;
+}
+
+// Runs the job step over its next column, unless the column went past the
+// step since, generated by CrossCraft_WorldGenerator_Generate_Columns
+static void run_job_unit(WorldgenJob* job) {
+  WorldgenMap* generator = job->generator;
+  const bool planting = job->step == generator->terrainSteps;
+  const uint16_t minX = planting ? job->minX : job->ringMinX;
+  const uint16_t minZ = planting ? job->minZ : job->ringMinZ;
+  const uint16_t width = (planting ? job->maxX : job->ringMaxX) - minX;
+  const uint16_t length = (planting ? job->maxZ : job->ringMaxZ) - minZ;
+
+  const uint16_t x = minX + job->column % width;
+  const uint16_t z = minZ + job->column / width;
+  if (generator->columns[x + z * generator->columnsX] == job->step)
+    run_steps(generator, x, z, x + 1, z + 1, job->step, job->step + 1);
+
+  job->unitsDone++;
+  if (++job->column < (uint32_t)width * length) return;
+
+  job->column = 0;
+  job->step++;
+  if (!is_job_done(job))
+    TYRA_LOG(CrossCraft_WorldGenerator_Get_Job_Progress(job).phase, "...");
+}
+
+bool CrossCraft_WorldGenerator_Run_Job(WorldgenJob* job, float budgetMs) {
+  const clock_t deadline =
+      clock() + (clock_t)(budgetMs * CLOCKS_PER_SEC / 1000.0f);
+
+  WorldgenMap* generator = job->generator;
+  use_generator(generator);
+  while (!is_job_done(job)) {
+    run_job_unit(job);
+    if (clock() >= deadline) break;
   }
+  release_generator(generator);
 
-  int16_t* heightMap = new int16_t[map->length * map->width];
+  return is_job_done(job);
+}
+
+WorldgenProgress CrossCraft_WorldGenerator_Get_Job_Progress(
+    const WorldgenJob* job) {
+  const WorldgenMap* generator = job->generator;
+  WorldgenProgress progress;
 
-  for (int i = 0; i < map->length * map->width; i++) {
-    heightMap[i] = 32;
+  if (is_job_done(job)) {
+    progress.phase = planting_phase;
+    progress.phaseProgress = 1.0f;
+    progress.progress = 1.0f;
+    return progress;
   }
-  create_plants(map, heightMap, 0);
-  delete[] heightMap;
-}
\ No newline at end of file
+
+  const bool planting = job->step == generator->terrainSteps;
+  const uint32_t columns =
+      planting ? (job->maxX - job->minX) * (job->maxZ - job->minZ)
+               : (job->ringMaxX - job->ringMinX) *
+                     (job->ringMaxZ - job->ringMinZ);
+  progress.phase =
+      planting ? planting_phase : generator->phases[job->step].name;
+  progress.phaseProgress = (float)job->column / columns;
+  progress.progress = (float)job->unitsDone / job->units;
+  return progress;
+}
+
+void CrossCraft_WorldGenerator_End_Job(WorldgenJob* job) { delete job; }
+
+void CrossCraft_WorldGenerator_End(WorldgenMap* generator) {
+  free_grids(&generator->grids);
+  delete[] generator->heightMap;
+  delete[] generator->heightMap2;
+  delete[] generator->columns;
+  delete generator;
+}
+
+// Generates every column of the map at once
+static void generate_map(LevelMap* map, WorldType worldType, int originX,
+                         int originZ, bool windowed) {
+  WorldgenMap* generator =
+      begin_generator(map, worldType, originX, originZ, windowed);
+  CrossCraft_WorldGenerator_Generate_Columns(
+      generator, 0, 0, generator->columnsX, generator->columnsZ);
+  CrossCraft_WorldGenerator_End(generator);
+}
+
+void CrossCraft_WorldGenerator_Generate_Original(LevelMap* map) {
+  generate_map(map, WORLD_TYPE_ORIGINAL, 0, 0, false);
+}
+
+void CrossCraft_WorldGenerator_Generate_Island(LevelMap* map) {
+  generate_map(map, WORLD_TYPE_ISLAND, 0, 0, false);
+}
+
+void CrossCraft_WorldGenerator_Generate_Floating(LevelMap* map) {
+  generate_map(map, WORLD_TYPE_FLOATING, 0, 0, false);
+}
+
+void CrossCraft_WorldGenerator_Generate_Woods(LevelMap* map) {
+  generate_map(map, WORLD_TYPE_WOODS, 0, 0, false);
+}
+
+void CrossCraft_WorldGenerator_Generate_Flat(LevelMap* map) {
+  generate_map(map, WORLD_TYPE_FLAT, 0, 0, false);
+}
+
+void CrossCraft_WorldGenerator_Generate_Region(LevelMap* window,
+                                               WorldType worldType,
+                                               uint16_t regionX,
+                                               uint16_t regionZ) {
+  // Feature streams are keyed by the origin, so a region gets the same
+  // features whatever the order regions are generated
+  generate_map(window,
+               worldType == WORLD_TYPE_ISLAND ? WORLD_TYPE_ORIGINAL : worldType,
+               regionX * window->length, regionZ * window->width, true);
+}
@@ -23,6 +23,12 @@ const float DayNightCycleManager::getAmbientLightIntesity() {
   return baseAmbientLightIntensity + intensity;
 }
 
+const u8 DayNightCycleManager::getSkyLightLevel() {
+  float level = getLightScaleFromAngle();
+  level *= isDay() ? daySkyLightLevel : -nightSkyLightLevel;
+  return horizonSkyLightLevel + level + 0.5F;
+}
+
 void DayNightCycleManager::updateCurrentAngle() {
   currentAngleInDegrees = (g_ticksCounter / DAY_DURATION_IN_TICKS) * 360;
 }
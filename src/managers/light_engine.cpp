@@ -0,0 +1,408 @@
+#include "managers/light_engine.hpp"
+#include "constants.hpp"
+#include "tyra"
+#include <string.h>
+
+// Free slot of the dirty chunks set, chunk keys never have every bit set
+#define LIGHT_ENGINE_NO_CHUNK 0xFFFFFFFF
+
+// Light taken from the light crossing the block, 15 when it stops it
+static u8 getLightOpacity(const u8& blockType) {
+  if (blockType <= (u8)Blocks::AIR_BLOCK ||
+      blockType == (u8)Blocks::GLASS_BLOCK)
+    return 0;
+  if (blockType == (u8)Blocks::WATER_BLOCK ||
+      blockType == (u8)Blocks::OAK_LEAVES_BLOCK ||
+      blockType == (u8)Blocks::BIRCH_LEAVES_BLOCK)
+    return 2;
+  return 15;
+}
+
+// Horizontal neighbors first, the sunlight seeds only need those
+static const s8 neighborOffsets[6][3] = {{1, 0, 0},  {-1, 0, 0}, {0, 0, 1},
+                                         {0, 0, -1}, {0, 1, 0},  {0, -1, 0}};
+#define NEIGHBOR_BELOW 5
+
+// Sky light goes down without fading, only the blocks it crosses take it
+static inline u8 getLightLoss(const LightChannel& channel, const u8& neighbor) {
+  return channel == LightChannel::Sky && neighbor == NEIGHBOR_BELOW ? 0 : 1;
+}
+
+LightEngine::LightEngine(const u32& capacity) {
+  initQueue(&spreadQueue, capacity);
+  initQueue(&removalQueue, capacity);
+  clearDirtyChunks();
+}
+
+LightEngine::~LightEngine() {
+  delete[] spreadQueue.nodes;
+  delete[] removalQueue.nodes;
+}
+
+void LightEngine::initQueue(LightQueue* queue, const u32& capacity) {
+  // Rounded up to a power of two, so the ring wraps with a mask
+  u32 size = 1;
+  while (size < capacity) size <<= 1;
+
+  queue->nodes = new u32[size];
+  queue->mask = size - 1;
+  queue->head = 0;
+  queue->count = 0;
+}
+
+bool LightEngine::push(LightQueue* queue, const u32& node) {
+  if (isFull(queue)) {
+    droppedNodes++;
+    return false;
+  }
+
+  queue->nodes[(queue->head + queue->count) & queue->mask] = node;
+  queue->count++;
+  return true;
+}
+
+u32 LightEngine::pop(LightQueue* queue) {
+  const u32 node = queue->nodes[queue->head];
+  queue->head = (queue->head + 1) & queue->mask;
+  queue->count--;
+  return node;
+}
+
+void LightEngine::beginPass(const u16& x, const u16& z) {
+  originX = x - 512;
+  originZ = z - 512;
+  droppedNodes = 0;
+}
+
+void LightEngine::endPass(const char* pass) {
+  if (droppedNodes)
+    TYRA_WARN("Light queue full, ", pass, " dropped ", droppedNodes, " nodes");
+}
+
+u32 LightEngine::packNode(const u16& x, const u16& y, const u16& z,
+                          const u8& level) {
+  return ((u16)(x - originX) & 0x3FF) | (((u16)(z - originZ) & 0x3FF) << 10) |
+         ((y & 0xFF) << 20) | ((u32)level << 28);
+}
+
+void LightEngine::unpackNode(const u32& node, u16* x, u16* y, u16* z,
+                             u8* level) {
+  *x = originX + (node & 0x3FF);
+  *z = originZ + ((node >> 10) & 0x3FF);
+  *y = (node >> 20) & 0xFF;
+  *level = node >> 28;
+}
+
+u8 LightEngine::getLight(LevelMap* map, const LightChannel& channel,
+                         const u16& x, const u16& y, const u16& z) {
+  return (GetDataFromMap(map, x, y, z) >> (u8)channel) & 0x0F;
+}
+
+void LightEngine::setLight(LevelMap* map, const LightChannel& channel,
+                           const u16& x, const u16& y, const u16& z,
+                           const u8& level) {
+  if (channel == LightChannel::Sky)
+    SetSkyLightInMap(map, x, y, z, level);
+  else
+    SetBlockLightInMap(map, x, y, z, level);
+
+  if (trackDirtyChunks) markDirtyCell(x, y, z);
+}
+
+void LightEngine::markDirtyChunk(const u16& x, const u16& y, const u16& z) {
+  const u32 key =
+      (x & 0x1FFF) | ((u32)(z & 0x1FFF) << 13) | ((u32)(y & 0x3F) << 26);
+
+  // Open addressing, the set is never more than half full
+  u32 slot = ((key * 2654435761U) >> 16) & (LIGHT_ENGINE_DIRTY_SLOTS - 1);
+  while (dirtyChunksSet[slot] != LIGHT_ENGINE_NO_CHUNK) {
+    if (dirtyChunksSet[slot] == key) return;
+    slot = (slot + 1) & (LIGHT_ENGINE_DIRTY_SLOTS - 1);
+  }
+
+  if (dirtyChunksCount == LIGHT_ENGINE_MAX_DIRTY_CHUNKS) {
+    dirtyChunksOverflow = true;
+    return;
+  }
+
+  dirtyChunksSet[slot] = key;
+  dirtyChunks[dirtyChunksCount++] = key;
+}
+
+void LightEngine::markDirtyCell(const u16& x, const u16& y, const u16& z) {
+  const u16 chunkX = x >> LEVEL_MAP_BRICK_SHIFT;
+  const u16 chunkY = y >> LEVEL_MAP_BRICK_SHIFT;
+  const u16 chunkZ = z >> LEVEL_MAP_BRICK_SHIFT;
+  markDirtyChunk(chunkX, chunkY, chunkZ);
+
+  // Faces of the next chunk look into the cells of its border
+  if ((x & LEVEL_MAP_BRICK_MASK) == 0)
+    markDirtyChunk(chunkX - 1, chunkY, chunkZ);
+  else if ((x & LEVEL_MAP_BRICK_MASK) == LEVEL_MAP_BRICK_MASK)
+    markDirtyChunk(chunkX + 1, chunkY, chunkZ);
+
+  if ((y & LEVEL_MAP_BRICK_MASK) == 0 && chunkY > 0)
+    markDirtyChunk(chunkX, chunkY - 1, chunkZ);
+  else if ((y & LEVEL_MAP_BRICK_MASK) == LEVEL_MAP_BRICK_MASK)
+    markDirtyChunk(chunkX, chunkY + 1, chunkZ);
+
+  if ((z & LEVEL_MAP_BRICK_MASK) == 0)
+    markDirtyChunk(chunkX, chunkY, chunkZ - 1);
+  else if ((z & LEVEL_MAP_BRICK_MASK) == LEVEL_MAP_BRICK_MASK)
+    markDirtyChunk(chunkX, chunkY, chunkZ + 1);
+}
+
+void LightEngine::getDirtyChunk(const u16& index, u16* x, u16* y, u16* z) {
+  const u32 key = dirtyChunks[index];
+  *x = key & 0x1FFF;
+  *z = (key >> 13) & 0x1FFF;
+  *y = key >> 26;
+}
+
+void LightEngine::clearDirtyChunks() {
+  memset(dirtyChunksSet, 0xFF, sizeof(dirtyChunksSet));
+  dirtyChunksCount = 0;
+  dirtyChunksOverflow = false;
+}
+
+void LightEngine::spreadTo(LevelMap* map, const LightChannel& channel,
+                           const u16& x, const u16& y, const u16& z,
+                           const u8& level, const u8& loss) {
+  if (!BoundCheckMap(map, x, y, z)) return;
+  if (columnMask && !columnMask[(x >> LEVEL_MAP_BRICK_SHIFT) +
+                                (z >> LEVEL_MAP_BRICK_SHIFT) * columnMaskX])
+    return;
+
+  const u8 opacity = getLightOpacity(GetBlockFromMap(map, x, y, z));
+  if (level <= opacity + loss) return;
+
+  const u8 newLevel = level - opacity - loss;
+  if (getLight(map, channel, x, y, z) >= newLevel) return;
+
+  // A dropped node leaves the cell as it was, its light would not go further
+  if (push(&spreadQueue, packNode(x, y, z, newLevel)))
+    setLight(map, channel, x, y, z, newLevel);
+}
+
+void LightEngine::removeFrom(LevelMap* map, const LightChannel& channel,
+                             const u16& x, const u16& y, const u16& z,
+                             const u8& level, const u8& loss) {
+  if (!BoundCheckMap(map, x, y, z)) return;
+
+  // Without loss the removed light reached the neighbor at the same level
+  const u8 neighborLevel = getLight(map, channel, x, y, z);
+  if (neighborLevel != 0 && neighborLevel + loss <= level) {
+    // Lit by the removed light, it is lit again from the spread queue
+    if (push(&removalQueue, packNode(x, y, z, neighborLevel)))
+      setLight(map, channel, x, y, z, 0);
+  } else if (neighborLevel != 0) {
+    // Lit by another source, spread it over the removed light
+    push(&spreadQueue, packNode(x, y, z, neighborLevel));
+  }
+}
+
+void LightEngine::spread(LevelMap* map, const LightChannel& channel) {
+  u16 x, y, z;
+  u8 level;
+
+  while (spreadQueue.count) {
+    unpackNode(pop(&spreadQueue), &x, &y, &z, &level);
+
+    // The cell may have been lit brighter since it was queued
+    level = getLight(map, channel, x, y, z);
+    if (level == 0) continue;
+
+    for (u8 i = 0; i < 6; i++)
+      spreadTo(map, channel, x + neighborOffsets[i][0],
+               y + neighborOffsets[i][1], z + neighborOffsets[i][2], level,
+               getLightLoss(channel, i));
+  }
+}
+
+void LightEngine::unspread(LevelMap* map, const LightChannel& channel) {
+  u16 x, y, z;
+  u8 level;
+
+  while (removalQueue.count) {
+    unpackNode(pop(&removalQueue), &x, &y, &z, &level);
+
+    for (u8 i = 0; i < 6; i++)
+      removeFrom(map, channel, x + neighborOffsets[i][0],
+                 y + neighborOffsets[i][1], z + neighborOffsets[i][2], level,
+                 getLightLoss(channel, i));
+  }
+}
+
+void LightEngine::propagateSunLight(LevelMap* map) {
+  if (map->pager || !map->data) return;
+
+  const u32 count = map->width * map->length * map->height;
+  for (u32 i = 0; i < count; i++) map->data[i] &= 0x0F;
+
+  // Light the columns straight from the sky
+  for (u16 z = 0; z < map->length; z++) {
+    for (u16 x = 0; x < map->width; x++) {
+      s8 level = 15;
+      for (s16 y = map->height - 1; y >= 0; y--) {
+        level -= getLightOpacity(GetBlockFromMap(map, x, y, z));
+        if (level <= 0) break;
+        SetSkyLightInMap(map, x, y, z, level);
+      }
+    }
+  }
+
+  // Only the cells brighter than a horizontal neighbor can spread, going
+  // down is the column light
+  beginPass(512, 512);
+  for (u16 z = 0; z < map->length; z++) {
+    for (u16 x = 0; x < map->width; x++) {
+      for (s16 y = map->height - 1; y >= 0; y--) {
+        const u8 level = GetSkyLightFromMap(map, x, y, z);
+        if (level == 0) break;
+        if (level == 1) continue;
+
+        for (u8 i = 0; i < 4; i++) {
+          const u16 nx = x + neighborOffsets[i][0];
+          const u16 nz = z + neighborOffsets[i][2];
+          if (!BoundCheckMap(map, nx, y, nz) ||
+              GetSkyLightFromMap(map, nx, y, nz) + 1 >= level)
+            continue;
+
+          if (isHalfFull(&spreadQueue)) spread(map, LightChannel::Sky);
+          push(&spreadQueue, packNode(x, y, z, level));
+          break;
+        }
+      }
+    }
+  }
+
+  spread(map, LightChannel::Sky);
+  endPass("sky light");
+}
+
+void LightEngine::propagateSunLight(LevelMap* map, const u16& minX,
+                                    const u16& minZ, const u16& maxX,
+                                    const u16& maxZ) {
+  if (map->pager || !map->data) return;
+
+  // Light the columns straight from the sky
+  for (u16 z = minZ; z < maxZ; z++) {
+    for (u16 x = minX; x < maxX; x++) {
+      s8 level = 15;
+      for (s16 y = map->height - 1; y >= 0; y--) {
+        if (level > 0) level -= getLightOpacity(GetBlockFromMap(map, x, y, z));
+        SetSkyLightInMap(map, x, y, z, level > 0 ? level : 0);
+      }
+    }
+  }
+
+  // Every lit cell of the area spreads, and so do the lit cells around it,
+  // into it
+  beginPass((minX + maxX) / 2, (minZ + maxZ) / 2);
+  trackDirtyChunks = true;
+  for (u16 z = minZ - 1; z != maxZ + 1; z++) {
+    for (u16 x = minX - 1; x != maxX + 1; x++) {
+      if (!BoundCheckMap(map, x, 0, z)) continue;
+
+      for (s16 y = map->height - 1; y >= 0; y--) {
+        const u8 level = GetSkyLightFromMap(map, x, y, z);
+        if (level <= 1) continue;
+
+        if (isHalfFull(&spreadQueue)) spread(map, LightChannel::Sky);
+        push(&spreadQueue, packNode(x, y, z, level));
+      }
+    }
+  }
+
+  spread(map, LightChannel::Sky);
+  trackDirtyChunks = false;
+  endPass("sky light");
+}
+
+void LightEngine::setColumnMask(const u8* mask, const u16& columnsX) {
+  columnMask = mask;
+  columnMaskX = columnsX;
+}
+
+void LightEngine::addBlockLight(LevelMap* map, const u16& x, const u16& y,
+                                const u16& z, const u8& level) {
+  if (!BoundCheckMap(map, x, y, z)) return;
+
+  beginPass(x, z);
+  trackDirtyChunks = true;
+  if (push(&spreadQueue, packNode(x, y, z, level)))
+    setLight(map, LightChannel::Block, x, y, z, level);
+  spread(map, LightChannel::Block);
+  trackDirtyChunks = false;
+  endPass("block light");
+}
+
+void LightEngine::removeBlockLight(LevelMap* map, const u16& x, const u16& y,
+                                   const u16& z) {
+  if (!BoundCheckMap(map, x, y, z)) return;
+
+  beginPass(x, z);
+  trackDirtyChunks = true;
+  removeCellLight(map, LightChannel::Block, x, y, z);
+  unspread(map, LightChannel::Block);
+  spread(map, LightChannel::Block);
+  trackDirtyChunks = false;
+  endPass("block light");
+}
+
+void LightEngine::removeCellLight(LevelMap* map, const LightChannel& channel,
+                                  const u16& x, const u16& y, const u16& z) {
+  const u8 level = getLight(map, channel, x, y, z);
+  if (!level) return;
+
+  if (push(&removalQueue, packNode(x, y, z, level)))
+    setLight(map, channel, x, y, z, 0);
+}
+
+void LightEngine::spreadFromNeighbors(LevelMap* map,
+                                      const LightChannel& channel,
+                                      const u16& x, const u16& y,
+                                      const u16& z) {
+  // The sky above the map lights its top cells
+  if (channel == LightChannel::Sky && y == map->height - 1)
+    spreadTo(map, channel, x, y, z, 15, 0);
+
+  for (u8 i = 0; i < 6; i++) {
+    const u16 nx = x + neighborOffsets[i][0];
+    const u16 ny = y + neighborOffsets[i][1];
+    const u16 nz = z + neighborOffsets[i][2];
+    if (!BoundCheckMap(map, nx, ny, nz)) continue;
+
+    const u8 level = getLight(map, channel, nx, ny, nz);
+    if (level) push(&spreadQueue, packNode(nx, ny, nz, level));
+  }
+}
+
+void LightEngine::updateBlock(LevelMap* map, const u16& x, const u16& y,
+                              const u16& z, const u8& previousBlock) {
+  if (!BoundCheckMap(map, x, y, z)) return;
+
+  beginPass(x, z);
+  trackDirtyChunks = true;
+
+  // The faces of the cell and of its neighbors changed
+  markDirtyCell(x, y, z);
+
+  const u8 previousOpacity = getLightOpacity(previousBlock);
+  const u8 opacity = getLightOpacity(GetBlockFromMap(map, x, y, z));
+  if (opacity != previousOpacity) {
+    const LightChannel channels[2] = {LightChannel::Sky, LightChannel::Block};
+    for (u8 i = 0; i < 2; i++) {
+      // Darken what the cell lit, the sky column below it included, then
+      // light it again from what is left around
+      if (opacity > previousOpacity)
+        removeCellLight(map, channels[i], x, y, z);
+      unspread(map, channels[i]);
+      spreadFromNeighbors(map, channels[i], x, y, z);
+      spread(map, channels[i]);
+    }
+  }
+
+  trackDirtyChunks = false;
+  endPass("block update");
+}
@@ -0,0 +1,110 @@
+#include "managers/profiler_manager.hpp"
+#include "tyra"
+
+/**
+ * @brief Definition of the global profiler
+ *
+ */
+ProfilerManager g_profiler;
+
+typedef struct {
+  const char* name;
+  const char* column;
+} ProfilerStageInfo;
+
+// Names on the debug overlay and columns of the dump, in ProfilerStage order
+static const ProfilerStageInfo stages[PROFILER_STAGES] = {
+    {"Frame", "frame_ms"},
+    {"World update", "world_update_ms"},
+    {"Chunks update", "chunks_update_ms"},
+    {"Target block", "target_block_ms"},
+    {"Player update", "player_update_ms"},
+    {"Chunks load", "chunks_load_ms"},
+    {"Chunks unload", "chunks_unload_ms"},
+    {"Meshing", "meshing_ms"},
+    {"World render", "world_render_ms"},
+};
+
+ProfilerManager::ProfilerManager() {
+  for (u8 i = 0; i < PROFILER_STAGES; i++) {
+    stageMs[i] = 0.0F;
+    stageDepth[i] = 0;
+    for (u8 j = 0; j < PROFILER_WINDOW_FRAMES; j++) history[i][j] = 0.0F;
+  }
+}
+
+ProfilerManager::~ProfilerManager() { stopDump(); }
+
+void ProfilerManager::beginFrame() {
+  for (u8 i = 0; i < PROFILER_STAGES; i++) stageMs[i] = 0.0F;
+  begin(ProfilerStage::Frame);
+}
+
+void ProfilerManager::endFrame() {
+  end(ProfilerStage::Frame);
+  framesCounter++;
+
+  for (u8 i = 0; i < PROFILER_STAGES; i++)
+    history[i][historyIndex] = stageMs[i];
+  historyIndex = (historyIndex + 1) % PROFILER_WINDOW_FRAMES;
+  if (historyCount < PROFILER_WINDOW_FRAMES) historyCount++;
+
+  if (dumpFile) writeDumpLine();
+}
+
+const char* ProfilerManager::getStageName(const ProfilerStage& stage) {
+  return stages[(u8)stage].name;
+}
+
+float ProfilerManager::getAverageMs(const ProfilerStage& stage) {
+  if (!historyCount) return 0.0F;
+
+  float total = 0.0F;
+  for (u8 i = 0; i < historyCount; i++) total += history[(u8)stage][i];
+  return total / historyCount;
+}
+
+float ProfilerManager::getMaxMs(const ProfilerStage& stage) {
+  float max = 0.0F;
+  for (u8 i = 0; i < historyCount; i++)
+    if (history[(u8)stage][i] > max) max = history[(u8)stage][i];
+  return max;
+}
+
+bool ProfilerManager::startDump(const std::string& fullPath) {
+  if (dumpFile) return false;
+
+  dumpFile = fopen(fullPath.c_str(), "w");
+  if (!dumpFile) {
+    TYRA_WARN("Can't create the profiler dump ", fullPath.c_str());
+    return false;
+  }
+
+  fprintf(dumpFile, "frame");
+  for (u8 i = 0; i < PROFILER_STAGES; i++)
+    fprintf(dumpFile, ",%s", stages[i].column);
+  fprintf(dumpFile, "\n");
+
+  dumpFrames = 0;
+  TYRA_LOG("Dumping ", PROFILER_DUMP_FRAMES, " frames to ", fullPath.c_str());
+  return true;
+}
+
+// Goes through the stdio buffer, the file is only flushed when it fills
+void ProfilerManager::writeDumpLine() {
+  fprintf(dumpFile, "%u", (unsigned int)framesCounter);
+  for (u8 i = 0; i < PROFILER_STAGES; i++)
+    fprintf(dumpFile, ",%.3f", stageMs[i]);
+  fprintf(dumpFile, "\n");
+
+  if (++dumpFrames >= PROFILER_DUMP_FRAMES) {
+    stopDump();
+    TYRA_LOG("Profiler dump finished");
+  }
+}
+
+void ProfilerManager::stopDump() {
+  if (!dumpFile) return;
+  fclose(dumpFile);
+  dumpFile = nullptr;
+}
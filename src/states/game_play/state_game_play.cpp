@@ -7,6 +7,7 @@
 #include <debug/debug.hpp>
 #include "loaders/3d/obj_loader/obj_loader.hpp"
 #include "managers/save_manager.hpp"
+#include "managers/profiler_manager.hpp"
 
 using Tyra::Audio;
 using Tyra::FileUtils;
@@ -23,6 +24,8 @@ StateGamePlay::StateGamePlay(Context* context, const GameMode& gameMode)
 }
 
 StateGamePlay::~StateGamePlay() {
+  // The running save still reads the world
+  this->autosaveManager.finish();
   this->context->t_engine->audio.song.stop();
   this->context->t_engine->audio.song.inLoop = false;
   delete this->state;
@@ -48,11 +51,16 @@ void StateGamePlay::init() {
 }
 
 void StateGamePlay::update(const float& deltaTime) {
+  g_profiler.beginFrame();
   this->handleInput();
   this->state->update(deltaTime);
+  this->autosaveManager.update(this, deltaTime);
 }
 
-void StateGamePlay::render() { this->state->render(); }
+void StateGamePlay::render() {
+  this->state->render();
+  g_profiler.endFrame();
+}
 
 void StateGamePlay::setPlayingState(PlayingStateBase* t_playingState) {
   delete this->state;
@@ -108,8 +116,12 @@ void StateGamePlay::quitToTitle() {
 }
 
 void StateGamePlay::saveGame() {
-  std::string saveFileName = FileUtils::fromCwd(
-      "saves/" + this->world->getWorldOptions()->name + ".tcw");
-  SaveManager::SaveGame(this, saveFileName.c_str());
+  const std::string saveFileName = this->getSaveFilePath();
+  this->autosaveManager.start(this, saveFileName, SAVE_FILE_CODEC);
   TYRA_LOG("Saving at: ", saveFileName.c_str());
+}
+
+const std::string StateGamePlay::getSaveFilePath() {
+  return FileUtils::fromCwd("saves/" + this->world->getWorldOptions()->name +
+                            "." + SAVE_FILE_EXTENSION);
 }
\ No newline at end of file
@@ -1,4 +1,8 @@
 #include "states/game_play/states/creative/creative_playing_state.hpp"
+#include "file/file_utils.hpp"
+#include <stdio.h>
+
+using Tyra::FileUtils;
 
 CreativePlayingState::CreativePlayingState(StateGamePlay* t_context)
     : PlayingStateBase(t_context) {}
@@ -31,7 +35,7 @@ void CreativePlayingState::update(const float& deltaTime) {
   stateGamePlay->player->update(
       deltaTime, playerMovementDirection,
       stateGamePlay->context->t_camera->unitCirclePosition.getNormalized(),
-      stateGamePlay->world->chunckManager.getVisibleChunks(), &terrainHeight);
+      stateGamePlay->world->terrain, &terrainHeight);
 
   stateGamePlay->ui->update();
 
@@ -63,6 +67,13 @@ void CreativePlayingState::handleInput(const float& deltaTime) {
 
   if (clicked.Select) debugMode = !debugMode;
   if (debugMode && clicked.Circle) printMemoryInfoToLog();
+  if (debugMode && clicked.Square)
+    stateGamePlay->world->setGreedyMeshing(
+        !stateGamePlay->world->isGreedyMeshing());
+  if (debugMode && clicked.R3)
+    stateGamePlay->world->benchmarkMeshingLayouts();
+  if (debugMode && clicked.L3)
+    g_profiler.startDump(FileUtils::fromCwd(PROFILER_DUMP_FILE));
 
   if (isInventoryOpened()) {
     inventoryInputHandler(deltaTime);
@@ -83,7 +94,7 @@ void CreativePlayingState::gamePlayInputHandler(const float& deltaTime) {
     playerMovementDirection = Vec4((lJoyPad.h - 128.0F) / 128.0F, 0.0F,
                                    (lJoyPad.v - 128.0F) / 128.0F);
     terrainHeight = stateGamePlay->player->getTerrainHeightAtPosition(
-        stateGamePlay->world->chunckManager.getVisibleChunks());
+        stateGamePlay->world->terrain);
 
     if (clicked.L1) stateGamePlay->player->moveSelectorToTheLeft();
     if (clicked.R1) stateGamePlay->player->moveSelectorToTheRight();
@@ -181,6 +192,35 @@ void CreativePlayingState::drawDegubInfo() {
       std::to_string(static_cast<int>(g_ticksCounter)));
   FontManager_printText(ticks,
                         FontOptions(Vec2(5.0f, 45.0f), Color(255), 0.8F));
+
+  // Draw chunk mesher
+  std::string mesher =
+      std::string("Mesher: ")
+          .append(stateGamePlay->world->isGreedyMeshing() ? "greedy"
+                                                          : "per face");
+  FontManager_printText(mesher,
+                        FontOptions(Vec2(5.0f, 60.0f), Color(255), 0.8F));
+
+  drawProfilerInfo();
+}
+
+void CreativePlayingState::drawProfilerInfo() {
+  // Average and max ms of the last PROFILER_WINDOW_FRAMES frames
+  char line[64];
+  for (u8 i = 0; i < PROFILER_STAGES; i++) {
+    const ProfilerStage stage = static_cast<ProfilerStage>(i);
+    snprintf(line, sizeof(line), "%s: %.2f / %.2f ms",
+             g_profiler.getStageName(stage), g_profiler.getAverageMs(stage),
+             g_profiler.getMaxMs(stage));
+    FontManager_printText(
+        line, FontOptions(Vec2(5.0f, 80.0f + i * 13.0F), Color(255), 0.6F));
+  }
+
+  if (g_profiler.isDumping())
+    FontManager_printText(
+        "Dumping " PROFILER_DUMP_FILE,
+        FontOptions(Vec2(5.0f, 80.0f + PROFILER_STAGES * 13.0F),
+                    Color(255, 255, 0), 0.6F));
 }
 
 void CreativePlayingState::printMemoryInfoToLog() {
@@ -190,6 +230,13 @@ void CreativePlayingState::printMemoryInfoToLog() {
               stateGamePlay->context->t_engine->info.getAvailableRAM()))
           .append(" MB");
   TYRA_LOG(freeRam.c_str());
+
+  std::string terrainRam =
+      std::string("Terrain: ")
+          .append(std::to_string(
+              GetMapMemoryUsage(stateGamePlay->world->terrain) / 1024))
+          .append(" KB");
+  TYRA_LOG(terrainRam.c_str());
 }
 
 void CreativePlayingState::playNewRandomSong() {
@@ -69,8 +69,6 @@ void StateLoadingSavedGame::update(const float& deltaTime) {
     this->nextState();
   }
 
-  std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
   if (this->shouldCreatedEntities) {
     return this->createEntities();
   } else if (this->shouldInitItemRepository) {
@@ -90,6 +88,13 @@ void StateLoadingSavedGame::render() {
   this->context->t_engine->renderer.renderer2D.render(loadingSlot);
   this->context->t_engine->renderer.renderer2D.render(loadingprogress);
   this->context->t_engine->renderer.renderer2D.render(loadingStateText);
+
+  if (!this->loadingPhase.empty()) {
+    FontManager_printText(
+        this->loadingPhase + "...",
+        FontOptions(Vec2(loadingSlot->position.x + 128, BASE_HEIGHT + 45),
+                    Color(200, 200, 200), 0.8F, TextAlignment::Center));
+  }
 }
 
 void StateLoadingSavedGame::unload() {
@@ -139,10 +144,23 @@ void StateLoadingSavedGame::initUI() {
 }
 
 void StateLoadingSavedGame::initWorld() {
-  this->stateGamePlay->world->init(&this->context->t_engine->renderer,
-                                   this->stateGamePlay->itemRepository,
-                                   this->context->t_soundManager);
-  setPercent(90.0F);
+  World* world = this->stateGamePlay->world;
+  if (!this->isWorldLoading) {
+    world->init(&this->context->t_engine->renderer,
+                this->stateGamePlay->itemRepository,
+                this->context->t_soundManager);
+    this->isWorldLoading = 1;
+    return;
+  }
+
+  // The terrain is generated over the frames, the bar goes from 50 to 90%
+  const u8 loaded = world->updateLoading(WORLD_LOADING_BUDGET_MS);
+  const WorldgenProgress progress = world->getLoadingProgress();
+  setPercent(50.0F + progress.progress * 40.0F);
+  this->loadingPhase = progress.phase ? progress.phase : "";
+  if (!loaded) return;
+
+  this->loadingPhase = "";
   this->shouldInitWorld = 0;
   TYRA_LOG("initWorld");
 }
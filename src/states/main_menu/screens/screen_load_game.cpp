@@ -1,5 +1,6 @@
 #include "states/main_menu/screens/screen_load_game.hpp"
 #include "states/main_menu/screens/screen_main.hpp"
+#include "managers/save_manager.hpp"
 
 ScreenLoadGame::ScreenLoadGame(StateMainMenu* t_context)
     : ScreenBase(t_context) {
@@ -173,6 +174,19 @@ void ScreenLoadGame::render() {
       FontManager_printText(item->title.c_str(), 173.0F, iconYPosition);
     }
 
+    if (item->hasInfo) {
+      std::string details = "Seed " + std::to_string(item->gameOptions.seed);
+      if (item->gameOptions.infiniteWorld)
+        details += " - Infinite";
+      else if (item->width)
+        details += " - " + std::to_string(item->width) + "x" +
+                   std::to_string(item->length);
+      if (!item->isTerrainSupported) details += " - Older version";
+      FontManager_printText(
+          details, FontOptions(Vec2(173.0F, iconYPosition + 18.0F),
+                               Color(160, 160, 160), 0.7F));
+    }
+
     t_renderer->renderer2D.render(item->icon);
   }
 
@@ -258,6 +272,7 @@ void ScreenLoadGame::loadAvailableSavesFromPath(const char* fullPath) {
       model->path = std::string(fullPath).append(dir.name);
       model->title = FileUtils::getFilenameWithoutExtension(dir.name);
       model->createdAt = dir.createdAt;
+      SaveManager::ReadSaveInfo(model->path.c_str(), model);
 
       model->icon.size.set(32, 32);
       model->icon.position.set(127, 146);
@@ -324,6 +339,12 @@ void ScreenLoadGame::selectNextSave() {
 }
 
 void ScreenLoadGame::loadSelectedSave() {
+  if (selectedSavedGame && !selectedSavedGame->isTerrainSupported) {
+    TYRA_ERROR("Save terrain is from another world generator: ",
+               selectedSavedGame->path.c_str());
+    return;
+  }
+
   if (selectedSavedGame) {
     return context->loadSavedGame(selectedSavedGame->path);
   }
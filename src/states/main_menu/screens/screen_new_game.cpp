@@ -105,27 +105,38 @@ void ScreenNewGame::render() {
     FontManager_printText("Seed: " + inputSeed, options);
   }
 
+  std::string worldTypeName;
   switch (this->model.type) {
     case WorldType::WORLD_TYPE_ORIGINAL:
-      FontManager_printText("World Type: Original", 130, 295);
+      worldTypeName = "Original";
       break;
     case WorldType::WORLD_TYPE_FLAT:
-      FontManager_printText("World Type: Flat", 150, 295);
+      worldTypeName = "Flat";
       break;
     case WorldType::WORLD_TYPE_ISLAND:
-      FontManager_printText("World Type: Island", 135, 295);
+      worldTypeName = "Island";
       break;
     case WorldType::WORLD_TYPE_WOODS:
-      FontManager_printText("World Type: Woods", 140, 295);
+      worldTypeName = "Woods";
       break;
     case WorldType::WORLD_TYPE_FLOATING:
-      FontManager_printText("World Type: Floating", 130, 295);
+      worldTypeName = "Floating";
       break;
 
     default:
       break;
   }
 
+  {
+    FontOptions options;
+    options.position = Vec2(242, 295);
+    options.alignment = TextAlignment::Center;
+    FontManager_printText(
+        (this->model.infiniteWorld ? "Infinite: " : "World Type: ") +
+            worldTypeName,
+        options);
+  }
+
   FontManager_printText("Create New World", 145, 332);
 
   if (isEditingSeed) {
@@ -163,6 +174,10 @@ void ScreenNewGame::render() {
         this->t_renderer->renderer2D.render(&btnCircle);
       } else if (activeOption == ScreenNewGameOptions::WorldName) {
         FontManager_printText("Edit", 35, 407);
+      } else if (activeOption == ScreenNewGameOptions::WorldType) {
+        FontManager_printText("Select", 35, 407);
+        FontManager_printText("Infinite", 285, 407);
+        this->t_renderer->renderer2D.render(&btnSquare);
       } else {
         FontManager_printText("Select", 35, 407);
       }
@@ -409,6 +424,10 @@ void ScreenNewGame::handleOptionsSelection() {
   } else if (clickedButtons.Circle &&
              activeOption == ScreenNewGameOptions::Seed) {
     inputSeed = getSeed();
+  } else if (clickedButtons.Square &&
+             activeOption == ScreenNewGameOptions::WorldType) {
+    this->context->playClickSound();
+    this->model.infiniteWorld = !this->model.infiniteWorld;
   }
 }
 
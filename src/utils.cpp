@@ -9,6 +9,7 @@
 */
 
 #include "utils.hpp"
+#include "constants.hpp"
 #include <fastmath.h>
 #include <physics/ray.hpp>
 #include <renderer/3d/bbox/bbox.hpp>
@@ -114,6 +115,11 @@ float Utils::Raycast(Vec4* origin, Vec4* dir, Vec4* min, Vec4* max) {
   return tmin;
 }
 
+int Utils::GetBlockOffsetFromPosition(const float& position) {
+  // Blocks are centered at offset * DUBLE_BLOCK_SIZE
+  return floor((position + BLOCK_SIZE) / DUBLE_BLOCK_SIZE);
+}
+
 void Utils::GetMinkowskiSum(const Vec4& AMin, const Vec4& AMax,
                             const Vec4& BMin, const Vec4& BMax, Vec4* resultMin,
                             Vec4* resultMax) {
@@ -0,0 +1,341 @@
+/**
+ * Host benchmark of the save formats, built without the Tyra engine. It
+ * builds synthetic maps of several sizes and edit densities, writes and reads
+ * their blocks the way SaveManager does, and prints for every map layout,
+ * format and codec:
+ *
+ *   save_bench [-r rounds]
+ *
+ * the output size, the write and read throughput in MB of cells per second
+ * and the peak bytes allocated while writing and reading, the sections read
+ * into sectioned maps included. Formats are the
+ * whole map (WriteMapBlocks) and the edited bricks of the saves
+ * (WriteMapEdits), codecs the LevelStreamCodec values. Exits with 1 when a
+ * map read back differs from the one written.
+ */
+
+#include <entities/level.hpp>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+typedef std::chrono::steady_clock BenchClock;
+
+// Bytes allocated through malloc, new included, and the peak since the last
+// resetPeak. glibc only
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+static size_t allocatedBytes = 0;
+static size_t peakBytes = 0;
+
+static void trackAllocation(void* pointer) {
+  if (!pointer) return;
+  allocatedBytes += malloc_usable_size(pointer);
+  if (allocatedBytes > peakBytes) peakBytes = allocatedBytes;
+}
+
+extern "C" void* malloc(size_t size) {
+  void* pointer = __libc_malloc(size);
+  trackAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  void* pointer = __libc_calloc(count, size);
+  trackAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+  const size_t previous = pointer ? malloc_usable_size(pointer) : 0;
+  void* result = __libc_realloc(pointer, size);
+  if (result || size == 0) {
+    allocatedBytes -= previous;
+    trackAllocation(result);
+  }
+  return result;
+}
+
+extern "C" void free(void* pointer) {
+  if (pointer) allocatedBytes -= malloc_usable_size(pointer);
+  __libc_free(pointer);
+}
+
+static size_t resetPeak() { return peakBytes = allocatedBytes; }
+
+typedef struct {
+  uint16_t width;
+  uint16_t length;
+  uint16_t height;
+} BenchSize;
+
+static const BenchSize sizes[] = {
+    {64, 64, 64}, {128, 128, 64}, {256, 256, 64}};
+
+// Share of the bricks the player edited
+static const float densities[] = {0.0F, 0.01F, 0.1F, 1.0F};
+
+typedef struct {
+  const char* name;
+  LevelMapLayout layout;
+} BenchLayout;
+
+static const BenchLayout layouts[] = {
+    {"linear", LEVEL_MAP_LAYOUT_LINEAR},
+    {"sectioned", LEVEL_MAP_LAYOUT_SECTIONED},
+};
+
+typedef struct {
+  const char* name;
+  LevelStreamCodec codec;
+} BenchCodec;
+
+static const BenchCodec codecs[] = {
+    {"plain", LEVEL_STREAM_PLAIN},
+    {"deflate", LEVEL_STREAM_DEFLATE},
+    {"lz", LEVEL_STREAM_LZ},
+};
+
+typedef enum { BENCH_FORMAT_BLOCKS, BENCH_FORMAT_EDITS } BenchFormat;
+
+static const char* formatNames[] = {"blocks", "edits"};
+
+static double elapsedMs(const BenchClock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(BenchClock::now() - start)
+      .count();
+}
+
+// Deterministic hash of a position, the synthetic maps are the same each run
+static uint32_t hashCell(uint32_t x, uint32_t y, uint32_t z, uint32_t salt) {
+  uint32_t hash = x * 0x8DA6B343u ^ y * 0xD8163841u ^ z * 0xCB1AB31Fu ^ salt;
+  hash ^= hash >> 15;
+  hash *= 0x2C1B3C6Du;
+  hash ^= hash >> 12;
+  return hash;
+}
+
+// Rolling terrain: stone, a few ores, dirt, grass and water under the sea
+// level, with the block ids of the game
+static void fillTerrain(LevelMap* map) {
+  const uint16_t seaLevel = map->height / 2;
+  for (uint16_t z = 0; z < map->width; z++)
+    for (uint16_t x = 0; x < map->length; x++) {
+      const uint16_t ground =
+          seaLevel - 4 + (uint16_t)(hashCell(x >> 4, 0, z >> 4, 1) % 9) +
+          (uint16_t)(hashCell(x >> 2, 0, z >> 2, 2) % 3);
+      for (uint16_t y = 0; y < map->height; y++) {
+        uint8_t block = 0;
+        if (y == 0)
+          block = 7;
+        else if (y < ground - 3)
+          block = hashCell(x, y, z, 3) % 64 == 0 ? 16 : 1;
+        else if (y < ground)
+          block = 3;
+        else if (y == ground)
+          block = ground < seaLevel ? 12 : 2;
+        else if (y <= seaLevel)
+          block = 8;
+        if (block) SetBlockInMap(map, x, y, z, block);
+      }
+    }
+}
+
+static void createMap(LevelMap* map, const BenchSize& size,
+                      LevelMapLayout layout) {
+  memset(map, 0, sizeof(LevelMap));
+  map->width = size.width;
+  map->length = size.length;
+  map->height = size.height;
+  map->layout = layout;
+  CreateMapStorage(map);
+  fillTerrain(map);
+  CompactMapSections(map);
+  CreateMapEdits(map);
+}
+
+// Places blocks in the given share of the bricks, 32 cells each
+static void editMap(LevelMap* map, float density) {
+  const uint32_t bricksX = map->width >> LEVEL_MAP_BRICK_SHIFT;
+  const uint32_t bricksZ = map->length >> LEVEL_MAP_BRICK_SHIFT;
+  const uint32_t bricksY = map->height >> LEVEL_MAP_BRICK_SHIFT;
+  const uint32_t threshold = (uint32_t)(density * 1000.0F);
+
+  for (uint32_t by = 0; by < bricksY; by++)
+    for (uint32_t bz = 0; bz < bricksZ; bz++)
+      for (uint32_t bx = 0; bx < bricksX; bx++) {
+        if (hashCell(bx, by, bz, 4) % 1000 >= threshold) continue;
+        for (uint32_t i = 0; i < 32; i++) {
+          const uint32_t cell = hashCell(bx, by, bz, 5 + i);
+          SetBlockInMap(
+              map, (bx << LEVEL_MAP_BRICK_SHIFT) + (cell & 7),
+              (by << LEVEL_MAP_BRICK_SHIFT) + ((cell >> 3) & 7),
+              (bz << LEVEL_MAP_BRICK_SHIFT) + ((cell >> 6) & 7),
+              (cell >> 9) % 4 == 0 ? 0 : 4 + (cell >> 11) % 4);
+        }
+      }
+}
+
+static uint32_t countEdits(LevelMap* map) {
+  const uint32_t bricks = (map->width * map->length * map->height) /
+                          LEVEL_SECTION_CELLS;
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < bricks; i++)
+    if (map->edits[i]) count++;
+  return count;
+}
+
+// FNV-1a of the cells in x, z, y order, the same for every map layout
+static uint32_t hashMap(LevelMap* map) {
+  uint32_t hash = 2166136261u;
+  for (uint16_t y = 0; y < map->height; y++)
+    for (uint16_t z = 0; z < map->width; z++)
+      for (uint16_t x = 0; x < map->length; x++) {
+        hash ^= GetBlockFromMap(map, x, y, z);
+        hash *= 16777619u;
+      }
+  return hash;
+}
+
+typedef struct {
+  long bytes;
+  double writeMs;
+  double readMs;
+  size_t writePeak;
+  size_t readPeak;
+  bool matches;
+} BenchResult;
+
+// Writes the map in the format and codec, then reads it into a map of the
+// same layout, the unedited terrain for edits. Best times of the rounds
+static BenchResult runCase(LevelMap* map, const BenchSize& size,
+                           LevelMapLayout layout, BenchFormat format,
+                           LevelStreamCodec codec, int rounds) {
+  BenchResult result = {0, 0.0, 0.0, 0, 0, true};
+  const uint32_t expected = hashMap(map);
+
+  for (int i = 0; i < rounds; i++) {
+    FILE* file = tmpfile();
+    if (!file) {
+      result.matches = false;
+      return result;
+    }
+
+    size_t base = resetPeak();
+    BenchClock::time_point start = BenchClock::now();
+    LevelStream stream;
+    bool written = OpenLevelStream(&stream, file, codec, true);
+    written = written && (format == BENCH_FORMAT_BLOCKS
+                              ? WriteMapBlocks(map, &stream)
+                              : WriteMapEdits(map, &stream));
+    written = CloseLevelStream(&stream) && written && fflush(file) == 0;
+    const double writeMs = elapsedMs(start);
+    const size_t writePeak = peakBytes - base;
+    result.bytes = ftell(file);
+
+    LevelMap target;
+    createMap(&target, size, layout);
+    rewind(file);
+
+    base = resetPeak();
+    start = BenchClock::now();
+    bool read = OpenLevelStream(&stream, file, codec, false);
+    read = read && (format == BENCH_FORMAT_BLOCKS
+                        ? ReadMapBlocks(&target, &stream)
+                        : ReadMapEdits(&target, &stream, nullptr, nullptr));
+    read = CloseLevelStream(&stream) && read;
+    const double readMs = elapsedMs(start);
+    const size_t readPeak = peakBytes - base;
+    fclose(file);
+
+    result.matches =
+        result.matches && written && read && hashMap(&target) == expected;
+    FreeMapStorage(&target);
+
+    if (i == 0 || writeMs < result.writeMs) result.writeMs = writeMs;
+    if (i == 0 || readMs < result.readMs) result.readMs = readMs;
+    if (writePeak > result.writePeak) result.writePeak = writePeak;
+    if (readPeak > result.readPeak) result.readPeak = readPeak;
+  }
+  return result;
+}
+
+static double megabytesPerSecond(double bytes, double ms) {
+  return ms > 0.0 ? bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+}
+
+static void usage(const char* program) {
+  fprintf(stderr, "usage: %s [-r rounds]\n", program);
+}
+
+int main(int argc, char** argv) {
+  int rounds = 3;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      rounds = atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (rounds < 1) rounds = 1;
+
+  printf("# best of %d rounds, MB/s of the cells written or read\n", rounds);
+  printf("# %-11s %-7s %-9s %-6s %-7s %9s %9s %9s %9s %9s\n", "size",
+         "edited", "layout", "format", "codec", "bytes", "write", "read",
+         "writePeak", "readPeak");
+
+  int failures = 0;
+  for (const BenchSize& size : sizes) {
+    for (const float density : densities) {
+      for (const BenchLayout& layout : layouts) {
+        LevelMap map;
+        createMap(&map, size, layout.layout);
+        editMap(&map, density);
+
+        const double mapCells = (double)size.width * size.length * size.height;
+        const double editedCells =
+            (double)countEdits(&map) * LEVEL_SECTION_CELLS;
+
+        for (int format = BENCH_FORMAT_BLOCKS; format <= BENCH_FORMAT_EDITS;
+             format++) {
+          // Every brick is edited at 100%, the same as the whole map
+          if (format == BENCH_FORMAT_BLOCKS && density > 0.0F) continue;
+
+          for (const BenchCodec& codec : codecs) {
+            const BenchResult result =
+                runCase(&map, size, layout.layout, (BenchFormat)format,
+                        codec.codec, rounds);
+            const double cells =
+                format == BENCH_FORMAT_BLOCKS ? mapCells : editedCells;
+            const std::string name = std::to_string(size.width) + "x" +
+                                     std::to_string(size.length) + "x" +
+                                     std::to_string(size.height);
+
+            printf("%-13s %6.0f%% %-9s %-6s %-7s %9ld %9.1f %9.1f %9zu %9zu\n",
+                   name.c_str(), density * 100.0F, layout.name,
+                   formatNames[format], codec.name, result.bytes,
+                   megabytesPerSecond(cells, result.writeMs),
+                   megabytesPerSecond(cells, result.readMs), result.writePeak,
+                   result.readPeak);
+
+            if (!result.matches) {
+              printf("# %s %s %s %s: read back differs\n", name.c_str(),
+                     layout.name, formatNames[format], codec.name);
+              failures++;
+            }
+          }
+        }
+        FreeMapStorage(&map);
+      }
+    }
+  }
+
+  if (failures) printf("# %d failures\n", failures);
+  return failures ? 1 : 0;
+}
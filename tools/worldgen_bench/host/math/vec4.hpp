@@ -0,0 +1,3 @@
+#pragma once
+
+// constants.hpp only names Vec4 in macros the generator does not use
@@ -0,0 +1,348 @@
+/**
+ * Host benchmark and determinism check of the world generator, built without
+ * the Tyra engine. For every world type and seed it generates the map at once
+ * and phase by phase, times both, and prints a hash of the cells:
+ *
+ *   worldgen_bench [-w workers] [-r rounds] [-c baseline] [seed...]
+ *
+ * Lines not starting with '#' are "<type> <seed> <hash>", a run redirected to
+ * a file is the baseline -c compares the next runs against. Seeds are the
+ * generator seed, the game seeds it with the first rand() of the world seed.
+ * It also edits a column, saves the edits and loads them over a new
+ * generation, the way a save is loaded, and compares the columns around it.
+ * Exits with 1 when the two generations differ, a hash left the baseline or
+ * the loaded edits do not give back the saved terrain.
+ */
+
+#include <managers/cross_craft_world_generator.hpp>
+#include <entities/level_stream.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock BenchClock;
+
+typedef struct {
+  const char* name;
+  WorldType type;
+  void (*generate)(LevelMap* map);
+} BenchWorld;
+
+static const BenchWorld worlds[] = {
+    {"original", WORLD_TYPE_ORIGINAL,
+     CrossCraft_WorldGenerator_Generate_Original},
+    {"flat", WORLD_TYPE_FLAT, CrossCraft_WorldGenerator_Generate_Flat},
+    {"island", WORLD_TYPE_ISLAND, CrossCraft_WorldGenerator_Generate_Island},
+    {"woods", WORLD_TYPE_WOODS, CrossCraft_WorldGenerator_Generate_Woods},
+    {"floating", WORLD_TYPE_FLOATING,
+     CrossCraft_WorldGenerator_Generate_Floating},
+};
+
+static const int32_t defaultSeeds[] = {0, 1, 12345, 987654321};
+
+typedef struct {
+  std::string world;
+  int32_t seed;
+  uint32_t hash;
+} BenchHash;
+
+typedef struct {
+  const char* name;
+  double ms;
+} BenchPhase;
+
+static double elapsedMs(const BenchClock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(BenchClock::now() - start)
+      .count();
+}
+
+// The map CrossCraft_World_Init and CrossCraft_World_Create_Map make
+static void createMap(LevelMap* map) {
+  memset(map, 0, sizeof(LevelMap));
+  map->length = OVERWORLD_H_DISTANCE;
+  map->width = OVERWORLD_H_DISTANCE;
+  map->height = OVERWORLD_V_DISTANCE;
+  map->spawnX = 128;
+  map->spawnY = 59;
+  map->spawnZ = 128;
+  map->layout = LEVEL_MAP_LAYOUT_LINEAR;
+  CreateMapStorage(map);
+}
+
+// FNV-1a of the cells in x, z, y order, the same for every map layout
+static uint32_t hashMap(LevelMap* map) {
+  uint32_t hash = 2166136261u;
+  for (uint16_t y = 0; y < map->height; y++)
+    for (uint16_t z = 0; z < map->width; z++)
+      for (uint16_t x = 0; x < map->length; x++) {
+        hash ^= GetBlockFromMap(map, x, y, z);
+        hash *= 16777619u;
+      }
+  return hash;
+}
+
+// Runs a job over the whole map one step at a time, adding the time of each
+// step to its phase
+static uint32_t generateByPhase(const BenchWorld* world,
+                                std::vector<BenchPhase>* phases) {
+  LevelMap map;
+  createMap(&map);
+
+  BenchClock::time_point start = BenchClock::now();
+  WorldgenMap* generator = CrossCraft_WorldGenerator_Begin(&map, world->type);
+  phases->push_back({"Staging", elapsedMs(start)});
+
+  WorldgenJob* job = CrossCraft_WorldGenerator_Begin_Job(
+      generator, 0, 0, map.length >> LEVEL_MAP_BRICK_SHIFT,
+      map.width >> LEVEL_MAP_BRICK_SHIFT);
+  bool done = false;
+  while (!done) {
+    const char* phase = CrossCraft_WorldGenerator_Get_Job_Progress(job).phase;
+    start = BenchClock::now();
+    done = CrossCraft_WorldGenerator_Run_Job(job, 0.0F);
+    const double ms = elapsedMs(start);
+
+    if (strcmp(phases->back().name, phase) != 0)
+      phases->push_back({phase, 0.0});
+    phases->back().ms += ms;
+  }
+  CrossCraft_WorldGenerator_End_Job(job);
+  CrossCraft_WorldGenerator_End(generator);
+
+  const uint32_t hash = hashMap(&map);
+  FreeMapStorage(&map);
+  return hash;
+}
+
+static uint32_t generateAtOnce(const BenchWorld* world, int rounds,
+                               double* bestMs) {
+  uint32_t hash = 0;
+  *bestMs = 0.0;
+  for (int i = 0; i < rounds; i++) {
+    LevelMap map;
+    createMap(&map);
+
+    const BenchClock::time_point start = BenchClock::now();
+    world->generate(&map);
+    const double ms = elapsedMs(start);
+    if (i == 0 || ms < *bestMs) *bestMs = ms;
+
+    hash = hashMap(&map);
+    FreeMapStorage(&map);
+  }
+  return hash;
+}
+
+// Cells of the columns [minX, maxX) x [minZ, maxZ) that differ
+static uint32_t compareColumns(LevelMap* map, LevelMap* other, uint16_t minX,
+                               uint16_t minZ, uint16_t maxX, uint16_t maxZ) {
+  uint32_t differences = 0;
+  for (uint16_t y = 0; y < map->height; y++)
+    for (uint16_t z = minZ << LEVEL_MAP_BRICK_SHIFT;
+         z < maxZ << LEVEL_MAP_BRICK_SHIFT; z++)
+      for (uint16_t x = minX << LEVEL_MAP_BRICK_SHIFT;
+           x < maxX << LEVEL_MAP_BRICK_SHIFT; x++)
+        if (GetBlockFromMap(map, x, y, z) != GetBlockFromMap(other, x, y, z))
+          differences++;
+  return differences;
+}
+
+// Clears the trees of the column and fills every other layer of its air with
+// glass, so the trees of the columns around have neither their space nor
+// their cells of it
+static void editColumn(LevelMap* map, uint16_t columnX, uint16_t columnZ) {
+  const uint8_t air = static_cast<uint8_t>(Blocks::AIR_BLOCK);
+  for (uint16_t y = 0; y < map->height; y++)
+    for (uint16_t z = 0; z < LEVEL_MAP_BRICK_SIZE; z++)
+      for (uint16_t x = 0; x < LEVEL_MAP_BRICK_SIZE; x++) {
+        const uint16_t cellX = (columnX << LEVEL_MAP_BRICK_SHIFT) + x;
+        const uint16_t cellZ = (columnZ << LEVEL_MAP_BRICK_SHIFT) + z;
+        const uint8_t block = GetBlockFromMap(map, cellX, y, cellZ);
+        if (block == static_cast<uint8_t>(Blocks::OAK_LEAVES_BLOCK) ||
+            block == static_cast<uint8_t>(Blocks::OAK_LOG_BLOCK))
+          SetBlockInMap(map, cellX, y, cellZ, air);
+        else if (block == air && (y & 1) == 0)
+          SetBlockInMap(map, cellX, y, cellZ,
+                        static_cast<uint8_t>(Blocks::GLASS_BLOCK));
+      }
+}
+
+// Edits the column in the middle of the map once its chunk could be built,
+// saves the edits while the columns around are still to generate, then
+// loads them over a new generator. Returns the cells of the columns around
+// the edited one that differ between the two.
+static uint32_t checkEditsReload(const BenchWorld* world) {
+  LevelMap map;
+  createMap(&map);
+  CreateMapEdits(&map);
+  const uint16_t columnX = (map.length >> LEVEL_MAP_BRICK_SHIFT) / 2;
+  const uint16_t columnZ = (map.width >> LEVEL_MAP_BRICK_SHIFT) / 2;
+
+  // World::buildChunk generates the columns around the chunk first
+  WorldgenMap* generator = CrossCraft_WorldGenerator_Begin(&map, world->type);
+  CrossCraft_WorldGenerator_Generate_Columns(generator, columnX - 1,
+                                             columnZ - 1, columnX + 2,
+                                             columnZ + 2);
+  editColumn(&map, columnX, columnZ);
+
+  FILE* file = tmpfile();
+  if (!file) {
+    CrossCraft_WorldGenerator_End(generator);
+    FreeMapStorage(&map);
+    return UINT32_MAX;
+  }
+  LevelStream stream;
+  bool saved = OpenLevelStream(&stream, file, LEVEL_STREAM_PLAIN, true) &&
+               WriteMapEdits(&map, &stream);
+  saved = CloseLevelStream(&stream) && saved;
+
+  // The player walks on, the columns around are generated after the edits
+  CrossCraft_WorldGenerator_Generate_Columns(generator, columnX - 2,
+                                             columnZ - 2, columnX + 3,
+                                             columnZ + 3);
+  CrossCraft_WorldGenerator_End(generator);
+
+  LevelMap loaded;
+  createMap(&loaded);
+  CreateMapEdits(&loaded);
+  generator = CrossCraft_WorldGenerator_Begin(&loaded, world->type);
+  rewind(file);
+  bool read = OpenLevelStream(&stream, file, LEVEL_STREAM_PLAIN, false) &&
+              ReadMapEdits(&loaded, &stream,
+                           CrossCraft_WorldGenerator_Load_Edited_Brick,
+                           generator);
+  read = CloseLevelStream(&stream) && read;
+  fclose(file);
+  CrossCraft_WorldGenerator_Generate_Columns(generator, columnX - 2,
+                                             columnZ - 2, columnX + 3,
+                                             columnZ + 3);
+  CrossCraft_WorldGenerator_End(generator);
+
+  const uint32_t differences =
+      saved && read
+          ? compareColumns(&map, &loaded, columnX - 2, columnZ - 2,
+                           columnX + 3, columnZ + 3)
+          : UINT32_MAX;
+  FreeMapStorage(&map);
+  FreeMapStorage(&loaded);
+  return differences;
+}
+
+static bool readBaseline(const char* path, std::vector<BenchHash>* baseline) {
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+
+  char line[256];
+  char world[64];
+  int32_t seed;
+  uint32_t hash;
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%63s %d %x", world, &seed, &hash) == 3)
+      baseline->push_back({world, seed, hash});
+  }
+  fclose(file);
+  return true;
+}
+
+static const BenchHash* findBaseline(const std::vector<BenchHash>& baseline,
+                                     const char* world, int32_t seed) {
+  for (const BenchHash& entry : baseline)
+    if (entry.world == world && entry.seed == seed) return &entry;
+  return nullptr;
+}
+
+static void usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [-w workers] [-r rounds] [-c baseline] [seed...]\n",
+          program);
+}
+
+int main(int argc, char** argv) {
+  int workers = WORLDGEN_DEFAULT_WORKERS;
+  int rounds = 3;
+  const char* baselinePath = nullptr;
+  std::vector<int32_t> seeds;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+      workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      rounds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      baselinePath = argv[++i];
+    } else if (argv[i][0] != '-' || (argv[i][1] >= '0' && argv[i][1] <= '9')) {
+      seeds.push_back(strtol(argv[i], nullptr, 10));
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (rounds < 1) rounds = 1;
+  if (seeds.empty())
+    seeds.assign(defaultSeeds,
+                 defaultSeeds + sizeof(defaultSeeds) / sizeof(int32_t));
+
+  std::vector<BenchHash> baseline;
+  if (baselinePath && !readBaseline(baselinePath, &baseline)) {
+    fprintf(stderr, "Can't read the baseline %s\n", baselinePath);
+    return 2;
+  }
+
+  CrossCraft_WorldGenerator_SetWorkers(workers);
+  printf("# %dx%dx%d cells, %d workers, best of %d rounds\n",
+         OVERWORLD_H_DISTANCE, OVERWORLD_H_DISTANCE, OVERWORLD_V_DISTANCE,
+         workers, rounds);
+
+  int failures = 0;
+  for (const BenchWorld& world : worlds) {
+    for (const int32_t seed : seeds) {
+      CrossCraft_WorldGenerator_Init(seed);
+
+      double atOnceMs;
+      const uint32_t hash = generateAtOnce(&world, rounds, &atOnceMs);
+      std::vector<BenchPhase> phases;
+      const uint32_t phasedHash = generateByPhase(&world, &phases);
+
+      printf("# %s %d: at once %.2f ms, by phase", world.name, seed,
+             atOnceMs);
+      for (const BenchPhase& phase : phases)
+        printf(" %s %.2f", phase.name, phase.ms);
+      printf(" ms\n");
+
+      if (phasedHash != hash) {
+        printf("# %s %d: by phase %08x differs from at once\n", world.name,
+               seed, phasedHash);
+        failures++;
+      }
+
+      const uint32_t differences = checkEditsReload(&world);
+      if (differences == UINT32_MAX) {
+        printf("# %s %d: edits could not be saved or loaded\n", world.name,
+               seed);
+        failures++;
+      } else if (differences) {
+        printf("# %s %d: loaded edits differ in %u cells\n", world.name, seed,
+               differences);
+        failures++;
+      }
+
+      const BenchHash* expected = findBaseline(baseline, world.name, seed);
+      if (baselinePath && !expected) {
+        printf("# %s %d: not in the baseline\n", world.name, seed);
+      } else if (expected && expected->hash != hash) {
+        printf("# %s %d: baseline was %08x\n", world.name, seed,
+               expected->hash);
+        failures++;
+      }
+
+      printf("%s %d %08x\n", world.name, seed, hash);
+    }
+  }
+
+  if (failures) printf("# %d failures\n", failures);
+  return failures ? 1 : 0;
+}